@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lru_cache.h"
+
+// Per-key cost of batched lookups and updates against the single-key API
+// looped over the same keys, on a cache far larger than the CPU caches so
+// that nearly every lookup misses in them.
+
+#define ENTRIES 2000000
+#define REQUESTS 200000
+
+static volatile unsigned long long sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned int next_random(unsigned int *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void run(LRUCache *cache, char (*keys)[24], int batch)
+{
+    char *batch_keys[128];
+    char *values[128];
+    char *out[128];
+    unsigned int state = 2463534242u;
+    int batches = REQUESTS / batch;
+
+    double loop_get = 0, mget = 0, loop_set = 0, mset = 0;
+    for (int b = 0; b < batches; b++)
+    {
+        for (int i = 0; i < batch; i++)
+        {
+            batch_keys[i] = keys[next_random(&state) % ENTRIES];
+            values[i] = "updated-value";
+        }
+
+        double start = now_ns();
+        for (int i = 0; i < batch; i++)
+        {
+            sink += (size_t)lru_cache_get(cache, batch_keys[i]);
+        }
+        loop_get += now_ns() - start;
+
+        // A fresh batch for each variant, so neither finds the other's keys cached
+        for (int i = 0; i < batch; i++)
+        {
+            batch_keys[i] = keys[next_random(&state) % ENTRIES];
+        }
+        start = now_ns();
+        sink += lru_cache_mget(cache, batch_keys, (size_t)batch, out);
+        mget += now_ns() - start;
+
+        for (int i = 0; i < batch; i++)
+        {
+            batch_keys[i] = keys[next_random(&state) % ENTRIES];
+        }
+        start = now_ns();
+        for (int i = 0; i < batch; i++)
+        {
+            lru_cache_set(cache, batch_keys[i], values[i]);
+        }
+        loop_set += now_ns() - start;
+
+        for (int i = 0; i < batch; i++)
+        {
+            batch_keys[i] = keys[next_random(&state) % ENTRIES];
+        }
+        start = now_ns();
+        lru_cache_mset(cache, batch_keys, values, (size_t)batch);
+        mset += now_ns() - start;
+    }
+
+    double n = (double)batches * batch;
+    printf("  %5d %12.1f %10.1f %12.1f %10.1f\n", batch, loop_get / n, mget / n, loop_set / n, mset / n);
+}
+
+int main(void)
+{
+    char (*keys)[24] = malloc((size_t)ENTRIES * 24);
+    if (!keys)
+    {
+        return 1;
+    }
+
+    LRUCache *cache = lru_cache_create(ENTRIES);
+    for (int i = 0; i < ENTRIES; i++)
+    {
+        snprintf(keys[i], 24, "user:%d", i);
+        lru_cache_set(cache, keys[i], "initial-value");
+    }
+
+    printf("batched vs looped access, ns per key (%d entries, all hits)\n", ENTRIES);
+    printf("  batch     loop get       mget     loop set       mset\n");
+    run(cache, keys, 20);
+    run(cache, keys, 50);
+    run(cache, keys, 100);
+
+    lru_cache_free(cache);
+    free(keys);
+    return 0;
+}
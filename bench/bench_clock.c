@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lru_cache.h"
+
+// Cost of each expiration clock on its own and on a cache hit, against the
+// time(NULL) call every get and set used to make.
+
+#define READS 10000000
+#define KEY_COUNT 4096
+#define GETS 10000000
+
+static volatile uint64_t sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_time_call(void)
+{
+    double start = now_ns();
+    for (int i = 0; i < READS; i++)
+    {
+        sink += (uint64_t)time(NULL);
+    }
+    printf("  %-18s %8.2f\n", "time(NULL)", (now_ns() - start) / READS);
+}
+
+static void bench_read(const char *name, lru_clock_t *clock)
+{
+    double start = now_ns();
+    for (int i = 0; i < READS; i++)
+    {
+        sink += lru_clock_now_ms(clock);
+    }
+    printf("  %-18s %8.2f\n", name, (now_ns() - start) / READS);
+}
+
+static void bench_get(const char *name, lru_clock_t *clock, char (*keys)[16])
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, KEY_COUNT);
+    config.clock = clock;
+    LRUCache *cache = lru_cache_create_with_config(&config);
+
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        lru_cache_set(cache, keys[i], "value");
+    }
+
+    double start = now_ns();
+    for (int i = 0; i < GETS; i++)
+    {
+        sink += (unsigned char)lru_cache_get(cache, keys[i & (KEY_COUNT - 1)])[0];
+    }
+    printf("  %-18s %8.2f\n", name, (now_ns() - start) / GETS);
+
+    lru_cache_free(cache);
+}
+
+int main(void)
+{
+    static char keys[KEY_COUNT][16];
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "key:%d", i);
+    }
+
+    lru_clock_t monotonic, coarse, cached, ticking;
+    lru_clock_init(&monotonic, LRU_CLOCK_MONOTONIC);
+    lru_clock_init(&coarse, LRU_CLOCK_MONOTONIC_COARSE);
+    lru_clock_init(&cached, LRU_CLOCK_CACHED);
+    lru_clock_init(&ticking, LRU_CLOCK_CACHED);
+    lru_clock_start_ticker(&ticking, 1);
+
+    printf("clock read            ns/read\n");
+    bench_time_call();
+    bench_read("monotonic", &monotonic);
+    bench_read("monotonic coarse", &coarse);
+    bench_read("cached (64 reads)", &cached);
+    bench_read("cached (ticker)", &ticking);
+
+    printf("\ncache get hit         ns/get\n");
+    bench_get("monotonic", &monotonic, keys);
+    bench_get("monotonic coarse", &coarse, keys);
+    bench_get("cached (64 reads)", &cached, keys);
+    bench_get("cached (ticker)", &ticking, keys);
+
+    lru_clock_destroy(&ticking);
+    return 0;
+}
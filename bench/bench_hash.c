@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_utils.h"
+
+// Compares the built-in hash functions on speed and on how evenly
+// sequential, structured keys spread over a power-of-two table.
+
+#define KEY_COUNT 65536
+#define TABLE_SIZE (KEY_COUNT * 2)
+#define ROUNDS 50
+
+static volatile uint64_t sink;
+
+// Read at runtime so the compiler cannot turn the division into a multiply
+static volatile size_t mapping_range = 1000003;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Builds keys of one length that differ only in a decimal counter
+static char *make_keys(size_t len)
+{
+    char *keys = malloc((size_t)KEY_COUNT * len);
+    char digits[32];
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        char *key = keys + (size_t)i * len;
+        memset(key, 'x', len);
+        int n = snprintf(digits, sizeof(digits), "user:%d", i);
+        memcpy(key, digits, (size_t)n < len ? (size_t)n : len);
+        if ((size_t)n > len)
+        {
+            // Short keys keep the low-order digits so they stay distinct
+            memcpy(key, digits + n - len, len);
+        }
+    }
+    return keys;
+}
+
+// Fraction of keys that land in an already occupied bucket
+static double collision_rate(const uint64_t *hashes, int use_fastrange)
+{
+    static unsigned char used[TABLE_SIZE];
+    memset(used, 0, sizeof(used));
+
+    int collisions = 0;
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        size_t bucket = use_fastrange ? hash_to_range(hashes[i], TABLE_SIZE)
+                                      : (size_t)(hashes[i] & (TABLE_SIZE - 1));
+        collisions += used[bucket];
+        used[bucket] = 1;
+    }
+    return (double)collisions / KEY_COUNT;
+}
+
+static void bench_function(const char *name, hash_fn_t fn, const char *keys, size_t len)
+{
+    static uint64_t hashes[KEY_COUNT];
+
+    double start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            sink += fn(keys + (size_t)i * len, len, (uint64_t)r);
+        }
+    }
+    double ns = (now_ns() - start) / ((double)ROUNDS * KEY_COUNT);
+
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        hashes[i] = fn(keys + (size_t)i * len, len, 0);
+    }
+
+    printf("  %-7s len %4zu: %7.2f ns/op  collisions mask %5.1f%%  fastrange %5.1f%%\n",
+           name, len, ns, 100.0 * collision_rate(hashes, 0), 100.0 * collision_rate(hashes, 1));
+}
+
+int main(void)
+{
+    static const size_t lengths[] = {8, 16, 32, 64, 128, 256};
+
+    printf("hash functions (%d keys into %d buckets, ideal collision rate ~21.3%%)\n",
+           KEY_COUNT, TABLE_SIZE);
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        char *keys = make_keys(lengths[i]);
+        bench_function("djb2", djb2_hash_seeded, keys, lengths[i]);
+        bench_function("wyhash", wyhash64, keys, lengths[i]);
+        free(keys);
+    }
+
+    // Index mapping: integer division versus multiply-shift
+    size_t range = mapping_range;
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    double start = now_ns();
+    for (int i = 0; i < 100000000; i++)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        sink += x % range;
+    }
+    double modulo_ns = (now_ns() - start) / 1e8;
+
+    start = now_ns();
+    for (int i = 0; i < 100000000; i++)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        sink += hash_to_range(x, range);
+    }
+    double fastrange_ns = (now_ns() - start) / 1e8;
+
+    printf("index mapping\n");
+    printf("  hash %% capacity: %5.2f ns/op\n", modulo_ns);
+    printf("  fastrange:       %5.2f ns/op\n", fastrange_ns);
+    return 0;
+}
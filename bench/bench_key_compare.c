@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lru_cache.h"
+#include "hash_utils.h"
+
+// Microbenchmark for the cost of matching and rehashing 40-200 byte keys.
+// Keys share a long common prefix, as tenant/namespace-qualified keys do, so
+// a plain strcmp has to walk most of the key before it finds a difference.
+
+#define KEY_COUNT 4096
+#define ROUNDS 2000
+#define GROWTH_ENTRIES 2000000
+
+static volatile unsigned long long sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_key(char *buf, int id)
+{
+    int len = 40 + (id * 37) % 161;
+    memset(buf, 'p', len);
+    memcpy(buf, "tenant:42:namespace:sessions:", 29);
+    // Put the distinguishing digits at the end of the key
+    snprintf(buf + len - 8, 9, "%08d", id);
+}
+
+// Slowest single set while the index grows to GROWTH_ENTRIES entries, and the
+// time of the resize call that shrinks it again: the rebuilds are spread over
+// later operations instead of stalling one caller
+static void bench_index_growth(void)
+{
+    LRUCache *cache = lru_cache_create(GROWTH_ENTRIES);
+    char key[32];
+    double worst = 0;
+    double start = now_ns();
+
+    for (int i = 0; i < GROWTH_ENTRIES; i++)
+    {
+        snprintf(key, sizeof(key), "growth:%d", i);
+        double before = now_ns();
+        lru_cache_set(cache, key, "value");
+        double elapsed = now_ns() - before;
+        if (elapsed > worst)
+        {
+            worst = elapsed;
+        }
+    }
+    double total = now_ns() - start;
+
+    start = now_ns();
+    lru_cache_resize_cache(cache, 1000);
+    double resize = now_ns() - start;
+
+    printf("index growth (%d entries)\n", GROWTH_ENTRIES);
+    printf("  mean set:                      %6.2f ns\n", total / GROWTH_ENTRIES);
+    printf("  slowest set:                   %6.2f us\n", worst / 1e3);
+    printf("  resize to 1000 (evictions):    %6.2f ms\n", resize / 1e6);
+
+    lru_cache_free(cache);
+}
+
+int main(void)
+{
+    static char keys[KEY_COUNT][208];
+    kv_pair_t *pairs[KEY_COUNT];
+
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        make_key(keys[i], i);
+        pairs[i] = kv_new_kv_pair(keys[i], strlen(keys[i]), djb2_hash(keys[i]), "value");
+    }
+
+    // Mismatching compares: probe key i against stored pair i+1
+    double start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            sink += kv_pair_matches_key(pairs[(i + 1) % KEY_COUNT], keys[i]);
+        }
+    }
+    double strcmp_ns = (now_ns() - start) / ((double)ROUNDS * KEY_COUNT);
+
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            kv_pair_t *pair = pairs[(i + 1) % KEY_COUNT];
+            sink += kv_pair_matches_hashed_key(pair, pairs[i]->hash, keys[i], pairs[i]->key_len);
+        }
+    }
+    double hashed_ns = (now_ns() - start) / ((double)ROUNDS * KEY_COUNT);
+
+    // Eviction and index rebuilds: recomputing the hash versus reading the cached one
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            sink += djb2_hash(pairs[i]->key);
+        }
+    }
+    double rehash_ns = (now_ns() - start) / ((double)ROUNDS * KEY_COUNT);
+
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            sink += pairs[i]->hash;
+        }
+    }
+    double cached_ns = (now_ns() - start) / ((double)ROUNDS * KEY_COUNT);
+
+    // End to end: hits on a cache holding every key
+    LRUCache *cache = lru_cache_create(KEY_COUNT);
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        lru_cache_set(cache, keys[i], "value");
+    }
+    start = now_ns();
+    for (int r = 0; r < ROUNDS / 10; r++)
+    {
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            sink += (unsigned long long)(size_t)lru_cache_get(cache, keys[(i * 7) % KEY_COUNT]);
+        }
+    }
+    double get_ns = (now_ns() - start) / ((double)(ROUNDS / 10) * KEY_COUNT);
+
+    printf("key compare (40-200 byte keys, shared prefix)\n");
+    printf("  mismatch via strcmp:           %6.2f ns\n", strcmp_ns);
+    printf("  mismatch via hash+len+memcmp:  %6.2f ns\n", hashed_ns);
+    printf("  rehash key on evict/resize:    %6.2f ns\n", rehash_ns);
+    printf("  read cached hash:              %6.2f ns\n", cached_ns);
+    printf("  lru_cache_get hit:             %6.2f ns\n", get_ns);
+
+    printf("\n");
+    bench_index_growth();
+
+    lru_cache_free(cache);
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        kv_free_kv_pair(pairs[i]);
+    }
+    return 0;
+}
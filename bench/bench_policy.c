@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lru_cache.h"
+
+// Hit ratio, cost per request and policy memory of every eviction policy on
+// two cache-aside traces: skewed reuse polluted by one-off scans, and a
+// workload alternating between recency-heavy and frequency-heavy phases.
+
+#define TRACE_LENGTH 2000000
+#define CAPACITY 10000
+#define KEY_LENGTH 24
+
+static volatile unsigned long long sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned int next_random(unsigned int *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// Half the requests reuse 20 * CAPACITY keys with a cubic skew; the other half scan
+static void make_scan_trace(char (*keys)[KEY_LENGTH])
+{
+    unsigned int state = 2463534242u;
+    unsigned long long range = 20ULL * CAPACITY;
+
+    for (int i = 0; i < TRACE_LENGTH; i++)
+    {
+        unsigned int r = next_random(&state);
+        if (r & 1)
+        {
+            unsigned long long u = (r >> 1) % range;
+            snprintf(keys[i], KEY_LENGTH, "reused:%llu", u * u * u / (range * range));
+        }
+        else
+        {
+            snprintf(keys[i], KEY_LENGTH, "scan:%d", i);
+        }
+    }
+}
+
+// Phases of recent-key reuse alternate with phases of a fixed hot set and one-off keys
+static void make_phase_trace(char (*keys)[KEY_LENGTH])
+{
+    unsigned int state = 88172645u;
+    int fresh = 0;
+    int phase_length = TRACE_LENGTH / 20;
+
+    for (int i = 0; i < TRACE_LENGTH; i++)
+    {
+        unsigned int r = next_random(&state);
+        if ((i / phase_length) % 2 == 0)
+        {
+            fresh += r % 4 == 0;
+            snprintf(keys[i], KEY_LENGTH, "fresh:%d", fresh - (int)((r >> 8) % (CAPACITY * 3 / 4)));
+        }
+        else if (r % 2 == 0)
+        {
+            snprintf(keys[i], KEY_LENGTH, "hot:%u", (r >> 8) % (CAPACITY * 3 / 4));
+        }
+        else
+        {
+            snprintf(keys[i], KEY_LENGTH, "once:%d", i);
+        }
+    }
+}
+
+static void run(const char *name, lru_policy_t policy, char (*keys)[KEY_LENGTH])
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, CAPACITY);
+    config.policy = policy;
+    LRUCache *cache = lru_cache_create_with_config(&config);
+
+    int hits = 0;
+    double start = now_ns();
+    for (int i = 0; i < TRACE_LENGTH; i++)
+    {
+        char *value = lru_cache_get(cache, keys[i]);
+        if (value)
+        {
+            hits++;
+            sink += (unsigned char)value[0];
+        }
+        else
+        {
+            lru_cache_set(cache, keys[i], "value-payload-0123456789");
+        }
+    }
+    double ns = (now_ns() - start) / TRACE_LENGTH;
+
+    size_t policy_bytes = policy_memory_usage(cache);
+    printf("  %-10s %8.2f%% %10.1f %12zu %10.1f\n", name, 100.0 * hits / TRACE_LENGTH, ns,
+           policy_bytes, (double)policy_bytes / CAPACITY);
+
+    lru_cache_free(cache);
+}
+
+static void run_all(const char *trace, char (*keys)[KEY_LENGTH])
+{
+    printf("%s (%d requests, capacity %d)\n", trace, TRACE_LENGTH, CAPACITY);
+    printf("  policy     hit ratio   ns/request  policy bytes  bytes/entry\n");
+    run("LRU", LRU_POLICY_LRU, keys);
+    run("CLOCK", LRU_POLICY_CLOCK, keys);
+    run("CLOCK-Pro", LRU_POLICY_CLOCK_PRO, keys);
+    run("W-TinyLFU", LRU_POLICY_TINYLFU, keys);
+    run("ARC", LRU_POLICY_ARC, keys);
+}
+
+int main(void)
+{
+    char (*keys)[KEY_LENGTH] = malloc((size_t)TRACE_LENGTH * KEY_LENGTH);
+    if (!keys)
+    {
+        return 1;
+    }
+
+    printf("every policy shares the %zu-byte node header; policy bytes are extra state\n\n",
+           sizeof(Node));
+
+    make_scan_trace(keys);
+    run_all("scan-polluted trace", keys);
+
+    printf("\n");
+    make_phase_trace(keys);
+    run_all("phase-shift trace", keys);
+
+    free(keys);
+    return 0;
+}
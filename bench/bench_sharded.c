@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "lru_cache.h"
+#include "sharded_lru.h"
+
+// Throughput of one LRUCache behind a global mutex versus the sharded front
+// end, from 1 to 64 threads, on a 90% get / 10% set mix. A second table runs a
+// read-heavy mix (99% gets, all hits) with and without lock-free reads.
+
+#define TOTAL_OPERATIONS 4000000
+#define KEY_SPACE 200000
+#define CAPACITY 100000
+#define SHARDS 64
+
+typedef struct
+{
+    LRUCache *global;
+    pthread_mutex_t *global_lock;
+    ShardedLRUCache *sharded;
+    int operations;
+    unsigned int seed;
+    unsigned int key_space;
+    unsigned int set_every; // One operation in this many is a set
+} worker_t;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *run_worker(void *arg)
+{
+    worker_t *w = arg;
+    unsigned int state = w->seed;
+    char key[32], buf[64];
+
+    for (int i = 0; i < w->operations; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        snprintf(key, sizeof(key), "key:%u", (state >> 4) % w->key_space);
+        int is_set = (state >> 24) % w->set_every == 0;
+
+        if (w->sharded)
+        {
+            if (is_set)
+            {
+                sharded_lru_set(w->sharded, key, "value-payload-0123456789");
+            }
+            else
+            {
+                sharded_lru_get(w->sharded, key, buf, sizeof(buf));
+            }
+        }
+        else
+        {
+            pthread_mutex_lock(w->global_lock);
+            if (is_set)
+            {
+                lru_cache_set(w->global, key, "value-payload-0123456789");
+            }
+            else
+            {
+                char *value = lru_cache_get(w->global, key);
+                if (value)
+                {
+                    strncpy(buf, value, sizeof(buf) - 1);
+                }
+            }
+            pthread_mutex_unlock(w->global_lock);
+        }
+    }
+
+    return NULL;
+}
+
+// Runs the mix on the given threads and returns millions of operations per second
+static double run(int threads, LRUCache *global, pthread_mutex_t *lock, ShardedLRUCache *sharded,
+                  unsigned int key_space, unsigned int set_every)
+{
+    pthread_t ids[64];
+    worker_t workers[64];
+
+    double start = now_ns();
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i] = (worker_t){global, lock, sharded, TOTAL_OPERATIONS / threads,
+                                (unsigned int)i * 7919u + 1, key_space, set_every};
+        pthread_create(&ids[i], NULL, run_worker, &workers[i]);
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+    }
+    double seconds = (now_ns() - start) / 1e9;
+
+    return (double)(TOTAL_OPERATIONS / threads * threads) / seconds / 1e6;
+}
+
+int main(void)
+{
+    static const int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    char key[32];
+
+    LRUCache *global = lru_cache_create(CAPACITY);
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    ShardedLRUCache *sharded = sharded_lru_create(SHARDS, CAPACITY);
+
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, CAPACITY);
+    ShardedLRUCache *lockfree = sharded_lru_create_with_flags(SHARDS, &config, SHARDED_LRU_LOCKFREE_READS);
+
+    // Warm the caches so the get mix sees realistic hit rates
+    for (int i = 0; i < CAPACITY; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        lru_cache_set(global, key, "value-payload-0123456789");
+        sharded_lru_set(sharded, key, "value-payload-0123456789");
+        sharded_lru_set(lockfree, key, "value-payload-0123456789");
+    }
+
+    printf("sharded throughput (%d ops, 90%% get, %d shards)\n", TOTAL_OPERATIONS, SHARDS);
+    printf("  threads   global mutex Mops/s   sharded Mops/s\n");
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++)
+    {
+        int threads = thread_counts[i];
+        double global_mops = run(threads, global, &lock, NULL, KEY_SPACE, 10);
+        double sharded_mops = run(threads, NULL, NULL, sharded, KEY_SPACE, 10);
+        printf("  %7d   %19.2f   %14.2f\n", threads, global_mops, sharded_mops);
+    }
+
+    // Refill after the mixed runs evicted part of the key space
+    for (int i = 0; i < CAPACITY; i++)
+    {
+        snprintf(key, sizeof(key), "key:%d", i);
+        sharded_lru_set(sharded, key, "value-payload-0123456789");
+    }
+
+    printf("\nread-heavy throughput (%d ops, 99%% get, all hits, %d shards)\n", TOTAL_OPERATIONS, SHARDS);
+    printf("  threads   locked reads Mops/s   lock-free reads Mops/s\n");
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++)
+    {
+        int threads = thread_counts[i];
+        double locked_mops = run(threads, NULL, NULL, sharded, CAPACITY, 100);
+        double lockfree_mops = run(threads, NULL, NULL, lockfree, CAPACITY, 100);
+        printf("  %7d   %19.2f   %22.2f\n", threads, locked_mops, lockfree_mops);
+    }
+
+    lru_cache_free(global);
+    sharded_lru_free(sharded);
+    sharded_lru_free(lockfree);
+    return 0;
+}
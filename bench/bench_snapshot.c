@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "lru_cache.h"
+
+// Time to save and reload a full cache against refilling it with sets,
+// reported alongside the snapshot's size so load speed can be compared
+// with the disk's sequential read rate.
+
+#define ENTRIES 1000000
+#define VALUE_SIZE 100
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/bench_snapshot_%d", (int)getpid());
+
+    char key[32], value[VALUE_SIZE + 1];
+    memset(value, 'v', VALUE_SIZE);
+    value[VALUE_SIZE] = '\0';
+
+    double start = now_ns();
+    LRUCache *cache = lru_cache_create(ENTRIES);
+    for (int i = 0; i < ENTRIES; i++)
+    {
+        snprintf(key, sizeof(key), "user:%d", i);
+        lru_cache_set(cache, key, value);
+    }
+    double fill_ms = (now_ns() - start) / 1e6;
+
+    start = now_ns();
+    if (!lru_cache_save(cache, path))
+    {
+        return 1;
+    }
+    double save_ms = (now_ns() - start) / 1e6;
+
+    struct stat st;
+    stat(path, &st);
+    double mb = (double)st.st_size / (1024 * 1024);
+
+    start = now_ns();
+    LRUCache *loaded = lru_cache_load(path);
+    double load_ms = (now_ns() - start) / 1e6;
+    if (!loaded || loaded->size != cache->size)
+    {
+        return 1;
+    }
+
+    printf("snapshot of %d entries, %d-byte values (%.1f MiB)\n", ENTRIES, VALUE_SIZE, mb);
+    printf("  %-22s %10.1f ms\n", "fill with sets", fill_ms);
+    printf("  %-22s %10.1f ms %8.0f MiB/s\n", "save", save_ms, mb / (save_ms / 1e3));
+    printf("  %-22s %10.1f ms %8.0f MiB/s\n", "load (page cache)", load_ms, mb / (load_ms / 1e3));
+
+    lru_cache_free(cache);
+    lru_cache_free(loaded);
+    unlink(path);
+    return 0;
+}
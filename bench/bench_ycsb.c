@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "lru_cache.h"
+
+// YCSB-style workloads against lru_cache_get/lru_cache_set at several
+// capacities and record shapes. Each run reports throughput, hit ratio and
+// latency percentiles from a log-linear histogram, printed as a table and
+// written as JSON (to the path given as the first argument, by default
+// build/bench_ycsb.json) so results can be compared between versions.
+//
+// Reads are cache-aside: a miss is followed by a set of the key. Updates
+// are plain sets. Operation traces are generated before the timed loop, and
+// each operation is timed on its own, so latencies include the cost of one
+// clock read, reported as timer_overhead_ns.
+
+#define KEYSPACE 1000000
+#define OPERATIONS 1000000
+#define ZIPF_THETA 0.99
+#define SCAN_LENGTH 64
+
+// The histogram keeps 2^HIST_SUB_BITS linear buckets per power of two, so
+// a recorded value is within 1/128 of the true one
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_SHIFT 40
+#define HIST_BUCKETS ((HIST_MAX_SHIFT + 2) * HIST_SUB_COUNT)
+
+typedef enum
+{
+    DIST_ZIPFIAN,
+    DIST_UNIFORM
+} distribution_t;
+
+typedef struct
+{
+    const char *name;
+    distribution_t distribution;
+    int read_percent;  // The rest are updates
+    int scan_percent;  // Operations that start a scan of SCAN_LENGTH one-off keys
+} workload_t;
+
+typedef struct
+{
+    int key_size;
+    int value_size;
+} record_shape_t;
+
+typedef struct
+{
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+    double sum;
+} histogram_t;
+
+// One operation of a trace: the key and whether it is a read
+typedef struct
+{
+    uint32_t key;
+    uint32_t read;
+} operation_t;
+
+static const workload_t workloads[] = {
+    {"ycsb-a", DIST_ZIPFIAN, 50, 0},      // Update heavy
+    {"ycsb-b", DIST_ZIPFIAN, 95, 0},      // Read mostly
+    {"ycsb-c", DIST_ZIPFIAN, 100, 0},     // Read only
+    {"uniform-b", DIST_UNIFORM, 95, 0},   // Read mostly, no skew
+    {"write-heavy", DIST_ZIPFIAN, 10, 0}, // Mostly sets
+    {"scan-mixed", DIST_ZIPFIAN, 95, 2},  // Read mostly with one-off scans
+};
+
+static const int capacities[] = {10000, 100000};
+
+static const record_shape_t shapes[] = {
+    {16, 100},
+    {64, 1000},
+};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Uniform double in [0, 1)
+static double next_unit(uint64_t *state)
+{
+    return (double)(next_random(state) >> 11) / (double)(1ULL << 53);
+}
+
+// Bucket index of a value: exact below HIST_SUB_COUNT, then HIST_SUB_COUNT
+// buckets per power of two
+static int hist_index(uint64_t value)
+{
+    if (value < HIST_SUB_COUNT)
+    {
+        return (int)value;
+    }
+
+    int shift = 63 - __builtin_clzll(value) - HIST_SUB_BITS;
+    if (shift > HIST_MAX_SHIFT)
+    {
+        return HIST_BUCKETS - 1;
+    }
+    return shift * HIST_SUB_COUNT + (int)(value >> shift);
+}
+
+// Largest value that falls in a bucket
+static uint64_t hist_bucket_top(int index)
+{
+    if (index < 2 * HIST_SUB_COUNT)
+    {
+        return (uint64_t)index;
+    }
+
+    int shift = index / HIST_SUB_COUNT - 1;
+    uint64_t sub = (uint64_t)(index % HIST_SUB_COUNT + HIST_SUB_COUNT);
+    return ((sub + 1) << shift) - 1;
+}
+
+static void hist_record(histogram_t *hist, uint64_t value)
+{
+    hist->counts[hist_index(value)]++;
+    hist->total++;
+    hist->sum += (double)value;
+    if (value > hist->max)
+    {
+        hist->max = value;
+    }
+}
+
+// Smallest recorded bucket at or below which a fraction of the values fall
+static uint64_t hist_percentile(const histogram_t *hist, double fraction)
+{
+    uint64_t rank = (uint64_t)ceil(fraction * (double)hist->total);
+    uint64_t seen = 0;
+
+    for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += hist->counts[i];
+        if (seen >= rank && seen > 0)
+        {
+            uint64_t top = hist_bucket_top(i);
+            return top < hist->max ? top : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+// Zipfian generator after Gray et al., as used by YCSB: item 0 is the most
+// popular. zeta(n) is computed once for the keyspace.
+typedef struct
+{
+    double alpha;
+    double zetan;
+    double eta;
+    double half_pow_theta;
+} zipfian_t;
+
+static void zipfian_init(zipfian_t *zipf, uint64_t n, double theta)
+{
+    double zeta2 = 1.0 + pow(0.5, theta);
+    zipf->zetan = 0;
+    for (uint64_t i = 1; i <= n; i++)
+    {
+        zipf->zetan += 1.0 / pow((double)i, theta);
+    }
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->eta = (1.0 - pow(2.0 / (double)n, 1.0 - theta)) / (1.0 - zeta2 / zipf->zetan);
+    zipf->half_pow_theta = 1.0 + pow(0.5, theta);
+}
+
+static uint32_t zipfian_next(const zipfian_t *zipf, uint64_t *state)
+{
+    double u = next_unit(state);
+    double uz = u * zipf->zetan;
+    if (uz < 1.0)
+    {
+        return 0;
+    }
+    if (uz < zipf->half_pow_theta)
+    {
+        return 1;
+    }
+
+    uint64_t item = (uint64_t)((double)KEYSPACE * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+    return item < KEYSPACE ? (uint32_t)item : KEYSPACE - 1;
+}
+
+// Spreads popular item numbers over the keyspace, as YCSB's scrambled
+// zipfian does, so the hot keys are not also the first keys loaded
+static uint32_t scramble(uint32_t item)
+{
+    uint64_t x = (uint64_t)item * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)((x >> 32) % KEYSPACE);
+}
+
+// Builds an operation trace; scans read keys beyond the keyspace that no
+// other operation touches
+static void make_trace(const workload_t *workload, const zipfian_t *zipf, operation_t *trace)
+{
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    uint32_t scan_key = KEYSPACE;
+
+    for (int i = 0; i < OPERATIONS; i++)
+    {
+        uint32_t roll = (uint32_t)(next_random(&state) % 100);
+        if ((int)roll < workload->scan_percent)
+        {
+            for (int j = 0; j < SCAN_LENGTH && i < OPERATIONS; j++, i++)
+            {
+                trace[i] = (operation_t){scan_key++, 1};
+            }
+            i--;
+            continue;
+        }
+
+        uint32_t key = workload->distribution == DIST_ZIPFIAN ? scramble(zipfian_next(zipf, &state))
+                                                              : (uint32_t)(next_random(&state) % KEYSPACE);
+        trace[i] = (operation_t){key, (next_random(&state) % 100) < (uint64_t)workload->read_percent};
+    }
+}
+
+// Fixed-width keys for every key number a trace can hold
+static char *make_keys(int key_size)
+{
+    size_t count = (size_t)KEYSPACE + OPERATIONS;
+    char *keys = malloc(count * (size_t)key_size);
+    if (!keys)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        snprintf(keys + i * (size_t)key_size, (size_t)key_size, "user%0*zu", key_size - 5, i);
+    }
+    return keys;
+}
+
+typedef struct
+{
+    double throughput;
+    double hit_ratio;
+    double mean_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} result_t;
+
+// Preloads the cache to capacity with the most popular keys of the trace's
+// distribution, then replays the trace
+static void run(const operation_t *trace, char *keys, const record_shape_t *shape, int capacity, char *value,
+                histogram_t *hist, result_t *result)
+{
+    LRUCache *cache = lru_cache_create(capacity);
+    for (int i = 0; i < capacity; i++)
+    {
+        lru_cache_set(cache, keys + (size_t)scramble((uint32_t)i) * (size_t)shape->key_size, value);
+    }
+
+    memset(hist, 0, sizeof(*hist));
+    uint64_t reads = 0, hits = 0;
+
+    double start = now_ns();
+    double last = start;
+    for (int i = 0; i < OPERATIONS; i++)
+    {
+        char *key = keys + (size_t)trace[i].key * (size_t)shape->key_size;
+        if (trace[i].read)
+        {
+            reads++;
+            if (lru_cache_get(cache, key))
+            {
+                hits++;
+            }
+            else
+            {
+                lru_cache_set(cache, key, value);
+            }
+        }
+        else
+        {
+            lru_cache_set(cache, key, value);
+        }
+
+        double now = now_ns();
+        hist_record(hist, (uint64_t)(now - last));
+        last = now;
+    }
+    double elapsed = last - start;
+
+    result->throughput = OPERATIONS / (elapsed / 1e9);
+    result->hit_ratio = reads ? (double)hits / (double)reads : 0;
+    result->mean_ns = hist->sum / (double)hist->total;
+    result->p50_ns = hist_percentile(hist, 0.50);
+    result->p99_ns = hist_percentile(hist, 0.99);
+    result->p999_ns = hist_percentile(hist, 0.999);
+    result->max_ns = hist->max;
+
+    lru_cache_free(cache);
+}
+
+// Cost of the clock read that separates two timed operations
+static double timer_overhead_ns(void)
+{
+    double start = now_ns();
+    for (int i = 0; i < 1000000; i++)
+    {
+        now_ns();
+    }
+    return (now_ns() - start) / 1000000;
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_path = argc > 1 ? argv[1] : "build/bench_ycsb.json";
+    FILE *json = fopen(json_path, "w");
+    if (!json)
+    {
+        fprintf(stderr, "cannot write %s\n", json_path);
+        return 1;
+    }
+
+    operation_t *trace = malloc(OPERATIONS * sizeof(operation_t));
+    histogram_t *hist = malloc(sizeof(histogram_t));
+    if (!trace || !hist)
+    {
+        return 1;
+    }
+
+    zipfian_t zipf;
+    zipfian_init(&zipf, KEYSPACE, ZIPF_THETA);
+    double overhead = timer_overhead_ns();
+
+    fprintf(json, "{\n  \"benchmark\": \"ycsb\",\n  \"keyspace\": %d,\n  \"operations\": %d,\n", KEYSPACE,
+            OPERATIONS);
+    fprintf(json, "  \"zipf_theta\": %.2f,\n  \"timer_overhead_ns\": %.1f,\n  \"results\": [", ZIPF_THETA,
+            overhead);
+
+    printf("YCSB-style workloads (%d keys, %d operations per run, timer overhead %.1f ns)\n", KEYSPACE,
+           OPERATIONS, overhead);
+    printf("  %-12s %8s %5s %6s %12s %8s %7s %7s %7s %9s\n", "workload", "capacity", "key", "value", "ops/s",
+           "hit %", "p50", "p99", "p99.9", "max (ns)");
+
+    int first = 1;
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++)
+    {
+        const record_shape_t *shape = &shapes[s];
+        char *keys = make_keys(shape->key_size);
+        char *value = malloc((size_t)shape->value_size + 1);
+        if (!keys || !value)
+        {
+            return 1;
+        }
+        memset(value, 'v', (size_t)shape->value_size);
+        value[shape->value_size] = '\0';
+
+        for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++)
+        {
+            const workload_t *workload = &workloads[w];
+            make_trace(workload, &zipf, trace);
+
+            for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++)
+            {
+                result_t result;
+                run(trace, keys, shape, capacities[c], value, hist, &result);
+
+                printf("  %-12s %8d %5d %6d %12.0f %7.2f%% %7llu %7llu %7llu %9llu\n", workload->name,
+                       capacities[c], shape->key_size, shape->value_size, result.throughput,
+                       100.0 * result.hit_ratio, (unsigned long long)result.p50_ns,
+                       (unsigned long long)result.p99_ns, (unsigned long long)result.p999_ns,
+                       (unsigned long long)result.max_ns);
+
+                fprintf(json, "%s\n    {\"workload\": \"%s\", \"distribution\": \"%s\", \"read_percent\": %d, ",
+                        first ? "" : ",", workload->name,
+                        workload->distribution == DIST_ZIPFIAN ? "zipfian" : "uniform", workload->read_percent);
+                fprintf(json, "\"scan_percent\": %d, \"capacity\": %d, \"key_size\": %d, \"value_size\": %d, ",
+                        workload->scan_percent, capacities[c], shape->key_size, shape->value_size);
+                fprintf(json, "\"throughput_ops\": %.0f, \"hit_ratio\": %.4f, \"mean_ns\": %.1f, ",
+                        result.throughput, result.hit_ratio, result.mean_ns);
+                fprintf(json, "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}",
+                        (unsigned long long)result.p50_ns, (unsigned long long)result.p99_ns,
+                        (unsigned long long)result.p999_ns, (unsigned long long)result.max_ns);
+                first = 0;
+            }
+        }
+
+        free(keys);
+        free(value);
+    }
+
+    fprintf(json, "\n  ]\n}\n");
+    fclose(json);
+    printf("results written to %s\n", json_path);
+
+    free(trace);
+    free(hist);
+    return 0;
+}
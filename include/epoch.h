@@ -0,0 +1,46 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdint.h>
+
+// Maximum number of threads that may be inside an epoch at once
+#define EPOCH_MAX_THREADS 256
+
+// Per-thread announcement: 0 when outside any read section, otherwise the
+// global epoch the thread observed on entry. Padded to a cache line so
+// readers never write to a line another reader is using.
+typedef struct epoch_slot
+{
+    uint64_t epoch;
+} __attribute__((aligned(64))) epoch_slot_t;
+
+// Epoch-based reclamation domain. Readers bracket lock-free accesses with
+// epoch_enter/epoch_exit; writers stamp unlinked objects with the current
+// epoch and may free them once every reader still inside a read section
+// entered at a later epoch, i.e. once nobody can still hold a reference.
+typedef struct epoch_domain
+{
+    uint64_t global_epoch;
+    epoch_slot_t slots[EPOCH_MAX_THREADS];
+} epoch_domain_t;
+
+// Initialise a domain with no active readers
+extern void epoch_init(epoch_domain_t *domain);
+
+// Small per-thread id used to pick an announcement slot; released when the thread exits
+extern int epoch_thread_id(void);
+
+// Start a read section for the calling thread
+extern void epoch_enter(epoch_domain_t *domain, int thread_id);
+
+// End a read section for the calling thread
+extern void epoch_exit(epoch_domain_t *domain, int thread_id);
+
+// Epoch to stamp an object with when it is unlinked
+extern uint64_t epoch_current(epoch_domain_t *domain);
+
+// Advance the global epoch if possible and return the oldest epoch still in
+// use; objects stamped with an earlier epoch can be freed
+extern uint64_t epoch_reclaim_bound(epoch_domain_t *domain);
+
+#endif // EPOCH_H
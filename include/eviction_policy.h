@@ -0,0 +1,94 @@
+#ifndef EVICTION_POLICY_H
+#define EVICTION_POLICY_H
+
+#include "node_utils.h"
+#include "frequency_sketch.h"
+
+struct LRUCache;
+
+// How a cache chooses which entry to evict
+typedef enum lru_policy
+{
+    LRU_POLICY_LRU = 0, // Exact recency order; every hit relinks the entry
+    LRU_POLICY_CLOCK,   // A hit sets a reference bit; a hand gives referenced entries a second chance
+    LRU_POLICY_CLOCK_PRO, // CLOCK with hot and cold entries and a memory of evicted cold keys, for scan resistance
+    LRU_POLICY_TINYLFU,   // W-TinyLFU: an admission window in front of a segmented LRU guarded by a frequency sketch
+    LRU_POLICY_ARC        // ARC: recency and frequency lists whose balance adapts to hits on evicted keys
+} lru_policy_t;
+
+// Node policy_flags bits
+#define NODE_REFERENCED 0x1 // Hit since the hand last passed
+#define NODE_HOT 0x2        // CLOCK-Pro: reused within its test period
+#define NODE_SEGMENT_SHIFT 2
+#define NODE_SEGMENT_MASK 0xC // Which of the cache's lists holds the entry
+
+// Number of entry lists a cache keeps: its main list plus the extra
+// segments used by segmented policies
+#define LRU_POLICY_LISTS 3
+
+// CLOCK-Pro lists: hot entries on the main list, cold ones on their own
+#define CLOCK_PRO_HOT 0
+#define CLOCK_PRO_COLD 1
+
+// W-TinyLFU segments: new entries enter the window, entries admitted to the
+// main region start on probation (the cache's main list) and move to the
+// protected segment when hit again
+#define TINYLFU_PROBATION 0
+#define TINYLFU_WINDOW 1
+#define TINYLFU_PROTECTED 2
+
+// ARC lists: T1 holds entries seen once recently (the cache's main list),
+// T2 entries seen at least twice
+#define ARC_T1 0
+#define ARC_T2 1
+
+// Where ARC found a key that is about to be inserted
+#define ARC_GHOST_NONE 0
+#define ARC_GHOST_B1 1 // Recently evicted from T1
+#define ARC_GHOST_B2 2 // Recently evicted from T2
+
+// Share of the capacity given to the W-TinyLFU window and, of the rest, to
+// the protected segment
+#define TINYLFU_WINDOW_PERCENT 1
+#define TINYLFU_PROTECTED_PERCENT 80
+
+// Set up the policy's state in the cache; returns 0 on failure
+extern int policy_init(struct LRUCache *cache, lru_policy_t policy);
+
+// Release the policy's state
+extern void policy_destroy(struct LRUCache *cache);
+
+// One of the cache's LRU_POLICY_LISTS entry lists; list 0 is cache->list
+extern node_list_t *policy_list(struct LRUCache *cache, int segment);
+
+// Bytes of policy state beyond the entries themselves
+extern size_t policy_memory_usage(struct LRUCache *cache);
+
+// Announce the hash of a new key before room is made for it
+extern void policy_before_insert(struct LRUCache *cache, uint64_t hash);
+
+// Link a new entry into the policy's order
+extern void policy_on_insert(struct LRUCache *cache, Node *node);
+
+// Undo policy_before_insert for an entry that was not stored after all
+extern void policy_abort_insert(struct LRUCache *cache);
+
+// Link an entry restored from a snapshot behind every entry already on its
+// list, keeping the policy flags it was saved with; a segment of -1, or one
+// the policy does not use, puts it on the list new entries start on
+extern void policy_on_restore(struct LRUCache *cache, Node *node, int segment, uint8_t flags);
+
+// Record a hit on an entry
+extern void policy_on_hit(struct LRUCache *cache, Node *node);
+
+// Unlink an entry that is leaving the cache for any reason
+extern void policy_on_remove(struct LRUCache *cache, Node *node);
+
+// Put a new copy of an entry in the old one's place
+extern void policy_on_replace(struct LRUCache *cache, Node *old_node, Node *new_node);
+
+// Choose the next entry to evict, never picking keep; returns NULL if there
+// is none. The caller must remove the entry it is given.
+extern Node *policy_victim(struct LRUCache *cache, Node *keep);
+
+#endif // EVICTION_POLICY_H
@@ -0,0 +1,39 @@
+#ifndef FREQUENCY_SKETCH_H
+#define FREQUENCY_SKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Count-min sketch of 4-bit counters used to estimate how often a key has
+// been seen recently. Each 64-bit word packs sixteen counters and a key
+// updates one counter in each of four words. After a sample of ten
+// additions per tracked entry every counter is halved, so old popularity
+// fades instead of pinning entries forever.
+typedef struct frequency_sketch
+{
+    uint64_t *table;
+    size_t mask;        // Words in table minus one; the table size is a power of two
+    size_t sample_size; // Additions between agings
+    size_t additions;
+    size_t capacity;    // Entries the sketch was sized for
+} frequency_sketch_t;
+
+// Maximum value of a counter
+#define SKETCH_MAX_COUNT 15
+
+// Size a sketch for the given number of entries; returns 0 on allocation failure
+extern int sketch_init(frequency_sketch_t *sketch, size_t capacity);
+
+// Release the sketch's memory
+extern void sketch_destroy(frequency_sketch_t *sketch);
+
+// Record one occurrence of a key hash, aging the sketch when the sample is full
+extern void sketch_increment(frequency_sketch_t *sketch, uint64_t hash);
+
+// Estimated number of recent occurrences, 0 to SKETCH_MAX_COUNT
+extern int sketch_estimate(frequency_sketch_t *sketch, uint64_t hash);
+
+// Resize the sketch for more entries, clearing its counts; returns 0 on failure
+extern int sketch_ensure_capacity(frequency_sketch_t *sketch, size_t capacity);
+
+#endif // FREQUENCY_SKETCH_H
@@ -0,0 +1,54 @@
+#ifndef GHOST_LIST_H
+#define GHOST_LIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded FIFO of the hashes of recently evicted keys. Eviction policies use
+// it to recognise a key that comes back soon after it was dropped without
+// keeping the key or value around. Membership is tested through a small
+// open-addressing set of the same hashes; hash collisions only make a policy
+// decision slightly less accurate.
+//
+// Removing a hash leaves its ring entry behind. Each push is numbered and the
+// set records the number of the push a member came from, so a stale entry is
+// recognised when it ages out and neither counts toward the limit nor drops
+// a later push of the same hash.
+typedef struct ghost_entry
+{
+    uint64_t key; // Hash, with 0 stored as 1; 0 marks an empty set slot
+    uint64_t seq; // Number of the push that added it
+} ghost_entry_t;
+
+typedef struct ghost_list
+{
+    ghost_entry_t *ring;  // Pushes in eviction order, oldest at head
+    size_t ring_capacity; // Power of two
+    size_t head;
+    size_t count;         // Ring entries, stale ones included
+    ghost_entry_t *set;   // Linear-probing set of the remembered hashes
+    size_t set_capacity;  // Power of two, twice ring_capacity
+    size_t set_size;      // Hashes remembered
+    uint64_t next_seq;
+} ghost_list_t;
+
+// Initialise an empty list; returns 0 if memory could not be allocated
+extern int ghost_list_init(ghost_list_t *ghosts);
+
+// Release the list's memory
+extern void ghost_list_destroy(ghost_list_t *ghosts);
+
+// Check whether a hash is remembered
+extern int ghost_list_contains(ghost_list_t *ghosts, uint64_t hash);
+
+// Forget a hash; returns 1 if it was remembered
+extern int ghost_list_remove(ghost_list_t *ghosts, uint64_t hash);
+
+// Remember a hash, dropping the oldest entries beyond limit; returns how many
+// dropped entries were still remembered, i.e. aged out without coming back
+extern size_t ghost_list_push(ghost_list_t *ghosts, uint64_t hash, size_t limit);
+
+// Forget every hash
+extern void ghost_list_clear(ghost_list_t *ghosts);
+
+#endif // GHOST_LIST_H
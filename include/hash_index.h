@@ -0,0 +1,97 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include "node_utils.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of control bytes matched together by one probe step
+#define HASH_INDEX_GROUP_WIDTH 16
+
+// Groups of the older table a write moves into the new one while a rehash
+// is in progress
+#define HASH_INDEX_REHASH_GROUPS 1
+
+// Control byte values; full slots hold a 7-bit tag with the top bit clear
+#define HASH_INDEX_CTRL_EMPTY ((uint8_t)0x80)
+#define HASH_INDEX_CTRL_DELETED ((uint8_t)0xFE)
+
+// One generation of the table: control bytes and slots in a single block, so
+// a reader that loads the table pointer always sees a matching capacity
+typedef struct hash_index_table
+{
+    size_t capacity; // Number of slots, always a power of two
+    Node **slots;    // Entry handle for every full slot
+    uint8_t ctrl[];  // One control byte per slot, grouped in HASH_INDEX_GROUP_WIDTH
+} hash_index_table_t;
+
+// Open-addressing index from key hash to Node, in the style of a Swiss table.
+// Every slot has one control byte: the top bit marks it empty or deleted,
+// otherwise the low seven bits hold the bottom seven bits of the key's hash.
+// A probe loads a whole group of sixteen control bytes, matches them against
+// the hash tag at once, and only dereferences nodes whose tag matched.
+//
+// Growing or rebuilding is incremental, in the style of Redis dictRehash: the
+// new table is published at once and each write moves a few groups of the
+// older table into it. Moved entries stay in the older table until it is
+// dropped, so a lookup that misses in the new table and then probes the
+// older one always finds a key that was indexed throughout. Inserts go to
+// the new table only; removals and replacements update both.
+//
+// One writer at a time may modify the index while any number of readers call
+// hash_index_find: slots are published before their control byte, and a
+// replaced table is handed to the retire hook (when set) instead of being
+// freed, so the caller can defer the free until no reader can still see it.
+typedef struct hash_index
+{
+    hash_index_table_t *table;
+    hash_index_table_t *older; // Table still being moved into table, NULL when no rehash is running
+    size_t rehash_cursor;      // Next slot of older to move
+    size_t rehash_pace;        // Groups moved per requested group, so the move ends before the new table fills
+    size_t size;        // Number of indexed entries
+    size_t growth_left; // Inserts into empty slots allowed before the table grows
+    void (*retire)(void *ctx, void *table); // Receives replaced tables, or NULL to free them
+    void *retire_ctx;
+} hash_index_t;
+
+// Initialise an index with room for at least the given number of entries
+extern int hash_index_init(hash_index_t *index, size_t expected_entries);
+
+// Release the memory owned by an index (the nodes themselves are not freed)
+extern void hash_index_destroy(hash_index_t *index);
+
+// Number of slots in the current table
+extern size_t hash_index_capacity(hash_index_t *index);
+
+// Find the node holding a key, or NULL if it is not indexed; safe alongside one writer
+extern Node *hash_index_find(hash_index_t *index, uint64_t hash, char *key, size_t key_len);
+
+// Prefetch the control group and slots a lookup of the hash starts at
+extern void hash_index_prefetch(hash_index_t *index, uint64_t hash);
+
+// Prefetch the entries whose tags match the hash in its first group; meant to
+// follow hash_index_prefetch once that group has had time to arrive
+extern void hash_index_prefetch_entries(hash_index_t *index, uint64_t hash);
+
+// Check whether a node is still indexed under a hash without dereferencing it
+extern int hash_index_contains(hash_index_t *index, uint64_t hash, Node *node);
+
+// Add a node whose key is not yet indexed, growing the table as needed; returns 0 on failure
+extern int hash_index_insert(hash_index_t *index, uint64_t hash, Node *node);
+
+// Remove a node from the index; returns 0 if it was not found
+extern int hash_index_remove(hash_index_t *index, uint64_t hash, Node *node);
+
+// Swap the node an indexed key refers to, e.g. after reallocating its entry
+extern int hash_index_replace(hash_index_t *index, uint64_t hash, Node *old_node, Node *new_node);
+
+// Start rebuilding the table sized for the given number of entries, dropping
+// tombstones; any rehash already running is finished first. Returns 0 if the
+// new table cannot be allocated.
+extern int hash_index_rehash(hash_index_t *index, size_t expected_entries);
+
+// Move up to the given number of groups of a running rehash; returns 1 while
+// entries remain to be moved
+extern int hash_index_rehash_step(hash_index_t *index, size_t groups);
+
+#endif // HASH_INDEX_H
@@ -1,9 +1,28 @@
 #ifndef HASH_UTILS_H
 #define HASH_UTILS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+// Signature shared by all key hash functions; the seed perturbs the output
+// so that keys cannot be chosen in advance to collide
+typedef uint64_t (*hash_fn_t)(const void *key, size_t len, uint64_t seed);
+
 // Function to calculate a djb2 hash for a string
 extern unsigned long djb2_hash(const char *key);
 
+// Byte-at-a-time djb2 over an explicit length, usable as a hash_fn_t
+extern uint64_t djb2_hash_seeded(const void *key, size_t len, uint64_t seed);
+
+// Word-at-a-time 64-bit hash based on wyhash; the default for new caches
+extern uint64_t wyhash64(const void *key, size_t len, uint64_t seed);
+
+// Draw a random seed from the operating system
+extern uint64_t hash_random_seed(void);
+
+// Map a 64-bit hash onto [0, range) with a multiply instead of a division
+extern size_t hash_to_range(uint64_t hash, size_t range);
+
 // Map a string key to an index within a given capacity
 extern int key_to_index(char *key, int capacity);
 
@@ -1,30 +1,65 @@
 #ifndef KEY_VALUE_PAIR_H
 #define KEY_VALUE_PAIR_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+// A key-value pair and its bytes live in one variable-length block: the
+// fixed header below is followed by the key, its terminator, the value and
+// its terminator. Lengths are explicit, so keys and values may contain NUL
+// bytes; the terminators only serve callers that treat them as strings.
+// value_capacity counts the bytes reserved after the key for
+// the value (terminator included), so shorter or equal-size values can be
+// rewritten in place.
 typedef struct kv_pair
 {
-    char *key;
-    char *value;
+    uint64_t hash;           // Full hash of the key, computed once on insert
+    uint32_t key_len;        // Length of the key excluding the terminator
+    uint32_t value_len;      // Length of the value excluding the terminator
+    uint32_t value_capacity; // Bytes available for the value and its terminator
+    char key[];              // Key bytes, then the value bytes
 } kv_pair_t;
 
-// Create a new key-value pair
-extern kv_pair_t *kv_new_kv_pair(char *key, char *value);
+// Longest key or value a pair can hold. Lengths are stored in 32 bits, and so
+// is the value's capacity, which adds the terminator and up to a chunk
+// alignment of slack to the value's length
+#define KV_PAIR_MAX_LEN ((size_t)UINT32_MAX - 64)
+
+// Bytes needed for a pair header plus a key and a value slot of the given sizes
+extern size_t kv_pair_size(size_t key_len, size_t value_capacity);
+
+// Initialise a pair in caller-provided memory of kv_pair_size(key_len, value_capacity) bytes
+extern void kv_pair_init(kv_pair_t *kv_pair, char *key, size_t key_len, uint64_t hash,
+                         char *value, size_t value_len, size_t value_capacity);
+
+// Create a new standalone key-value pair, caching the key's hash and length
+extern kv_pair_t *kv_new_kv_pair(char *key, size_t key_len, uint64_t hash, char *value);
+
+// Create a new standalone pair from a value of explicit length, which may contain NULs
+extern kv_pair_t *kv_new_kv_pair_bin(char *key, size_t key_len, uint64_t hash,
+                                     char *value, size_t value_len);
 
 // Get the value associated with a key from a key-value pair
 extern char *kv_pair_get_value(kv_pair_t *kv_pair);
 
-// Update the value in a key-value pair
-extern void kv_pair_set_value(kv_pair_t *kv_pair, char *new_value);
+// Update the value in place; returns 0 and leaves the pair unchanged if it does not fit
+extern int kv_pair_set_value(kv_pair_t *kv_pair, char *new_value);
+
+// Update the value in place from bytes of explicit length
+extern int kv_pair_set_value_bin(kv_pair_t *kv_pair, char *new_value, size_t value_len);
 
 // Get the key from a key-value pair
 extern char *kv_pair_get_key(kv_pair_t *kv_pair);
 
-// Free a key-value pair
+// Free a key-value pair created with kv_new_kv_pair
 extern void kv_free_kv_pair(kv_pair_t *kv_pair);
 
-// Compare a key with the key in a key-value pair, return 1 if matches
+// Compare a NUL-terminated key with the key in a key-value pair, return 1 if matches
 extern int kv_pair_matches_key(kv_pair_t *kv_pair, char *key);
 
+// Compare a pre-hashed key, checking the cached hash and length before the bytes
+extern int kv_pair_matches_hashed_key(kv_pair_t *kv_pair, uint64_t hash, char *key, size_t key_len);
+
 // Print a key-value pair
 extern void kv_print_kv_pair(kv_pair_t *kv_pair);
 
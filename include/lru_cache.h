@@ -3,23 +3,176 @@
 
 #include "key_value_pair.h"
 #include "node_utils.h"
+#include "hash_index.h"
+#include "hash_utils.h"
+#include "epoch.h"
+#include "eviction_policy.h"
+#include "ghost_list.h"
+#include "timer_wheel.h"
+#include "lru_clock.h"
+#include "lru_instrument.h"
 
-#define DEFAULT_EXPIRATION_TIME 7200
+#define DEFAULT_EXPIRATION_MS (7200ULL * 1000) // Two hours
+
+// Share of the byte budget a single entry may take before it is rejected
+#define LRU_DEFAULT_MAX_ENTRY_FRACTION 0.5
+
+// Per-entry index cost charged against the byte budget: one slot and one control byte
+#define LRU_ENTRY_INDEX_OVERHEAD (sizeof(Node *) + 1)
+
+// Retired entries are reclaimed each time this many have accumulated
+#define LRU_RECLAIM_THRESHOLD 64
+
+// Wheel slots an eviction may turn through while looking for an expired
+// entry to evict ahead of the policy's victim
+#define LRU_EXPIRE_EVICTION_BUDGET 64
+
+// Entries an insert evicts in policy order when the slab memory limit leaves
+// no chunk of its size, before it moves a page over from another size class
+#define LRU_SLAB_EVICTION_BUDGET 16
+
+// Keys mget and mset hash and prefetch together before looking any of them up
+#define LRU_BATCH_CHUNK 32
+
+// Removals handed to an eviction listener per call
+#define LRU_EVICTION_BATCH 64
+
+// Memory unlinked from the cache but possibly still seen by a lock-free reader
+typedef struct lru_retired
+{
+    void *ptr;
+    uint64_t epoch; // Epoch current when it was unlinked
+    int is_table;   // An index table rather than an entry
+} lru_retired_t;
+
+// A pinned cache entry. While a handle is held the entry's key and value
+// bytes stay valid and unchanged, even if the entry is updated, evicted or
+// expired in the meantime; the entry's memory is freed by its last release.
+typedef struct Node lru_handle_t;
+
+// Why an entry left the cache
+typedef enum lru_removal_reason
+{
+    LRU_REMOVAL_CAPACITY = 0, // Evicted to make room under the item count or byte budget
+    LRU_REMOVAL_EXPIRED,      // Its expiration time passed
+    LRU_REMOVAL_EXPLICIT,     // Deleted by lru_cache_delete
+    LRU_REMOVAL_RESIZE        // Evicted because lru_cache_resize_cache shrank the cache
+} lru_removal_reason_t;
+
+// A removed entry. The entry is pinned like a handle, so its key and value
+// can be read with lru_handle_key and lru_handle_value until the listener
+// returns.
+typedef struct lru_eviction
+{
+    lru_handle_t *entry;
+    lru_removal_reason_t reason;
+} lru_eviction_t;
+
+// Told of up to LRU_EVICTION_BATCH removals at a time, oldest first
+typedef void (*lru_eviction_listener_t)(void *ctx, const lru_eviction_t *evictions, size_t count);
+
+// Options for creating a cache; start from lru_cache_config_init()
+typedef struct lru_cache_config
+{
+    int capacity;       // Maximum number of entries, 0 for no limit when memory_limit is set
+    hash_fn_t hash_fn;  // Key hash function, wyhash64 when NULL
+    uint64_t hash_seed; // Seed passed to hash_fn
+    int random_seed;    // If set, hash_seed is drawn from the OS to resist hash flooding
+    size_t slab_page_size;    // Bytes per slab page, SLAB_DEFAULT_PAGE_SIZE when 0
+    size_t slab_memory_limit; // Maximum bytes of entry memory, 0 for unlimited
+    int slab_preallocate;     // If set, the whole slab_memory_limit is reserved at creation
+    size_t memory_limit;       // Byte budget for keys, values and per-entry overhead, 0 for none
+    double max_entry_fraction; // Entries larger than this share of memory_limit are rejected
+    lru_policy_t policy;       // Eviction policy, LRU_POLICY_LRU by default
+    lru_clock_t *clock;        // Time source for expiration, shareable; a coarse monotonic clock when NULL
+} lru_cache_config_t;
+
+// Running totals a cache keeps about its traffic. Only the thread using the
+// cache (a sharded cache's lock holder) writes them, with relaxed atomic
+// stores, so lru_cache_get_stats can read them from any thread without a
+// lock and without stopping that traffic.
+typedef struct lru_cache_counters
+{
+    uint64_t hits;          // Lookups that found a live entry
+    uint64_t misses;        // Lookups that found nothing, or an expired entry
+    uint64_t inserts;       // Sets of a key that was not cached
+    uint64_t updates;       // Sets of a key that was cached
+    uint64_t evictions;     // Live entries removed to make room
+    uint64_t expirations;   // Expired entries removed, by a lookup, lru_cache_expire or an eviction
+    uint64_t bytes_written; // Key and value bytes stored by inserts and updates
+} lru_cache_counters_t;
+
+// A snapshot of a cache's counters along with its current size
+typedef struct lru_cache_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint64_t updates;
+    uint64_t evictions;
+    uint64_t expirations;
+    uint64_t bytes_written;
+    uint64_t size;       // Resident entries
+    uint64_t bytes_used; // Footprint of the resident entries
+} lru_cache_stats_t;
 
 typedef struct LRUCache
 {
     int capacity;
     int size;
-    int hits;
-    int misses;
-    Node *head;
-    Node *tail;
-    Node **hash_table;
+    lru_cache_counters_t counters;
+    node_list_t list;   // Resident entries, most recently used first under LRU
+    lru_policy_t policy;
+    Node *hand;         // CLOCK hand: next entry to examine, NULL for the tail
+    size_t hot_count;   // CLOCK-Pro: resident hot entries
+    size_t cold_target; // CLOCK-Pro: adaptive number of entries kept cold
+    ghost_list_t ghosts; // CLOCK-Pro: evicted cold entries; ARC: B1, hashes evicted from T1
+    node_list_t segments[LRU_POLICY_LISTS - 1]; // Lists of segmented policies beyond the main list
+    int segment_size[LRU_POLICY_LISTS];         // Entries on each list, the main list first
+    frequency_sketch_t sketch;                  // W-TinyLFU: recent access frequencies
+    ghost_list_t frequent_ghosts; // ARC: B2, hashes evicted from T2; ghosts holds B1
+    size_t arc_target;            // ARC: adaptive target size of T1 (p)
+    int arc_incoming;             // ARC: ghost list the key being inserted was found on
+    size_t arc_saved_target;      // ARC: arc_target before that key adapted it
+    timer_wheel_t timers; // Entries by expiration, one tick per millisecond
+    lru_clock_t *clock;   // Time source, own_clock unless the config supplied one
+    lru_clock_t own_clock;
+    hash_index_t index; // Key lookup, sized by load factor rather than capacity
+    hash_fn_t hash_fn;
+    uint64_t hash_seed;
+    slab_allocator_t slabs; // Backing memory for all entries
+    size_t memory_limit;    // Byte budget, 0 when only the item count bounds the cache
+    size_t bytes_used;      // Footprint of all resident entries
+    double max_entry_fraction;
+    epoch_domain_t *epoch;  // Set when lock-free readers may hold node pointers
+    lru_retired_t *retired; // Unlinked memory waiting for readers to move on
+    size_t retired_count;
+    size_t retired_capacity;
+    node_list_t pinned;     // Entries no longer cached that handles still hold
+    lru_eviction_listener_t listener; // Told of removals, NULL for none
+    void *listener_ctx;
+    int collect_evictions;    // Record removals for lru_cache_take_evictions even without a listener
+    int delivering;           // The listener is running
+    lru_eviction_t *evicted;  // Removals not yet delivered, each pinning its entry
+    size_t evicted_count;
+    size_t evicted_capacity;
+#ifdef LRU_CACHE_INSTRUMENT
+    lru_instrument_t instrument; // Sampled phase timings
+#endif
 } LRUCache;
 
 // Create a new LRU cache with a fixed capacity
 extern LRUCache *lru_cache_create(int capacity);
 
+// Create a new LRU cache that evicts by total entry footprint instead of item count
+extern LRUCache *lru_cache_create_with_memory_limit(size_t bytes);
+
+// Fill a config with the defaults used by lru_cache_create
+extern void lru_cache_config_init(lru_cache_config_t *config, int capacity);
+
+// Create a new LRU cache from a config
+extern LRUCache *lru_cache_create_with_config(const lru_cache_config_t *config);
+
 // Get the value associated with a key
 extern char *lru_cache_get(LRUCache *cache, char *key);
 
@@ -32,10 +185,146 @@ extern void lru_cache_free(LRUCache *cache);
 // Method to print the stats for the cache
 extern void lru_cache_print_stats(LRUCache *cache);
 
+// Method to print per-size-class occupancy of the entry allocator
+extern void lru_cache_print_slab_stats(LRUCache *cache);
+
 extern void lru_cache_resize_cache(LRUCache *cache, int new_capacity);
 
 extern void lru_cache_reset_stats(LRUCache *cache);
 
-extern void lru_cache_set_with_expiration(LRUCache *cache, char *key, char *value, int ttl_seconds);
+// Copy the cache's counters, size and bytes used into stats. Safe to call
+// from another thread while the cache is in use; each value is read
+// atomically, though not all at the same instant.
+extern void lru_cache_get_stats(LRUCache *cache, lru_cache_stats_t *stats);
+
+// Copy the sampled timings of one phase into histogram, readable from any
+// thread like the stats; returns 0 if the library was built without
+// LRU_CACHE_INSTRUMENT or the arguments are invalid
+extern int lru_cache_get_latency(LRUCache *cache, lru_phase_t phase, lru_latency_histogram_t *histogram);
+
+// Print the sample count, mean and percentiles of every phase, in cycles
+extern void lru_cache_print_latency(LRUCache *cache);
+
+extern void lru_cache_set_with_expiration(LRUCache *cache, char *key, char *value, uint64_t ttl_ms);
+
+// Set a key and value given by explicit lengths, so either may hold NUL
+// bytes; the entry expires ttl_ms milliseconds from now. Lengths above
+// KV_PAIR_MAX_LEN are rejected
+extern void lru_cache_set_bin(LRUCache *cache, char *key, size_t key_len, char *value, size_t value_len,
+                              uint64_t ttl_ms);
+
+// Get the value for a key of explicit length, storing its length in
+// value_len when that is not NULL; the value is followed by a NUL that is
+// not counted
+extern char *lru_cache_get_bin(LRUCache *cache, char *key, size_t key_len, size_t *value_len);
+
+// Look up n keys at once, storing each value, or NULL on a miss, in
+// values_out; returns the number of hits. The values stay valid until the
+// cache is next modified.
+extern size_t lru_cache_mget(LRUCache *cache, char **keys, size_t n, char **values_out);
+
+// Insert or update n key-value pairs with the default expiration; pairs
+// with a NULL key or value are skipped, as lru_cache_set skips them
+extern void lru_cache_mset(LRUCache *cache, char **keys, char **values, size_t n);
+
+// Look up a key like lru_cache_get, but pin the entry so its value can be
+// read in place until lru_cache_release; NULL on a miss. Acquiring and
+// releasing count as modifications of the cache.
+extern lru_handle_t *lru_cache_acquire(LRUCache *cache, char *key);
+
+// Variant of lru_cache_acquire for a key already hashed with the cache's hash_fn
+extern lru_handle_t *lru_cache_acquire_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash);
+
+// Drop a handle; an entry that has left the cache is freed by its last release
+extern void lru_cache_release(LRUCache *cache, lru_handle_t *handle);
+
+// Value bytes of a pinned entry, NUL-terminated; must not be modified
+extern char *lru_handle_value(lru_handle_t *handle);
+
+// Length of a pinned entry's value, excluding the terminator
+extern size_t lru_handle_value_len(lru_handle_t *handle);
+
+// Key of a pinned entry
+extern char *lru_handle_key(lru_handle_t *handle);
+
+// Write every live entry, with its remaining TTL, to a snapshot file in
+// recency order, entries of a segmented policy's most valuable list first;
+// the file is replaced atomically. Returns 1 on success.
+extern int lru_cache_save(LRUCache *cache, const char *path);
+
+// Create a cache from a snapshot with the capacity, byte budget and policy
+// it was saved with; NULL if the file is missing, truncated or corrupt
+extern LRUCache *lru_cache_load(const char *path);
+
+// Create a cache from a config and fill it from a snapshot, keeping the
+// entries written first when the snapshot holds more than fit: the most
+// recently used ones, protected or T2 entries ahead of the rest
+extern LRUCache *lru_cache_load_with_config(const char *path, const lru_cache_config_t *config);
+
+// Append an entry behind all others on a policy list without evicting
+// anything, as when rebuilding a cache from a snapshot; returns 0 if the
+// key is already cached or the entry does not fit
+extern int lru_cache_restore_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash,
+                                    char *value, size_t value_len, uint64_t ttl_ms,
+                                    int segment, uint8_t policy_flags);
+
+// Remove up to budget expired entries, turning the expiry wheel by a
+// bounded amount of work; returns the number removed
+extern size_t lru_cache_expire(LRUCache *cache, size_t budget);
+
+// Variants of get_bin and set_bin for callers that already hashed the key
+// with the cache's hash_fn and hash_seed, such as a sharded front end
+extern char *lru_cache_get_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash,
+                                  size_t *value_len);
+
+extern void lru_cache_set_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash,
+                                 char *value, size_t value_len, uint64_t ttl_ms);
+
+// Support for lock-free readers. Once enabled, published entries are never
+// modified or freed in place: updates replace the entry and removed memory is
+// freed only after every reader in the epoch domain has moved past it. The
+// cache itself must still be modified by one thread at a time.
+extern void lru_cache_enable_concurrent_reads(LRUCache *cache, epoch_domain_t *epoch);
+
+// Find an entry without changing recency or statistics; safe for lock-free readers
+extern Node *lru_cache_peek_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash);
+
+// Move an entry found by lru_cache_peek_hashed to the front, if it is still cached
+extern void lru_cache_promote(LRUCache *cache, Node *node, uint64_t hash);
+
+// Free retired memory that no reader can still reach
+extern void lru_cache_reclaim(LRUCache *cache);
+
+// Remove a key; returns 1 if a live entry was removed, 0 if the key was
+// absent or had already expired (it is then removed as expired)
+extern int lru_cache_delete(LRUCache *cache, char *key);
+
+extern int lru_cache_delete_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash);
+
+// Report every entry the cache removes to fn, with the reason. Removals are
+// queued, their entries pinned, and delivered in batches of
+// LRU_EVICTION_BATCH at the end of a set, mset, delete, lru_cache_expire or
+// resize, once the cache is consistent again, so the listener may itself use
+// the cache; removals that it causes join the queue. Expired entries that
+// lookups remove wait for the next of those calls. lru_cache_expire, resize,
+// lru_cache_flush_evictions and lru_cache_free deliver a final partial
+// batch. Queued entries keep their memory until delivered, and an evicted
+// block is not reused for the incoming entry while a listener is set. A NULL
+// fn stops reporting; removals already queued are still delivered.
+extern void lru_cache_set_eviction_listener(LRUCache *cache, lru_eviction_listener_t fn, void *ctx);
+
+// Deliver every queued removal now, in batches
+extern void lru_cache_flush_evictions(LRUCache *cache);
+
+// Support for callers that deliver removals themselves, such as a sharded
+// front end that calls its listener without holding the shard lock. With
+// collection on, removals are queued as for a listener but never delivered;
+// lru_cache_take_evictions moves up to max of them, oldest first, into
+// batch, but only once max are queued unless partial is set, and returns the
+// number moved. Each taken entry stays pinned until passed to
+// lru_cache_release.
+extern void lru_cache_collect_evictions(LRUCache *cache, int on);
+
+extern size_t lru_cache_take_evictions(LRUCache *cache, lru_eviction_t *batch, size_t max, int partial);
 
 #endif // LRU_CACHE_H
@@ -0,0 +1,50 @@
+#ifndef LRU_CLOCK_H
+#define LRU_CLOCK_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+// Where a cache reads the time used for expiration, in milliseconds. Only
+// differences matter, so the monotonic clocks' arbitrary origin is fine.
+typedef enum lru_clock_kind
+{
+    LRU_CLOCK_MONOTONIC = 0,   // CLOCK_MONOTONIC on every read
+    LRU_CLOCK_MONOTONIC_COARSE, // CLOCK_MONOTONIC_COARSE: tick resolution, no hardware counter read
+    LRU_CLOCK_CACHED,          // A stored time refreshed by a ticker thread or every refresh_ops reads
+    LRU_CLOCK_FAKE             // A stored time moved only by lru_clock_set and lru_clock_advance
+} lru_clock_kind_t;
+
+// Reads between refreshes of a cached clock that has no ticker thread
+#define LRU_CLOCK_DEFAULT_REFRESH_OPS 64
+
+typedef struct lru_clock
+{
+    lru_clock_kind_t kind;
+    uint64_t now_ms;       // Stored time of cached and fake clocks, accessed atomically
+    uint32_t reads;        // Cached clock: reads since the last refresh, updated racily
+    uint32_t refresh_ops;  // Cached clock: reads between refreshes without a ticker
+    int ticking;           // Cached clock: a ticker thread keeps now_ms current
+    int stop;              // Asks the ticker thread to exit
+    uint32_t tick_ms;      // Ticker thread's refresh interval
+    pthread_t ticker;
+} lru_clock_t;
+
+// Initialise a clock; cached and fake clocks start at the current coarse time
+extern void lru_clock_init(lru_clock_t *clock, lru_clock_kind_t kind);
+
+// Stop the ticker thread, if any
+extern void lru_clock_destroy(lru_clock_t *clock);
+
+// Current time in milliseconds. Safe to call from any thread; a cached clock
+// without a ticker counts the read and refreshes itself every refresh_ops reads.
+extern uint64_t lru_clock_now_ms(lru_clock_t *clock);
+
+// Keep a cached clock current from a background thread that refreshes it
+// every tick_ms; returns 0 if the clock is not cached or the thread cannot start
+extern int lru_clock_start_ticker(lru_clock_t *clock, uint32_t tick_ms);
+
+// Move a fake clock to ms, or forward by ms
+extern void lru_clock_set(lru_clock_t *clock, uint64_t ms);
+extern void lru_clock_advance(lru_clock_t *clock, uint64_t ms);
+
+#endif // LRU_CLOCK_H
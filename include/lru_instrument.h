@@ -0,0 +1,160 @@
+#ifndef LRU_INSTRUMENT_H
+#define LRU_INSTRUMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Optional hot-path instrumentation, compiled in only when
+// LRU_CACHE_INSTRUMENT is defined (make INSTRUMENT=1). It adds a field to
+// LRUCache, so the library and its users must all be built the same way.
+//
+// Each phase of a get or set is timed with the CPU's cycle counter on one
+// occurrence in LRU_INSTRUMENT_SAMPLE_EVERY and recorded in a per-cache
+// histogram. Like the cache's counters the histograms have a single writer
+// and relaxed atomic stores, so lru_cache_get_latency can read them while
+// the cache is in use.
+//
+// Where <sys/sdt.h> is available the build also carries USDT probes in the
+// lru_cache provider, inert until a tracer attaches:
+//   get(key, key_len, hit), set(key, key_len, value_len, ttl_ms),
+//   evict(key, key_len), expire(key, key_len)
+// for example: bpftrace -e 'usdt:./test_lru_cache:lru_cache:evict { @[str(arg0, arg1)] = count(); }'
+//
+// Without the flag every timing and probe macro expands to nothing.
+
+// Phases timed separately
+typedef enum lru_phase
+{
+    LRU_PHASE_GET = 0, // Whole lookup after hashing: lru_cache_get_hashed
+    LRU_PHASE_SET,     // Whole insert or update after hashing: lru_cache_set_hashed
+    LRU_PHASE_HASH,    // Hashing a key with the cache's hash function
+    LRU_PHASE_LOOKUP,  // Probing the index for the key
+    LRU_PHASE_EVICT,   // Removing one entry to make room
+    LRU_PHASE_ALLOC,   // Allocating and filling an entry block
+    LRU_PHASE_COUNT
+} lru_phase_t;
+
+// Occurrences of a phase per timed one; a power of two
+#define LRU_INSTRUMENT_SAMPLE_EVERY 64
+
+// Buckets split each power of two of cycles in 1 << LRU_LATENCY_SUB_BITS
+#define LRU_LATENCY_SUB_BITS 2
+#define LRU_LATENCY_BUCKETS ((64 - LRU_LATENCY_SUB_BITS + 1) << LRU_LATENCY_SUB_BITS)
+
+// Sampled durations of one phase, in cycle counter ticks
+typedef struct lru_latency_histogram
+{
+    uint64_t count;  // Samples recorded
+    uint64_t cycles; // Sum of the samples
+    uint64_t buckets[LRU_LATENCY_BUCKETS];
+} lru_latency_histogram_t;
+
+typedef struct lru_instrument
+{
+    uint64_t ticks[LRU_PHASE_COUNT]; // Occurrences of each phase, timed or not
+    lru_latency_histogram_t phases[LRU_PHASE_COUNT];
+} lru_instrument_t;
+
+// Bucket of a duration: its power of two, then the bits just below the top one
+static inline size_t lru_latency_bucket(uint64_t cycles)
+{
+    if (cycles < (1u << LRU_LATENCY_SUB_BITS))
+    {
+        return (size_t)cycles;
+    }
+    int top = 63 - __builtin_clzll(cycles);
+    uint64_t sub = (cycles >> (top - LRU_LATENCY_SUB_BITS)) & ((1u << LRU_LATENCY_SUB_BITS) - 1);
+    return ((size_t)(top - LRU_LATENCY_SUB_BITS + 1) << LRU_LATENCY_SUB_BITS) + (size_t)sub;
+}
+
+// Name of a phase, for reports
+extern const char *lru_phase_name(lru_phase_t phase);
+
+// Smallest duration that falls in a bucket
+extern uint64_t lru_latency_bucket_floor(size_t bucket);
+
+// Duration below which the given share of samples fall, at bucket resolution;
+// 0 for an empty histogram
+extern uint64_t lru_latency_percentile(const lru_latency_histogram_t *histogram, double p);
+
+// Add one histogram's samples to another
+extern void lru_latency_merge(lru_latency_histogram_t *into, const lru_latency_histogram_t *from);
+
+#ifdef LRU_CACHE_INSTRUMENT
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+// Current value of the cycle counter: the TSC on x86, the virtual counter on
+// AArch64, nanoseconds elsewhere
+static inline uint64_t lru_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// Counts an occurrence of a phase and returns its start time when it is to
+// be timed, 0 otherwise
+static inline uint64_t lru_instrument_start(lru_instrument_t *instrument, lru_phase_t phase)
+{
+    uint64_t tick = instrument->ticks[phase] + 1;
+    __atomic_store_n(&instrument->ticks[phase], tick, __ATOMIC_RELAXED);
+    return (tick & (LRU_INSTRUMENT_SAMPLE_EVERY - 1)) == 0 ? lru_cycles() : 0;
+}
+
+// Records the duration of a timed phase
+static inline void lru_instrument_end(lru_instrument_t *instrument, lru_phase_t phase, uint64_t start)
+{
+    if (!start)
+    {
+        return;
+    }
+
+    uint64_t cycles = lru_cycles() - start;
+    lru_latency_histogram_t *histogram = &instrument->phases[phase];
+    uint64_t *bucket = &histogram->buckets[lru_latency_bucket(cycles)];
+    __atomic_store_n(bucket, *bucket + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->cycles, histogram->cycles + cycles, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->count, histogram->count + 1, __ATOMIC_RELAXED);
+}
+
+#define LRU_TIME_START(cache, phase, start) uint64_t start = lru_instrument_start(&(cache)->instrument, phase)
+#define LRU_TIME_END(cache, phase, start) lru_instrument_end(&(cache)->instrument, phase, start)
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LRU_HAVE_PROBES 1
+#endif
+#endif
+
+#else
+
+#define LRU_TIME_START(cache, phase, start)
+#define LRU_TIME_END(cache, phase, start) ((void)0)
+
+#endif // LRU_CACHE_INSTRUMENT
+
+#ifdef LRU_HAVE_PROBES
+#define LRU_PROBE2(name, a, b) DTRACE_PROBE2(lru_cache, name, a, b)
+#define LRU_PROBE3(name, a, b, c) DTRACE_PROBE3(lru_cache, name, a, b, c)
+#define LRU_PROBE4(name, a, b, c, d) DTRACE_PROBE4(lru_cache, name, a, b, c, d)
+#else
+#define LRU_PROBE2(name, a, b) ((void)0)
+#define LRU_PROBE3(name, a, b, c) ((void)0)
+#define LRU_PROBE4(name, a, b, c, d) ((void)0)
+#endif
+
+#endif // LRU_INSTRUMENT_H
@@ -0,0 +1,55 @@
+#ifndef LRU_SNAPSHOT_H
+#define LRU_SNAPSHOT_H
+
+#include <stdint.h>
+
+// On-disk layout written by lru_cache_save. A header is followed by blocks
+// of entry records, each block carrying its own checksum so that a loader
+// can verify a block while it is still in the CPU caches and build its
+// entries in the same pass. Fields are in host byte order; a snapshot from
+// a machine of the other byte order fails the version check.
+//
+// Records are written list by list, the policy's most valuable list first
+// and each list from head to tail, and hold
+// the remaining TTL rather than the absolute expiration, since the cache's
+// clock has no meaning in another process.
+
+#define LRU_SNAPSHOT_MAGIC "LRUSNAP"
+#define LRU_SNAPSHOT_VERSION 1
+
+// Bytes of records gathered before a block is written; a record larger than
+// this gets a block to itself
+#define LRU_SNAPSHOT_BLOCK_SIZE (256 * 1024)
+
+// Seed for the block and header checksums
+#define LRU_SNAPSHOT_CHECKSUM_SEED 0x4c5255534e415031ULL
+
+typedef struct lru_snapshot_header
+{
+    char magic[8];          // LRU_SNAPSHOT_MAGIC and its terminator
+    uint32_t version;       // LRU_SNAPSHOT_VERSION
+    uint32_t policy;        // Eviction policy of the saved cache
+    int64_t capacity;       // Item capacity of the saved cache
+    uint64_t memory_limit;  // Byte budget of the saved cache
+    uint64_t entry_count;   // Records in all blocks
+    uint64_t checksum;      // Of the fields above
+} lru_snapshot_header_t;
+
+typedef struct lru_snapshot_block
+{
+    uint32_t entry_count; // Records in the block
+    uint32_t size;        // Bytes of records that follow
+    uint64_t checksum;    // Of those bytes
+} lru_snapshot_block_t;
+
+// Fixed part of a record, followed by the key bytes and then the value bytes
+typedef struct lru_snapshot_record
+{
+    uint32_t key_len;
+    uint32_t value_len;
+    uint64_t ttl_ms;      // Time left before the entry expires
+    uint8_t segment;      // Policy list the entry was on
+    uint8_t policy_flags; // Policy state bits, e.g. CLOCK reference bits
+} __attribute__((packed)) lru_snapshot_record_t;
+
+#endif // LRU_SNAPSHOT_H
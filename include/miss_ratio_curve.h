@@ -0,0 +1,58 @@
+#ifndef MISS_RATIO_CURVE_H
+#define MISS_RATIO_CURVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Miss-ratio curve of an LRU cache for every capacity at once, from one pass
+// over a trace. Each access's stack distance, the number of distinct keys
+// used since the key's previous access, is counted with a Fenwick tree over
+// access times in which only each key's latest access is marked (Mattson's
+// algorithm in O(log n) per access). A cache of capacity C hits exactly the
+// accesses with a distance of at most C.
+//
+// With a sample rate below 1 only keys whose hash falls under a threshold
+// are tracked (fixed-rate SHARDS): distances among sampled keys are scaled
+// by 1 / rate, and memory and time shrink with the rate. The count of
+// sampled accesses is corrected towards its expected value, which removes
+// most of the bias from a few hot keys landing in or out of the sample.
+
+// Hash bits compared against the sampling threshold
+#define MRC_SAMPLE_BITS 24
+
+typedef struct mrc
+{
+    double sample_rate;
+    uint64_t threshold; // Keys whose top MRC_SAMPLE_BITS hash bits fall below this are sampled
+    uint64_t accesses;  // All accesses seen, sampled or not
+    uint64_t sampled;   // Accesses to sampled keys
+    uint64_t cold;      // Sampled first accesses, misses at every capacity
+    uint64_t *distances; // Sampled accesses by stack distance, index 0 unused
+    size_t distances_capacity;
+    uint32_t *tree;     // Fenwick tree over access times, 1-based
+    uint8_t *marks;     // Times that are some key's latest access
+    size_t time_capacity;
+    size_t now;         // Last time handed out
+    size_t live;        // Marked times, i.e. distinct sampled keys
+    uint64_t *table_keys;  // Open-addressing map from key hash to latest access time
+    size_t *table_times;   // 0 marks an empty slot
+    size_t table_capacity; // Power of two
+} mrc_t;
+
+// Initialise an empty curve tracking the given share of keys, in (0, 1];
+// returns 0 if the rate is out of range or memory could not be allocated
+extern int mrc_init(mrc_t *mrc, double sample_rate);
+
+// Release the curve's memory
+extern void mrc_destroy(mrc_t *mrc);
+
+// Record an access to the key with this hash; returns 0 if memory ran out
+extern int mrc_access(mrc_t *mrc, uint64_t hash);
+
+// Fraction of accesses an LRU cache holding this many entries would miss
+extern double mrc_miss_ratio(mrc_t *mrc, size_t capacity);
+
+// Estimated number of distinct keys seen
+extern size_t mrc_unique_keys(mrc_t *mrc);
+
+#endif // MISS_RATIO_CURVE_H
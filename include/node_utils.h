@@ -2,22 +2,64 @@
 #define NODE_UTILS_H
 
 #include "key_value_pair.h"
-#include <time.h>
-
-struct LRUCache; 
+#include "slab_allocator.h"
+#include "timer_wheel.h"
 
+// A cache entry is linked into the doubly linked recency list through
+// lprev/lnext; the hash index refers to it by pointer and needs no links.
+// The node, its key and its value are one allocation: the key bytes start
+// right after the header, so a lookup reaches them without another pointer.
 typedef struct Node
 {
-    struct Node *next;
-    struct Node *prev;
-    kv_pair_t *kv_pair;
-    time_t expiration;
+    struct Node *lprev; // More recently used neighbour in the recency list
+    struct Node *lnext; // Less recently used neighbour in the recency list
+    uint64_t expiration;  // Milliseconds on the cache's clock at which the entry expires
+    timer_link_t timer;   // Files the entry in the cache's expiry wheel
+    uint8_t policy_flags; // Eviction policy state, e.g. a CLOCK reference bit
+    uint32_t refs;        // One for the cache while the entry is resident, plus one per handle
+    kv_pair_t kv_pair; // Must stay last: the key and value bytes follow inline
 } Node;
 
+// A doubly linked list of nodes, most recently used first
+typedef struct node_list
+{
+    Node *head;
+    Node *tail;
+} node_list_t;
+
+// Bytes requested from the allocator for a node with the given key and value
+extern size_t node_size_for(size_t key_len, size_t value_len);
+
+// Size of the block a node occupies, derived from its key length and value capacity
+extern size_t node_allocation_size(Node *node);
+
+// Build a node in an already allocated block of block_size bytes
+extern Node *init_node(void *block, size_t block_size, char *key, size_t key_len, uint64_t hash,
+                       char *value, size_t value_len);
+
+// Allocate a node holding copies of the key and value in one block
+extern Node *alloc_node(slab_allocator_t *slabs, char *key, size_t key_len, uint64_t hash,
+                        char *value, size_t value_len);
+
 // Move a node to the front of the doubly linked list
-extern void move_node_to_front(struct LRUCache *cache, Node *node);
+extern void move_node_to_front(node_list_t *list, Node *node);
+
+// Insert a detached node at the front of the doubly linked list
+extern void add_node_to_front(node_list_t *list, Node *node);
+
+// Insert a detached node directly after pos, towards the tail
+extern void insert_node_after(node_list_t *list, Node *pos, Node *node);
+
+// Put a detached node in the list position of another node, unlinking that one
+extern void replace_node_in_list(node_list_t *list, Node *old_node, Node *new_node);
+
+// Unlink a node from the doubly linked list
+extern void remove_node_from_list(node_list_t *list, Node *node);
+
+// Recover the node whose expiry timer link is given
+extern Node *node_from_timer(timer_link_t *link);
 
-// Free the memory allocated for a node
-extern void free_node(Node *node);
+// Return a node's block to the allocator
+extern void free_node(slab_allocator_t *slabs, Node *node);
 
 #endif // NODE_UTILS_H
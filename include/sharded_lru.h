@@ -0,0 +1,141 @@
+#ifndef SHARDED_LRU_H
+#define SHARDED_LRU_H
+
+#include "lru_cache.h"
+#include <pthread.h>
+
+// Upper bound on the number of shards
+#define SHARDED_LRU_MAX_SHARDS 1024
+
+// Flags for sharded_lru_create_with_flags
+#define SHARDED_LRU_LOCKFREE_READS 0x1 // Hits read without the shard lock
+
+// Read buffers: each shard has this many stripes, picked by thread, of this
+// many recorded hits; a reader drains its shard once a stripe holds
+// SHARDED_LRU_DRAIN_THRESHOLD of them
+#define SHARDED_LRU_READ_STRIPES 16
+#define SHARDED_LRU_READ_BUFFER_SIZE 32
+#define SHARDED_LRU_DRAIN_THRESHOLD 16
+
+// A hit waiting to be applied to the recency list
+typedef struct lru_read_entry
+{
+    Node *node;
+    uint64_t hash;
+} lru_read_entry_t;
+
+// Lossy ring of recorded hits. Readers claim slots by advancing tail and
+// drop the record when the ring is full; only the shard lock holder
+// advances head. Readers also count their hits and misses here, since they
+// never touch the shard's own counters.
+typedef struct lru_read_buffer
+{
+    uint64_t head;
+    uint64_t tail;
+    uint64_t hits;
+    uint64_t misses;
+    lru_read_entry_t entries[SHARDED_LRU_READ_BUFFER_SIZE];
+} __attribute__((aligned(64))) lru_read_buffer_t;
+
+// One independent LRUCache and the lock that serialises access to it.
+// Aligned to a cache line so neighbouring shard locks do not false-share.
+typedef struct lru_shard
+{
+    pthread_mutex_t lock;
+    LRUCache *cache;
+    lru_read_buffer_t *read_buffers; // SHARDED_LRU_READ_STRIPES rings in lock-free mode
+} __attribute__((aligned(64))) lru_shard_t;
+
+// Thread-safe front end that routes each key by the top bits of its hash to
+// one of a power-of-two number of shards. Threads working on different
+// shards never contend, and each shard keeps its own statistics.
+//
+// With SHARDED_LRU_LOCKFREE_READS, gets search the index without locking,
+// protected by an epoch domain shared by all shards, and record hits in the
+// shard's read buffers. The recorded promotions are applied in batches by
+// whichever thread next holds the shard lock.
+typedef struct ShardedLRUCache
+{
+    int shard_count;
+    int shard_bits;
+    unsigned flags;
+    hash_fn_t hash_fn;
+    uint64_t hash_seed;
+    lru_shard_t *shards;
+    epoch_domain_t *epoch; // Only in lock-free read mode
+    lru_eviction_listener_t listener; // Told of every shard's removals, NULL for none
+    void *listener_ctx;
+} ShardedLRUCache;
+
+// Totals summed over every shard, in the same form as a single cache's
+typedef lru_cache_stats_t sharded_lru_stats_t;
+
+// Create a sharded cache; capacity is the total across all shards
+extern ShardedLRUCache *sharded_lru_create(int shards, int capacity);
+
+// Create a sharded cache whose shards share one config; capacity and memory_limit are totals
+extern ShardedLRUCache *sharded_lru_create_with_config(int shards, const lru_cache_config_t *config);
+
+// Create a sharded cache with SHARDED_LRU_* flags
+extern ShardedLRUCache *sharded_lru_create_with_flags(int shards, const lru_cache_config_t *config,
+                                                      unsigned flags);
+
+// Copy the value for a key into buf (truncated and NUL-terminated to fit);
+// returns the full value length, or -1 on a miss
+extern long sharded_lru_get(ShardedLRUCache *cache, char *key, char *buf, size_t buf_size);
+
+// Pin the entry for a key so its value can be read in place, without
+// copying, until sharded_lru_release; NULL on a miss. Takes the shard lock
+// even in lock-free read mode.
+extern lru_handle_t *sharded_lru_acquire(ShardedLRUCache *cache, char *key);
+
+// Drop a handle returned by sharded_lru_acquire
+extern void sharded_lru_release(ShardedLRUCache *cache, lru_handle_t *handle);
+
+// Variant of sharded_lru_get for a key of explicit length; binary values
+// are copied whole when they fit, and NUL-terminated either way
+extern long sharded_lru_get_bin(ShardedLRUCache *cache, char *key, size_t key_len, char *buf, size_t buf_size);
+
+// Set a key and value of explicit lengths, which may contain NUL bytes;
+// lengths above KV_PAIR_MAX_LEN are rejected
+extern void sharded_lru_set_bin(ShardedLRUCache *cache, char *key, size_t key_len, char *value,
+                                size_t value_len, uint64_t ttl_ms);
+
+// Set a key-value pair with the default expiration
+extern void sharded_lru_set(ShardedLRUCache *cache, char *key, char *value);
+
+// Set a key-value pair with a custom expiration
+extern void sharded_lru_set_with_expiration(ShardedLRUCache *cache, char *key, char *value, uint64_t ttl_ms);
+
+// Remove a key from its shard; returns 1 if a live entry was removed
+extern int sharded_lru_delete(ShardedLRUCache *cache, char *key);
+
+// Report every shard's removals to fn, as lru_cache_set_eviction_listener
+// does. Each shard queues its own removals, and the thread that completes a
+// batch of them delivers it after releasing the shard lock, so the listener
+// may use the cache, including the same shard. Set it before the cache is
+// shared between threads; sharded_lru_maintenance and sharded_lru_free
+// deliver the partial batches.
+extern void sharded_lru_set_eviction_listener(ShardedLRUCache *cache, lru_eviction_listener_t fn, void *ctx);
+
+// Free every shard
+extern void sharded_lru_free(ShardedLRUCache *cache);
+
+// Sum the statistics of every shard, without taking any shard lock
+extern void sharded_lru_get_stats(ShardedLRUCache *cache, sharded_lru_stats_t *stats);
+
+// Merge the sampled timings of one phase across every shard, without taking
+// any shard lock; returns 0 if built without LRU_CACHE_INSTRUMENT. Lock-free
+// reads are not timed.
+extern int sharded_lru_get_latency(ShardedLRUCache *cache, lru_phase_t phase, lru_latency_histogram_t *histogram);
+
+// Print the aggregated statistics
+extern void sharded_lru_print_stats(ShardedLRUCache *cache);
+
+// Reset the statistics of every shard
+extern void sharded_lru_reset_stats(ShardedLRUCache *cache);
+
+// Apply pending promotions, free retired entries and deliver queued removals in every shard
+extern void sharded_lru_maintenance(ShardedLRUCache *cache);
+
+#endif // SHARDED_LRU_H
@@ -0,0 +1,132 @@
+#ifndef SHM_CACHE_H
+#define SHM_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// An LRU cache whose entries, hash index and recency links all live in one
+// MAP_SHARED file. Links are slot numbers rather than pointers, so every
+// process can map the region at a different address: worker processes on a
+// host share one cache, and a restarted process reattaches to a warm cache
+// without reading or rebuilding anything. A path under /dev/shm keeps the
+// region in memory; any other path also keeps it across reboots.
+//
+// Entries occupy fixed-size slots sized for the largest key plus value the
+// cache accepts. Access is serialised by a robust, process-shared mutex. A
+// process that dies while holding it leaves the recency list and index
+// possibly half-updated, so the next locker rebuilds both from the slots:
+// a write fills a free slot completely and only then marks it live, so the
+// slots themselves are always consistent, and each carries an access stamp
+// from which recency order is recovered.
+
+#define SHM_CACHE_MAGIC "SHMLRU1"
+#define SHM_CACHE_VERSION 1
+
+// Default bytes of key and value a slot holds
+#define SHM_CACHE_DEFAULT_SLOT_SIZE 256
+
+// Slot number standing for "no entry" in links and buckets
+#define SHM_CACHE_NIL UINT32_MAX
+
+// Slot states
+#define SHM_ENTRY_FREE 0
+#define SHM_ENTRY_LIVE 1
+
+// Bytes of /proc/sys/kernel/random/boot_id kept to detect a reboot
+#define SHM_CACHE_BOOT_ID_SIZE 40
+
+// One slot; the key bytes and then the value bytes follow the header
+typedef struct shm_entry
+{
+    uint64_t hash;
+    uint64_t expiration; // Milliseconds of CLOCK_REALTIME, which means the same in every process
+    uint64_t stamp;      // Value of the region's access counter at the last set or hit
+    uint32_t prev;       // More recently used neighbour
+    uint32_t next;       // Less recently used neighbour
+    uint32_t chain;      // Next slot in the same bucket, or in the free list
+    uint32_t key_len;
+    uint32_t value_len;
+    uint32_t state; // SHM_ENTRY_FREE or SHM_ENTRY_LIVE, written last on a set
+    char data[];
+} shm_entry_t;
+
+// Start of the region: its geometry, shared lock and list ends. The bucket
+// array follows, then the slots.
+typedef struct shm_cache_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t capacity;     // Slots
+    uint32_t bucket_count; // Power of two
+    uint32_t slot_size;    // Bytes of key and value per slot
+    uint64_t slot_stride;  // Bytes from one slot to the next
+    uint64_t region_size;
+    uint64_t hash_seed;
+    char boot_id[SHM_CACHE_BOOT_ID_SIZE]; // Boot the lock was last initialised in
+    pthread_mutex_t lock;
+    uint32_t head;      // Most recently used slot
+    uint32_t tail;      // Least recently used slot
+    uint32_t free_head; // First slot of the free list
+    uint32_t unused;    // Slots from here on have never held an entry
+    uint32_t size;      // Live entries
+    uint64_t stamp;     // Access counter
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t recoveries; // Rebuilds after a lock holder died
+} shm_cache_header_t;
+
+// A process's view of a region
+typedef struct shm_cache
+{
+    shm_cache_header_t *header;
+    uint32_t *buckets;
+    char *slots;
+    size_t region_size;
+    int fd;
+} shm_cache_t;
+
+// Geometry used when a region is created; an existing region keeps its own
+typedef struct shm_cache_config
+{
+    uint32_t capacity;  // Maximum number of entries
+    uint32_t slot_size; // Largest key plus value accepted, in bytes
+} shm_cache_config_t;
+
+typedef struct shm_cache_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t recoveries;
+    uint32_t size;
+    uint32_t capacity;
+} shm_cache_stats_t;
+
+// Fill a config with a capacity and the default slot size
+extern void shm_cache_config_init(shm_cache_config_t *config, uint32_t capacity);
+
+// Attach to the region in the file at path, creating and sizing it from the
+// config if it does not exist yet; NULL on failure
+extern shm_cache_t *shm_cache_open(const char *path, const shm_cache_config_t *config);
+
+// Detach from the region; the entries stay for the next process
+extern void shm_cache_close(shm_cache_t *cache);
+
+// Copy the value for a key into buf (truncated and NUL-terminated to fit);
+// returns the full value length, or -1 on a miss
+extern long shm_cache_get(shm_cache_t *cache, char *key, size_t key_len, char *buf, size_t buf_size);
+
+// Insert or update a key, evicting the least recently used entry when the
+// region is full; returns 0 if the key and value do not fit in a slot
+extern int shm_cache_set(shm_cache_t *cache, char *key, size_t key_len, char *value, size_t value_len,
+                         uint64_t ttl_ms);
+
+// Remove a key; returns 0 if it was not cached
+extern int shm_cache_delete(shm_cache_t *cache, char *key, size_t key_len);
+
+// Read the region's counters
+extern void shm_cache_get_stats(shm_cache_t *cache, shm_cache_stats_t *stats);
+
+#endif // SHM_CACHE_H
@@ -0,0 +1,99 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <stddef.h>
+
+// Upper bound on the number of size classes
+#define SLAB_MAX_CLASSES 64
+
+// Smallest chunk handed out and the growth factor between classes
+#define SLAB_MIN_CHUNK_SIZE 64
+#define SLAB_GROWTH_FACTOR 1.25
+
+// Default size of the pages carved into chunks; also the largest chunk size
+#define SLAB_DEFAULT_PAGE_SIZE (1024 * 1024)
+
+// One size class: fixed-size chunks carved from whole pages
+typedef struct slab_class
+{
+    size_t chunk_size;   // Bytes per chunk
+    void *free_list;     // Freed chunks, linked through their first word
+    char *carve_next;    // Next never-used chunk in the newest page
+    size_t carve_left;   // Never-used chunks left in the newest page
+    size_t pages;        // Pages assigned to this class
+    size_t total_chunks; // Chunks in those pages
+    size_t used_chunks;  // Chunks currently handed out
+} slab_class_t;
+
+// A page handed to a class; the map of them is kept sorted by address so the
+// page holding any chunk can be found
+typedef struct slab_page
+{
+    char *base;
+    int class_id;
+} slab_page_t;
+
+// Per-cache slab allocator in the style of memcached: requests are rounded up
+// to the nearest size class and served from that class's free list, so memory
+// released by an eviction is reused by the next insert of a similar size
+// without going back to the system allocator. Requests larger than a page
+// fall through to malloc. Under a memory limit a page can be moved from one
+// class to another once every chunk on it is free, as memcached's
+// slab_reassign does, so a shift in entry sizes is not stuck with the classes
+// that first took the memory.
+typedef struct slab_allocator
+{
+    slab_class_t classes[SLAB_MAX_CLASSES];
+    int class_count;
+    size_t page_size;
+    size_t memory_limit;     // Maximum bytes in pages plus large allocations, 0 for unlimited
+    size_t memory_allocated; // Bytes currently reserved in pages and large allocations
+    char *prealloc_base;     // Region reserved up front when preallocating
+    size_t prealloc_pages;   // Pages in that region
+    size_t prealloc_next;    // Next page of the region not yet assigned to a class
+    void **pages;            // Individually allocated pages, freed on destroy
+    size_t page_count;
+    size_t page_capacity;
+    slab_page_t *page_map;   // Every page assigned to a class, sorted by address
+    size_t page_map_count;
+    size_t page_map_capacity;
+    size_t large_count;      // Live allocations that bypassed the size classes
+    size_t large_bytes;
+} slab_allocator_t;
+
+// Initialise an allocator; with preallocate set, memory_limit bytes are reserved immediately
+extern int slab_init(slab_allocator_t *slabs, size_t page_size, size_t memory_limit, int preallocate);
+
+// Release every page owned by the allocator
+extern void slab_destroy(slab_allocator_t *slabs);
+
+// Index of the class serving a request of the given size, or -1 if it is larger than a page
+extern int slab_class_for(slab_allocator_t *slabs, size_t size);
+
+// Usable size of the block returned for a request of the given size
+extern size_t slab_chunk_size(slab_allocator_t *slabs, size_t size);
+
+// Allocate a block; returns NULL when the memory limit leaves no room for it
+extern void *slab_alloc(slab_allocator_t *slabs, size_t size);
+
+// Return a block; size must be the value passed to slab_alloc or its chunk size
+extern void slab_free(slab_allocator_t *slabs, void *ptr, size_t size);
+
+// Page of a class other than the one serving size with the fewest chunks in
+// use; NULL if there is none or the request is larger than a page
+extern void *slab_pick_donor_page(slab_allocator_t *slabs, size_t size);
+
+// Call fn on every chunk of a page that is currently handed out; returns 0 if
+// page is not a page of the allocator or memory for the scan ran out
+extern int slab_for_each_used_chunk(slab_allocator_t *slabs, void *page,
+                                    void (*fn)(void *ctx, void *chunk), void *ctx);
+
+// Move a page to the class serving size; returns 0 while a chunk on it is
+// still in use. Does nothing, successfully, if that class already has a
+// chunk to hand out
+extern int slab_reassign(slab_allocator_t *slabs, void *page, size_t size);
+
+// Print per-class occupancy
+extern void slab_print_stats(slab_allocator_t *slabs);
+
+#endif // SLAB_ALLOCATOR_H
@@ -0,0 +1,53 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hierarchical timing wheel: four levels of 64 slots, each level's slot
+// spanning a whole rotation of the level below, so deadlines up to 64^4
+// ticks ahead are placed in O(1). Entries move down a level at most once per
+// level as the wheel turns and end on the due list once their tick passes.
+// A bitmap of occupied slots per level lets the wheel jump straight to the
+// next slot holding timers, so idle stretches cost nothing however fine the
+// tick.
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+// Intrusive link embedded in each scheduled object; unlinked when next is NULL
+typedef struct timer_link
+{
+    struct timer_link *prev;
+    struct timer_link *next;
+    uint64_t deadline; // First tick at which the timer is due
+} timer_link_t;
+
+typedef struct timer_wheel
+{
+    uint64_t now; // Last tick processed
+    timer_link_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]; // Circular lists with sentinel heads
+    uint64_t occupied[TIMER_WHEEL_LEVELS]; // Slots that may hold timers; cleared when found empty
+    timer_link_t due;   // Timers whose deadline has passed, in the order they fell due
+    size_t scheduled;   // Timers still in the slots
+} timer_wheel_t;
+
+// Initialise an empty wheel whose last processed tick is now
+extern void timer_wheel_init(timer_wheel_t *wheel, uint64_t now);
+
+// Schedule a timer, first cancelling it if it is already scheduled
+extern void timer_wheel_schedule(timer_wheel_t *wheel, timer_link_t *link, uint64_t deadline);
+
+// Remove a timer from the wheel or the due list; does nothing if it is unlinked
+extern void timer_wheel_cancel(timer_wheel_t *wheel, timer_link_t *link);
+
+// Turn the wheel up to now, moving timers that fall due to the due list.
+// Stops early, between occupied slots, once about budget timers have been
+// moved; returns the number moved.
+extern size_t timer_wheel_advance(timer_wheel_t *wheel, uint64_t now, size_t budget);
+
+// Oldest timer on the due list, or NULL
+extern timer_link_t *timer_wheel_first_due(timer_wheel_t *wheel);
+
+#endif // TIMER_WHEEL_H
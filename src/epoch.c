@@ -0,0 +1,111 @@
+#include "epoch.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Process-wide allocation of thread ids, shared by every domain
+static uint64_t thread_id_bitmap[EPOCH_MAX_THREADS / 64];
+static pthread_key_t thread_id_key;
+static pthread_once_t thread_id_once = PTHREAD_ONCE_INIT;
+static __thread int thread_id = -1;
+
+// Returns a thread's id to the pool when the thread exits
+static void release_thread_id(void *value)
+{
+    int id = (int)(intptr_t)value - 1;
+    __atomic_fetch_and(&thread_id_bitmap[id / 64], ~(1ULL << (id % 64)), __ATOMIC_RELEASE);
+}
+
+static void create_thread_id_key(void)
+{
+    pthread_key_create(&thread_id_key, release_thread_id);
+}
+
+// Claims the lowest free id on first use and remembers it for the thread's lifetime
+int epoch_thread_id(void)
+{
+    if (thread_id >= 0)
+    {
+        return thread_id;
+    }
+
+    pthread_once(&thread_id_once, create_thread_id_key);
+
+    for (int word = 0; word < EPOCH_MAX_THREADS / 64; word++)
+    {
+        uint64_t bits = __atomic_load_n(&thread_id_bitmap[word], __ATOMIC_RELAXED);
+        while (~bits)
+        {
+            int bit = __builtin_ctzll(~bits);
+            if (__atomic_compare_exchange_n(&thread_id_bitmap[word], &bits, bits | (1ULL << bit),
+                                            0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            {
+                thread_id = word * 64 + bit;
+                pthread_setspecific(thread_id_key, (void *)(intptr_t)(thread_id + 1));
+                return thread_id;
+            }
+        }
+    }
+
+    // More live threads than slots is a configuration error
+    abort();
+}
+
+// Starts the domain at epoch 1 so that 0 can mean "not in a read section"
+void epoch_init(epoch_domain_t *domain)
+{
+    memset(domain, 0, sizeof(*domain));
+    domain->global_epoch = 1;
+}
+
+// Announces the current epoch before any shared pointer is loaded
+void epoch_enter(epoch_domain_t *domain, int id)
+{
+    uint64_t epoch = __atomic_load_n(&domain->global_epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&domain->slots[id].epoch, epoch, __ATOMIC_SEQ_CST);
+}
+
+// Withdraws the announcement once no shared pointer is in use
+void epoch_exit(epoch_domain_t *domain, int id)
+{
+    __atomic_store_n(&domain->slots[id].epoch, 0, __ATOMIC_RELEASE);
+}
+
+uint64_t epoch_current(epoch_domain_t *domain)
+{
+    return __atomic_load_n(&domain->global_epoch, __ATOMIC_SEQ_CST);
+}
+
+// Scans the announcements; when every active reader has caught up with the
+// global epoch it is advanced, so retired objects age out even under load
+uint64_t epoch_reclaim_bound(epoch_domain_t *domain)
+{
+    uint64_t global = __atomic_load_n(&domain->global_epoch, __ATOMIC_SEQ_CST);
+    uint64_t oldest = global;
+    int lagging = 0;
+
+    for (int i = 0; i < EPOCH_MAX_THREADS; i++)
+    {
+        uint64_t epoch = __atomic_load_n(&domain->slots[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch == 0)
+        {
+            continue;
+        }
+        if (epoch < oldest)
+        {
+            oldest = epoch;
+        }
+        if (epoch != global)
+        {
+            lagging = 1;
+        }
+    }
+
+    if (!lagging)
+    {
+        __atomic_compare_exchange_n(&domain->global_epoch, &global, global + 1, 0,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+
+    return oldest;
+}
@@ -0,0 +1,604 @@
+#include "eviction_policy.h"
+#include "lru_cache.h" // Include full definition of LRUCache
+
+// List an entry is on
+static inline int node_segment(Node *node)
+{
+    return (node->policy_flags & NODE_SEGMENT_MASK) >> NODE_SEGMENT_SHIFT;
+}
+
+node_list_t *policy_list(LRUCache *cache, int segment)
+{
+    return segment == 0 ? &cache->list : &cache->segments[segment - 1];
+}
+
+// Links an entry at the front of a list and records which list it is on
+static void segment_push_front(LRUCache *cache, int segment, Node *node)
+{
+    node->policy_flags = (uint8_t)((node->policy_flags & ~NODE_SEGMENT_MASK) |
+                                   (segment << NODE_SEGMENT_SHIFT));
+    add_node_to_front(policy_list(cache, segment), node);
+    cache->segment_size[segment]++;
+}
+
+// Links an entry at the tail of a list and records which list it is on
+static void segment_push_back(LRUCache *cache, int segment, Node *node)
+{
+    node_list_t *list = policy_list(cache, segment);
+
+    node->policy_flags = (uint8_t)((node->policy_flags & ~NODE_SEGMENT_MASK) |
+                                   (segment << NODE_SEGMENT_SHIFT));
+    if (list->tail)
+    {
+        insert_node_after(list, list->tail, node);
+    }
+    else
+    {
+        add_node_to_front(list, node);
+    }
+    cache->segment_size[segment]++;
+}
+
+static void segment_unlink(LRUCache *cache, Node *node)
+{
+    int segment = node_segment(node);
+    remove_node_from_list(policy_list(cache, segment), node);
+    cache->segment_size[segment]--;
+}
+
+// Moves an entry to the front of another list
+static void segment_move(LRUCache *cache, Node *node, int segment)
+{
+    segment_unlink(cache, node);
+    segment_push_front(cache, segment, node);
+}
+
+// Least recently used entry of a list other than keep
+static inline Node *tail_except(node_list_t *list, Node *keep)
+{
+    Node *node = list->tail;
+    return node == keep && node ? node->lprev : node;
+}
+
+// The CLOCK hand sweeps from the tail towards the head and wraps around; a
+// NULL hand stands for the tail. Entries are inserted just behind the hand,
+// so a new entry is the last one the sweep reaches.
+
+// Next position of the hand after a node
+static inline Node *clock_advance(LRUCache *cache, Node *node)
+{
+    return node->lprev ? node->lprev : cache->list.tail;
+}
+
+// Links a node just behind the hand
+static void clock_insert(LRUCache *cache, Node *node)
+{
+    if (cache->hand)
+    {
+        insert_node_after(&cache->list, cache->hand, node);
+        cache->segment_size[0]++;
+    }
+    else
+    {
+        segment_push_front(cache, 0, node);
+    }
+}
+
+// Clears reference bits until an unreferenced entry is under the hand
+static Node *clock_victim(LRUCache *cache, Node *keep)
+{
+    Node *node = cache->hand ? cache->hand : cache->list.tail;
+
+    // Two passes clear every bit, so a victim is found within them
+    for (int steps = 0; node && steps <= 2 * cache->size; steps++)
+    {
+        if (node != keep)
+        {
+            if (!(node->policy_flags & NODE_REFERENCED))
+            {
+                cache->hand = node;
+                return node;
+            }
+            node->policy_flags &= ~NODE_REFERENCED;
+        }
+        node = clock_advance(cache, node);
+    }
+
+    return NULL;
+}
+
+// Resident entries CLOCK-Pro may keep hot: all but its adaptive cold share
+static inline size_t clock_pro_hot_target(LRUCache *cache)
+{
+    size_t size = (size_t)cache->size;
+    return size > cache->cold_target ? size - cache->cold_target : 0;
+}
+
+// Moves the first unreferenced hot entry the hot hand reaches to the front
+// of the cold list, clearing reference bits on the way; returns 0 if every
+// hot entry is keep
+static int clock_pro_demote(LRUCache *cache, Node *keep)
+{
+    Node *node = cache->hand ? cache->hand : cache->list.tail;
+
+    for (int steps = 0; node && steps <= 2 * cache->segment_size[CLOCK_PRO_HOT]; steps++)
+    {
+        Node *next = clock_advance(cache, node);
+
+        if (node != keep)
+        {
+            if (!(node->policy_flags & NODE_REFERENCED))
+            {
+                cache->hand = next == node ? NULL : next;
+                segment_unlink(cache, node);
+                node->policy_flags = 0;
+                cache->hot_count--;
+                segment_push_front(cache, CLOCK_PRO_COLD, node);
+                return 1;
+            }
+            node->policy_flags &= ~NODE_REFERENCED;
+        }
+        node = next;
+    }
+
+    return 0;
+}
+
+// Links an entry into the hot clock just behind the hot hand
+static void clock_pro_make_hot(LRUCache *cache, Node *node)
+{
+    node->policy_flags = NODE_HOT;
+    cache->hot_count++;
+    clock_insert(cache, node);
+}
+
+// An approximation of CLOCK-Pro with its hot entries on the main list,
+// swept by the hot hand, and its cold entries on a FIFO list. Cold entries
+// that were hit before they reach the end of the cold list become hot;
+// unreferenced ones are evicted and their hashes kept as ghosts for one more
+// cache's worth of evictions (the test period). A key that returns while
+// still a ghost is admitted hot and grows the cold share, since cold entries
+// were evicted too early; a ghost that ages out shrinks it. The hot hand
+// only demotes entries when there are more hot entries than the hot share
+// allows, so a scan of keys used once passes through the cold list without
+// displacing the hot ones.
+static Node *clock_pro_victim(LRUCache *cache, Node *keep)
+{
+    node_list_t *cold = policy_list(cache, CLOCK_PRO_COLD);
+
+    for (;;)
+    {
+        Node *node = tail_except(cold, keep);
+        if (!node)
+        {
+            if (!clock_pro_demote(cache, keep))
+            {
+                return NULL;
+            }
+            continue;
+        }
+
+        if (node->policy_flags & NODE_REFERENCED)
+        {
+            segment_unlink(cache, node);
+            clock_pro_make_hot(cache, node);
+            while (cache->hot_count > clock_pro_hot_target(cache) && clock_pro_demote(cache, keep))
+            {
+            }
+            continue;
+        }
+
+        size_t aged_out = ghost_list_push(&cache->ghosts, node->kv_pair.hash, (size_t)cache->size);
+        cache->cold_target = cache->cold_target > aged_out + 1 ? cache->cold_target - aged_out : 1;
+        return node;
+    }
+}
+
+// Entries the policy divides between its segments. A cache bounded only by
+// bytes has no fixed count, so its current size stands in for it.
+static inline int policy_capacity(LRUCache *cache)
+{
+    return cache->capacity > 0 ? cache->capacity : cache->size;
+}
+
+static inline int tinylfu_window_target(LRUCache *cache)
+{
+    int target = policy_capacity(cache) * TINYLFU_WINDOW_PERCENT / 100;
+    return target > 0 ? target : 1;
+}
+
+static inline int tinylfu_protected_target(LRUCache *cache)
+{
+    return (policy_capacity(cache) - tinylfu_window_target(cache)) * TINYLFU_PROTECTED_PERCENT / 100;
+}
+
+// Demotes protected entries beyond the segment's share back to probation
+static void tinylfu_balance_protected(LRUCache *cache)
+{
+    while (cache->segment_size[TINYLFU_PROTECTED] > tinylfu_protected_target(cache))
+    {
+        segment_move(cache, policy_list(cache, TINYLFU_PROTECTED)->tail, TINYLFU_PROBATION);
+    }
+}
+
+// New entries always enter the window. Once the window holds its share, the
+// entry leaving it is a candidate for the main region and competes with the
+// main region's victim: it is only admitted if the sketch has seen it more
+// often, so keys read once cannot push out keys that are used repeatedly.
+static Node *tinylfu_victim(LRUCache *cache, Node *keep)
+{
+    Node *victim = tail_except(policy_list(cache, TINYLFU_PROBATION), keep);
+    if (!victim)
+    {
+        victim = tail_except(policy_list(cache, TINYLFU_PROTECTED), keep);
+    }
+
+    Node *candidate = NULL;
+    if (cache->segment_size[TINYLFU_WINDOW] >= tinylfu_window_target(cache))
+    {
+        candidate = tail_except(policy_list(cache, TINYLFU_WINDOW), keep);
+    }
+
+    if (!candidate)
+    {
+        return victim ? victim : tail_except(policy_list(cache, TINYLFU_WINDOW), keep);
+    }
+    if (!victim)
+    {
+        return candidate;
+    }
+
+    if (sketch_estimate(&cache->sketch, candidate->kv_pair.hash) >
+        sketch_estimate(&cache->sketch, victim->kv_pair.hash))
+    {
+        segment_move(cache, candidate, TINYLFU_PROBATION);
+        return victim;
+    }
+
+    return candidate;
+}
+
+static void tinylfu_insert(LRUCache *cache, Node *node)
+{
+    // Caches bounded only by bytes grow the sketch with their entry count
+    if (cache->capacity == 0 && (size_t)cache->size > cache->sketch.capacity)
+    {
+        sketch_ensure_capacity(&cache->sketch, 2 * (size_t)cache->size);
+    }
+
+    sketch_increment(&cache->sketch, node->kv_pair.hash);
+    node->policy_flags = 0;
+    segment_push_front(cache, TINYLFU_WINDOW, node);
+
+    // While the cache is filling up nothing is evicted, so the window simply
+    // overflows into probation
+    while (cache->segment_size[TINYLFU_WINDOW] > tinylfu_window_target(cache))
+    {
+        segment_move(cache, policy_list(cache, TINYLFU_WINDOW)->tail, TINYLFU_PROBATION);
+    }
+}
+
+static void tinylfu_hit(LRUCache *cache, Node *node)
+{
+    sketch_increment(&cache->sketch, node->kv_pair.hash);
+
+    if (node_segment(node) == TINYLFU_PROBATION)
+    {
+        segment_move(cache, node, TINYLFU_PROTECTED);
+        tinylfu_balance_protected(cache);
+    }
+    else
+    {
+        move_node_to_front(policy_list(cache, node_segment(node)), node);
+    }
+}
+
+// Ghosts that are still live; removed hashes may linger in the ring
+static inline size_t ghost_count(ghost_list_t *ghosts)
+{
+    return ghosts->set_size;
+}
+
+// Adapts the T1 target when a new key is found among the ghosts: a hit in
+// B1 means T1 was too small, a hit in B2 that T2 was. The step is larger
+// when the other ghost list is bigger, as in the original ARC. The evictions
+// that make room already follow the new target, but the ghost is only
+// consumed once the entry is stored; a dropped insert puts the target back.
+static void arc_before_insert(LRUCache *cache, uint64_t hash)
+{
+    size_t capacity = (size_t)policy_capacity(cache);
+    size_t b1 = ghost_count(&cache->ghosts);
+    size_t b2 = ghost_count(&cache->frequent_ghosts);
+
+    cache->arc_incoming = ARC_GHOST_NONE;
+    cache->arc_saved_target = cache->arc_target;
+
+    if (ghost_list_contains(&cache->ghosts, hash))
+    {
+        size_t step = b2 > b1 ? b2 / b1 : 1;
+        cache->arc_target = cache->arc_target + step < capacity ? cache->arc_target + step : capacity;
+        cache->arc_incoming = ARC_GHOST_B1;
+    }
+    else if (ghost_list_contains(&cache->frequent_ghosts, hash))
+    {
+        size_t step = b1 > b2 ? b1 / b2 : 1;
+        cache->arc_target = cache->arc_target > step ? cache->arc_target - step : 0;
+        cache->arc_incoming = ARC_GHOST_B2;
+    }
+}
+
+// ARC's REPLACE: evict from T1 while it is over its target, otherwise from
+// T2, and remember the evicted hash in the matching ghost list. Each ghost
+// list is bounded so that it and its resident list hold at most one cache's
+// worth of keys, which keeps the total at twice the capacity.
+static Node *arc_victim(LRUCache *cache, Node *keep)
+{
+    Node *t1 = tail_except(policy_list(cache, ARC_T1), keep);
+    Node *t2 = tail_except(policy_list(cache, ARC_T2), keep);
+    size_t t1_size = (size_t)cache->segment_size[ARC_T1];
+    size_t capacity = (size_t)policy_capacity(cache);
+
+    if (t1 && (!t2 || t1_size > cache->arc_target ||
+               (cache->arc_incoming == ARC_GHOST_B2 && t1_size == cache->arc_target)))
+    {
+        size_t limit = capacity > t1_size ? capacity - t1_size : 1;
+        ghost_list_push(&cache->ghosts, t1->kv_pair.hash, limit);
+        return t1;
+    }
+
+    if (t2)
+    {
+        size_t t2_size = (size_t)cache->segment_size[ARC_T2];
+        size_t limit = capacity > t2_size ? capacity - t2_size : 1;
+        ghost_list_push(&cache->frequent_ghosts, t2->kv_pair.hash, limit);
+    }
+    return t2;
+}
+
+int policy_init(LRUCache *cache, lru_policy_t policy)
+{
+    cache->policy = policy;
+    cache->hand = NULL;
+    cache->hot_count = 0;
+    cache->cold_target = 1;
+
+    switch (policy)
+    {
+    case LRU_POLICY_LRU:
+    case LRU_POLICY_CLOCK:
+        return 1;
+    case LRU_POLICY_CLOCK_PRO:
+        return ghost_list_init(&cache->ghosts);
+    case LRU_POLICY_TINYLFU:
+        return sketch_init(&cache->sketch, cache->capacity > 0 ? (size_t)cache->capacity : 0);
+    case LRU_POLICY_ARC:
+        cache->arc_target = 0;
+        cache->arc_saved_target = 0;
+        cache->arc_incoming = ARC_GHOST_NONE;
+        if (!ghost_list_init(&cache->ghosts))
+        {
+            return 0;
+        }
+        if (!ghost_list_init(&cache->frequent_ghosts))
+        {
+            ghost_list_destroy(&cache->ghosts);
+            return 0;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+void policy_destroy(LRUCache *cache)
+{
+    if (cache->policy == LRU_POLICY_CLOCK_PRO)
+    {
+        ghost_list_destroy(&cache->ghosts);
+    }
+    else if (cache->policy == LRU_POLICY_TINYLFU)
+    {
+        sketch_destroy(&cache->sketch);
+    }
+    else if (cache->policy == LRU_POLICY_ARC)
+    {
+        ghost_list_destroy(&cache->ghosts);
+        ghost_list_destroy(&cache->frequent_ghosts);
+    }
+}
+
+size_t policy_memory_usage(LRUCache *cache)
+{
+    switch (cache->policy)
+    {
+    case LRU_POLICY_LRU:
+    case LRU_POLICY_CLOCK:
+        break;
+    case LRU_POLICY_CLOCK_PRO:
+        return (cache->ghosts.ring_capacity + cache->ghosts.set_capacity) * sizeof(ghost_entry_t);
+    case LRU_POLICY_TINYLFU:
+        return (cache->sketch.mask + 1) * sizeof(uint64_t);
+    case LRU_POLICY_ARC:
+        return (cache->ghosts.ring_capacity + cache->ghosts.set_capacity +
+                cache->frequent_ghosts.ring_capacity + cache->frequent_ghosts.set_capacity) *
+               sizeof(ghost_entry_t);
+    }
+
+    return 0;
+}
+
+void policy_before_insert(LRUCache *cache, uint64_t hash)
+{
+    if (cache->policy == LRU_POLICY_ARC)
+    {
+        arc_before_insert(cache, hash);
+    }
+}
+
+void policy_on_insert(LRUCache *cache, Node *node)
+{
+    switch (cache->policy)
+    {
+    case LRU_POLICY_LRU:
+        segment_push_front(cache, 0, node);
+        break;
+    case LRU_POLICY_CLOCK:
+        node->policy_flags = 0;
+        clock_insert(cache, node);
+        break;
+    case LRU_POLICY_CLOCK_PRO:
+        node->policy_flags = 0;
+        if (ghost_list_remove(&cache->ghosts, node->kv_pair.hash))
+        {
+            clock_pro_make_hot(cache, node);
+            if (cache->cold_target < (size_t)cache->size)
+            {
+                cache->cold_target++;
+            }
+        }
+        else
+        {
+            segment_push_front(cache, CLOCK_PRO_COLD, node);
+        }
+        break;
+    case LRU_POLICY_TINYLFU:
+        tinylfu_insert(cache, node);
+        break;
+    case LRU_POLICY_ARC:
+        // A key found among the ghosts has been used twice and goes to T2
+        node->policy_flags = 0;
+        if (cache->arc_incoming == ARC_GHOST_B1)
+        {
+            ghost_list_remove(&cache->ghosts, node->kv_pair.hash);
+        }
+        else if (cache->arc_incoming == ARC_GHOST_B2)
+        {
+            ghost_list_remove(&cache->frequent_ghosts, node->kv_pair.hash);
+        }
+        segment_push_front(cache, cache->arc_incoming == ARC_GHOST_NONE ? ARC_T1 : ARC_T2, node);
+        cache->arc_incoming = ARC_GHOST_NONE;
+        break;
+    }
+}
+
+void policy_abort_insert(LRUCache *cache)
+{
+    if (cache->policy == LRU_POLICY_ARC && cache->arc_incoming != ARC_GHOST_NONE)
+    {
+        cache->arc_target = cache->arc_saved_target;
+        cache->arc_incoming = ARC_GHOST_NONE;
+    }
+}
+
+void policy_on_restore(LRUCache *cache, Node *node, int segment, uint8_t flags)
+{
+    switch (cache->policy)
+    {
+    case LRU_POLICY_LRU:
+    case LRU_POLICY_CLOCK:
+        segment = 0;
+        break;
+    case LRU_POLICY_CLOCK_PRO:
+        segment = segment == CLOCK_PRO_HOT ? CLOCK_PRO_HOT : CLOCK_PRO_COLD;
+        break;
+    case LRU_POLICY_TINYLFU:
+        // The sketch starts empty, so each restored key counts as seen once
+        if (cache->capacity == 0 && (size_t)cache->size > cache->sketch.capacity)
+        {
+            sketch_ensure_capacity(&cache->sketch, 2 * (size_t)cache->size);
+        }
+        sketch_increment(&cache->sketch, node->kv_pair.hash);
+        segment = segment >= 0 && segment < LRU_POLICY_LISTS ? segment : TINYLFU_PROBATION;
+        break;
+    case LRU_POLICY_ARC:
+        segment = segment == ARC_T2 ? ARC_T2 : ARC_T1;
+        break;
+    }
+
+    // Only the CLOCK reference bit carries over; hot entries are exactly
+    // those on CLOCK-Pro's hot list
+    node->policy_flags = 0;
+    if (cache->policy == LRU_POLICY_CLOCK || cache->policy == LRU_POLICY_CLOCK_PRO)
+    {
+        node->policy_flags = flags & NODE_REFERENCED;
+    }
+    if (cache->policy == LRU_POLICY_CLOCK_PRO && segment == CLOCK_PRO_HOT)
+    {
+        node->policy_flags |= NODE_HOT;
+        cache->hot_count++;
+    }
+
+    segment_push_back(cache, segment, node);
+}
+
+void policy_on_hit(LRUCache *cache, Node *node)
+{
+    if (cache->policy == LRU_POLICY_LRU)
+    {
+        move_node_to_front(&cache->list, node);
+    }
+    else if (cache->policy == LRU_POLICY_TINYLFU)
+    {
+        tinylfu_hit(cache, node);
+    }
+    else if (cache->policy == LRU_POLICY_ARC)
+    {
+        if (node_segment(node) == ARC_T2)
+        {
+            move_node_to_front(policy_list(cache, ARC_T2), node);
+        }
+        else
+        {
+            segment_move(cache, node, ARC_T2);
+        }
+    }
+    else if (!(node->policy_flags & NODE_REFERENCED))
+    {
+        // Skip the store when the bit is already set to keep the line clean
+        node->policy_flags |= NODE_REFERENCED;
+    }
+}
+
+void policy_on_remove(LRUCache *cache, Node *node)
+{
+    if (cache->hand == node)
+    {
+        cache->hand = node->lprev;
+    }
+    if (node->policy_flags & NODE_HOT)
+    {
+        cache->hot_count--;
+    }
+
+    segment_unlink(cache, node);
+}
+
+void policy_on_replace(LRUCache *cache, Node *old_node, Node *new_node)
+{
+    new_node->policy_flags = old_node->policy_flags;
+    if (cache->hand == old_node)
+    {
+        cache->hand = new_node;
+    }
+
+    replace_node_in_list(policy_list(cache, node_segment(old_node)), old_node, new_node);
+}
+
+Node *policy_victim(LRUCache *cache, Node *keep)
+{
+    switch (cache->policy)
+    {
+    case LRU_POLICY_CLOCK:
+        return clock_victim(cache, keep);
+    case LRU_POLICY_CLOCK_PRO:
+        return clock_pro_victim(cache, keep);
+    case LRU_POLICY_TINYLFU:
+        return tinylfu_victim(cache, keep);
+    case LRU_POLICY_ARC:
+        return arc_victim(cache, keep);
+    case LRU_POLICY_LRU:
+        break;
+    }
+
+    return tail_except(&cache->list, keep);
+}
@@ -0,0 +1,118 @@
+#include "frequency_sketch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SKETCH_DEPTH 4
+#define SKETCH_MIN_WORDS 64
+
+// One odd multiplier per row so each row sees an independent spreading of the key hash
+static const uint64_t sketch_seeds[SKETCH_DEPTH] = {
+    0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+
+// Word and nibble of a key's counter in one row
+static inline void locate(frequency_sketch_t *sketch, uint64_t hash, int row, size_t *word, int *shift)
+{
+    uint64_t h = (hash ^ (hash >> 29)) * sketch_seeds[row];
+    h ^= h >> 32;
+    *word = (size_t)h & sketch->mask;
+    *shift = (int)((h >> 40) & 15) * 4;
+}
+
+// Halves every counter; the mask drops the bit shifted in from the next nibble
+static void age(frequency_sketch_t *sketch)
+{
+    for (size_t i = 0; i <= sketch->mask; i++)
+    {
+        sketch->table[i] = (sketch->table[i] >> 1) & 0x7777777777777777ULL;
+    }
+    sketch->additions /= 2;
+}
+
+int sketch_init(frequency_sketch_t *sketch, size_t capacity)
+{
+    size_t words = SKETCH_MIN_WORDS;
+    while (words < capacity)
+    {
+        words *= 2;
+    }
+
+    sketch->table = calloc(words, sizeof(uint64_t));
+    if (!sketch->table)
+    {
+        return 0;
+    }
+
+    sketch->mask = words - 1;
+    sketch->capacity = capacity;
+    sketch->sample_size = 10 * (capacity > 0 ? capacity : 1);
+    sketch->additions = 0;
+    return 1;
+}
+
+void sketch_destroy(frequency_sketch_t *sketch)
+{
+    free(sketch->table);
+    sketch->table = NULL;
+}
+
+void sketch_increment(frequency_sketch_t *sketch, uint64_t hash)
+{
+    int added = 0;
+
+    for (int row = 0; row < SKETCH_DEPTH; row++)
+    {
+        size_t word;
+        int shift;
+        locate(sketch, hash, row, &word, &shift);
+
+        if (((sketch->table[word] >> shift) & 15) < SKETCH_MAX_COUNT)
+        {
+            sketch->table[word] += 1ULL << shift;
+            added = 1;
+        }
+    }
+
+    // Saturated keys do not count towards the sample
+    if (added && ++sketch->additions >= sketch->sample_size)
+    {
+        age(sketch);
+    }
+}
+
+int sketch_estimate(frequency_sketch_t *sketch, uint64_t hash)
+{
+    int estimate = SKETCH_MAX_COUNT;
+
+    for (int row = 0; row < SKETCH_DEPTH; row++)
+    {
+        size_t word;
+        int shift;
+        locate(sketch, hash, row, &word, &shift);
+
+        int count = (int)((sketch->table[word] >> shift) & 15);
+        if (count < estimate)
+        {
+            estimate = count;
+        }
+    }
+
+    return estimate;
+}
+
+int sketch_ensure_capacity(frequency_sketch_t *sketch, size_t capacity)
+{
+    if (capacity <= sketch->capacity)
+    {
+        return 1;
+    }
+
+    frequency_sketch_t grown;
+    if (!sketch_init(&grown, capacity))
+    {
+        return 0;
+    }
+
+    sketch_destroy(sketch);
+    *sketch = grown;
+    return 1;
+}
@@ -0,0 +1,232 @@
+#include "ghost_list.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GHOST_INITIAL_CAPACITY 64
+
+// Zero marks an empty set slot, so a zero hash is stored as 1
+static inline uint64_t ghost_key(uint64_t hash)
+{
+    return hash ? hash : 1;
+}
+
+// Home slot of a hash in the set; the low bits of the hash are well mixed
+static inline size_t set_home(ghost_list_t *ghosts, uint64_t key)
+{
+    return (size_t)(key ^ (key >> 32)) & (ghosts->set_capacity - 1);
+}
+
+static size_t set_find(ghost_list_t *ghosts, uint64_t key)
+{
+    size_t mask = ghosts->set_capacity - 1;
+    size_t slot = set_home(ghosts, key);
+
+    while (ghosts->set[slot].key && ghosts->set[slot].key != key)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static void set_insert(ghost_list_t *ghosts, ghost_entry_t entry)
+{
+    size_t slot = set_find(ghosts, entry.key);
+    if (!ghosts->set[slot].key)
+    {
+        ghosts->set[slot] = entry;
+        ghosts->set_size++;
+    }
+}
+
+// Removes a key and shifts later members of its probe run back, so the set
+// never needs tombstones
+static int set_remove(ghost_list_t *ghosts, uint64_t key)
+{
+    size_t mask = ghosts->set_capacity - 1;
+    size_t slot = set_find(ghosts, key);
+
+    if (!ghosts->set[slot].key)
+    {
+        return 0;
+    }
+
+    size_t next = (slot + 1) & mask;
+    while (ghosts->set[next].key)
+    {
+        size_t home = set_home(ghosts, ghosts->set[next].key);
+
+        // Move the entry into the hole unless its home lies cyclically after the hole
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            ghosts->set[slot] = ghosts->set[next];
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    ghosts->set[slot] = (ghost_entry_t){0, 0};
+    ghosts->set_size--;
+    return 1;
+}
+
+// Allocates a ring and a set for the given ring capacity
+static int allocate(ghost_list_t *ghosts, size_t ring_capacity)
+{
+    ghosts->ring = malloc(ring_capacity * sizeof(ghost_entry_t));
+    ghosts->set = calloc(ring_capacity * 2, sizeof(ghost_entry_t));
+    if (!ghosts->ring || !ghosts->set)
+    {
+        free(ghosts->ring);
+        free(ghosts->set);
+        return 0;
+    }
+
+    ghosts->ring_capacity = ring_capacity;
+    ghosts->set_capacity = ring_capacity * 2;
+    return 1;
+}
+
+// Checks whether a ring entry is the push its hash is remembered by
+static int is_live(ghost_list_t *ghosts, ghost_entry_t entry)
+{
+    ghost_entry_t member = ghosts->set[set_find(ghosts, entry.key)];
+    return member.key == entry.key && member.seq == entry.seq;
+}
+
+// Squeezes stale entries out of the ring, keeping the rest in eviction order
+static void compact(ghost_list_t *ghosts)
+{
+    size_t mask = ghosts->ring_capacity - 1;
+    size_t kept = 0;
+
+    for (size_t i = 0; i < ghosts->count; i++)
+    {
+        ghost_entry_t entry = ghosts->ring[(ghosts->head + i) & mask];
+        if (is_live(ghosts, entry))
+        {
+            ghosts->ring[(ghosts->head + kept) & mask] = entry;
+            kept++;
+        }
+    }
+    ghosts->count = kept;
+}
+
+// Doubles the ring, keeping the live entries in eviction order
+static int grow(ghost_list_t *ghosts)
+{
+    ghost_list_t grown = {0};
+    if (!allocate(&grown, ghosts->ring_capacity * 2))
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < ghosts->set_capacity; i++)
+    {
+        if (ghosts->set[i].key)
+        {
+            set_insert(&grown, ghosts->set[i]);
+        }
+    }
+
+    for (size_t i = 0; i < ghosts->count; i++)
+    {
+        ghost_entry_t entry = ghosts->ring[(ghosts->head + i) & (ghosts->ring_capacity - 1)];
+        if (is_live(&grown, entry))
+        {
+            grown.ring[grown.count++] = entry;
+        }
+    }
+    grown.next_seq = ghosts->next_seq;
+
+    ghost_list_destroy(ghosts);
+    *ghosts = grown;
+    return 1;
+}
+
+// Drops the oldest ring entry; returns 1 if it was still remembered. A
+// stale entry leaves the set alone, since the hash is either forgotten or
+// remembered by a later push.
+static int pop_oldest(ghost_list_t *ghosts)
+{
+    ghost_entry_t entry = ghosts->ring[ghosts->head];
+    ghosts->head = (ghosts->head + 1) & (ghosts->ring_capacity - 1);
+    ghosts->count--;
+    return is_live(ghosts, entry) && set_remove(ghosts, entry.key);
+}
+
+int ghost_list_init(ghost_list_t *ghosts)
+{
+    memset(ghosts, 0, sizeof(*ghosts));
+    return allocate(ghosts, GHOST_INITIAL_CAPACITY);
+}
+
+void ghost_list_destroy(ghost_list_t *ghosts)
+{
+    free(ghosts->ring);
+    free(ghosts->set);
+    ghosts->ring = NULL;
+    ghosts->set = NULL;
+}
+
+int ghost_list_contains(ghost_list_t *ghosts, uint64_t hash)
+{
+    uint64_t key = ghost_key(hash);
+    return ghosts->set[set_find(ghosts, key)].key == key;
+}
+
+int ghost_list_remove(ghost_list_t *ghosts, uint64_t hash)
+{
+    // The ring entry stays behind and is recognised as stale when it ages out
+    return set_remove(ghosts, ghost_key(hash));
+}
+
+size_t ghost_list_push(ghost_list_t *ghosts, uint64_t hash, size_t limit)
+{
+    uint64_t key = ghost_key(hash);
+    size_t aged_out = 0;
+
+    if (limit == 0)
+    {
+        limit = 1;
+    }
+
+    // A hash already remembered keeps its original position
+    if (ghost_list_contains(ghosts, key))
+    {
+        return 0;
+    }
+
+    while (ghosts->set_size >= limit)
+    {
+        aged_out += (size_t)pop_oldest(ghosts);
+    }
+
+    // A ring mostly holding stale entries is compacted rather than grown
+    if (ghosts->count == ghosts->ring_capacity)
+    {
+        if (ghosts->count - ghosts->set_size >= ghosts->ring_capacity / 2)
+        {
+            compact(ghosts);
+        }
+        else if (!grow(ghosts))
+        {
+            aged_out += (size_t)pop_oldest(ghosts);
+        }
+    }
+
+    ghost_entry_t entry = {key, ghosts->next_seq++};
+    ghosts->ring[(ghosts->head + ghosts->count) & (ghosts->ring_capacity - 1)] = entry;
+    ghosts->count++;
+    set_insert(ghosts, entry);
+
+    return aged_out;
+}
+
+void ghost_list_clear(ghost_list_t *ghosts)
+{
+    memset(ghosts->set, 0, ghosts->set_capacity * sizeof(ghost_entry_t));
+    ghosts->set_size = 0;
+    ghosts->head = 0;
+    ghosts->count = 0;
+}
@@ -0,0 +1,538 @@
+#include "hash_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) && !defined(HASH_INDEX_NO_SIMD)
+#include <emmintrin.h>
+#define HASH_INDEX_USE_SSE2 1
+#endif
+
+#define CTRL_EMPTY HASH_INDEX_CTRL_EMPTY
+#define CTRL_DELETED HASH_INDEX_CTRL_DELETED
+
+// Maximum load factor of 7/8, counting tombstones as used
+#define MAX_LOAD_NUMERATOR 7
+#define MAX_LOAD_DENOMINATOR 8
+
+// Splits a hash into the group selector and the tag stored in the control byte
+static inline size_t hash_group(uint64_t hash)
+{
+    return (size_t)(hash >> 7);
+}
+
+static inline uint8_t hash_tag(uint64_t hash)
+{
+    return (uint8_t)(hash & 0x7F);
+}
+
+// Returns the hash cached in an indexed node, so rebuilding never rehashes keys
+static inline uint64_t node_hash(Node *node)
+{
+    return node->kv_pair.hash;
+}
+
+// A snapshot of one group of control bytes, read as two atomic words so that
+// concurrent single-byte updates by the writer are never torn
+typedef struct
+{
+    uint64_t lo;
+    uint64_t hi;
+} ctrl_group_t;
+
+static inline ctrl_group_t load_group(const uint8_t *ctrl)
+{
+    ctrl_group_t group;
+    group.lo = __atomic_load_n((const uint64_t *)ctrl, __ATOMIC_RELAXED);
+    group.hi = __atomic_load_n((const uint64_t *)(ctrl + 8), __ATOMIC_RELAXED);
+
+    // Slots are written before their control byte, so order later slot loads after this one
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return group;
+}
+
+// Returns a bitmask with bit i set when control byte i of the group equals tag
+static inline uint32_t group_match(ctrl_group_t group, uint8_t tag)
+{
+#ifdef HASH_INDEX_USE_SSE2
+    __m128i ctrl = _mm_set_epi64x((long long)group.hi, (long long)group.lo);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)tag)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASH_INDEX_GROUP_WIDTH; i++)
+    {
+        uint8_t byte = (uint8_t)((i < 8 ? group.lo >> (8 * i) : group.hi >> (8 * (i - 8))) & 0xFF);
+        mask |= (uint32_t)(byte == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+// Returns a bitmask of the slots in the group that are empty or deleted
+static inline uint32_t group_match_free(ctrl_group_t group)
+{
+#ifdef HASH_INDEX_USE_SSE2
+    __m128i ctrl = _mm_set_epi64x((long long)group.hi, (long long)group.lo);
+    return (uint32_t)_mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASH_INDEX_GROUP_WIDTH; i++)
+    {
+        uint8_t byte = (uint8_t)((i < 8 ? group.lo >> (8 * i) : group.hi >> (8 * (i - 8))) & 0xFF);
+        mask |= (uint32_t)(byte >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+// Number of slots that may hold entries or tombstones before the table must grow
+static size_t max_load(size_t capacity)
+{
+    return capacity / MAX_LOAD_DENOMINATOR * MAX_LOAD_NUMERATOR;
+}
+
+// Smallest power-of-two slot count that keeps the given entries under the load limit
+static size_t capacity_for(size_t expected_entries)
+{
+    size_t capacity = HASH_INDEX_GROUP_WIDTH;
+    while (max_load(capacity) < expected_entries)
+    {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Allocates a table with every control byte empty
+static hash_index_table_t *allocate_table(size_t capacity)
+{
+    // The header is 16 bytes and capacity a multiple of 16, so both the
+    // control groups and the slot array that follows them stay aligned
+    size_t bytes = sizeof(hash_index_table_t) + capacity + capacity * sizeof(Node *);
+    hash_index_table_t *table = aligned_alloc(HASH_INDEX_GROUP_WIDTH, bytes);
+    if (!table)
+    {
+        return NULL;
+    }
+
+    table->capacity = capacity;
+    table->slots = (Node **)(table->ctrl + capacity);
+    memset(table->ctrl, CTRL_EMPTY, capacity);
+    return table;
+}
+
+// Disposes of a table readers may no longer reach
+static void drop_table(hash_index_t *index, hash_index_table_t *table)
+{
+    if (index->retire)
+    {
+        index->retire(index->retire_ctx, table);
+    }
+    else
+    {
+        free(table);
+    }
+}
+
+// Finds the first empty or deleted slot along the probe sequence for a hash
+static size_t find_free_slot(hash_index_table_t *table, uint64_t hash)
+{
+    size_t group_mask = table->capacity / HASH_INDEX_GROUP_WIDTH - 1;
+    size_t group = hash_group(hash) & group_mask;
+
+    // Triangular probing over groups visits every group when the count is a power of two
+    for (size_t step = 1;; step++)
+    {
+        uint32_t free_mask = group_match_free(load_group(table->ctrl + group * HASH_INDEX_GROUP_WIDTH));
+        if (free_mask)
+        {
+            return group * HASH_INDEX_GROUP_WIDTH + (size_t)__builtin_ctz(free_mask);
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+// Places a node into a free slot of the current table without checking the
+// load limit; the slot is filled before the control byte makes it visible
+static void insert_unchecked(hash_index_t *index, uint64_t hash, Node *node)
+{
+    hash_index_table_t *table = index->table;
+    size_t slot = find_free_slot(table, hash);
+    // Entries copied after others were removed from the new table can take
+    // it past the load limit; the next insert then starts another rebuild
+    if (table->ctrl[slot] == CTRL_EMPTY && index->growth_left > 0)
+    {
+        index->growth_left--;
+    }
+
+    __atomic_store_n(&table->slots[slot], node, __ATOMIC_RELEASE);
+    __atomic_store_n(&table->ctrl[slot], hash_tag(hash), __ATOMIC_RELEASE);
+}
+
+// Initialises an index with room for the given number of entries
+int hash_index_init(hash_index_t *index, size_t expected_entries)
+{
+    if (!index)
+    {
+        return 0;
+    }
+
+    memset(index, 0, sizeof(*index));
+
+    size_t capacity = capacity_for(expected_entries);
+    index->table = allocate_table(capacity);
+    if (!index->table)
+    {
+        return 0;
+    }
+
+    index->growth_left = max_load(capacity);
+    return 1;
+}
+
+// Frees the current table; retired ones belong to whoever the hook gave them to
+void hash_index_destroy(hash_index_t *index)
+{
+    if (!index)
+    {
+        return;
+    }
+
+    free(index->table);
+    free(index->older);
+    index->table = NULL;
+    index->older = NULL;
+    index->size = 0;
+    index->growth_left = 0;
+}
+
+size_t hash_index_capacity(hash_index_t *index)
+{
+    return index && index->table ? index->table->capacity : 0;
+}
+
+// Looks up the node holding a key in one table by probing groups of control bytes
+static Node *probe_key(hash_index_table_t *table, uint64_t hash, char *key, size_t key_len)
+{
+    size_t group_mask = table->capacity / HASH_INDEX_GROUP_WIDTH - 1;
+    size_t group = hash_group(hash) & group_mask;
+    uint8_t tag = hash_tag(hash);
+
+    for (size_t step = 1; step <= group_mask + 1; step++)
+    {
+        ctrl_group_t ctrl = load_group(table->ctrl + group * HASH_INDEX_GROUP_WIDTH);
+
+        uint32_t match = group_match(ctrl, tag);
+        while (match)
+        {
+            size_t slot = group * HASH_INDEX_GROUP_WIDTH + (size_t)__builtin_ctz(match);
+            Node *node = __atomic_load_n(&table->slots[slot], __ATOMIC_ACQUIRE);
+            if (kv_pair_matches_hashed_key(&node->kv_pair, hash, key, key_len))
+            {
+                return node;
+            }
+            match &= match - 1;
+        }
+
+        // A group with an empty slot ends every probe sequence passing through it
+        if (group_match(ctrl, CTRL_EMPTY))
+        {
+            return NULL;
+        }
+
+        group = (group + step) & group_mask;
+    }
+
+    return NULL;
+}
+
+// Looks up a key in the current table, then in the table still being moved.
+// Both pointers are loaded before probing: the older one is published before
+// the table and cleared only once every entry has been copied, so a reader
+// that sees it cleared is looking at a table that already holds them all.
+Node *hash_index_find(hash_index_t *index, uint64_t hash, char *key, size_t key_len)
+{
+    if (!index || !key)
+    {
+        return NULL;
+    }
+
+    hash_index_table_t *table = __atomic_load_n(&index->table, __ATOMIC_ACQUIRE);
+    hash_index_table_t *older = __atomic_load_n(&index->older, __ATOMIC_ACQUIRE);
+
+    Node *node = probe_key(table, hash, key, key_len);
+    if (!node && older && older != table)
+    {
+        node = probe_key(older, hash, key, key_len);
+    }
+    return node;
+}
+
+// Issues loads for the first group of a probe without waiting for them
+void hash_index_prefetch(hash_index_t *index, uint64_t hash)
+{
+    hash_index_table_t *table = index->table;
+    size_t group = hash_group(hash) & (table->capacity / HASH_INDEX_GROUP_WIDTH - 1);
+    Node **slots = table->slots + group * HASH_INDEX_GROUP_WIDTH;
+
+    __builtin_prefetch(table->ctrl + group * HASH_INDEX_GROUP_WIDTH);
+    __builtin_prefetch(slots);
+    __builtin_prefetch(slots + HASH_INDEX_GROUP_WIDTH / 2);
+}
+
+// Matches the tag in the first group and issues loads for the candidate
+// entries: the node header and the key that the comparison reads
+void hash_index_prefetch_entries(hash_index_t *index, uint64_t hash)
+{
+    hash_index_table_t *table = index->table;
+    size_t group = hash_group(hash) & (table->capacity / HASH_INDEX_GROUP_WIDTH - 1);
+
+    uint32_t match = group_match(load_group(table->ctrl + group * HASH_INDEX_GROUP_WIDTH), hash_tag(hash));
+    while (match)
+    {
+        Node *node = table->slots[group * HASH_INDEX_GROUP_WIDTH + (size_t)__builtin_ctz(match)];
+        __builtin_prefetch(node);
+        __builtin_prefetch(&node->kv_pair);
+        match &= match - 1;
+    }
+}
+
+// Locates the slot that refers to the given node, or returns the table capacity
+static size_t find_node_slot(hash_index_table_t *table, uint64_t hash, Node *node)
+{
+    size_t group_mask = table->capacity / HASH_INDEX_GROUP_WIDTH - 1;
+    size_t group = hash_group(hash) & group_mask;
+    uint8_t tag = hash_tag(hash);
+
+    for (size_t step = 1; step <= group_mask + 1; step++)
+    {
+        ctrl_group_t ctrl = load_group(table->ctrl + group * HASH_INDEX_GROUP_WIDTH);
+
+        uint32_t match = group_match(ctrl, tag);
+        while (match)
+        {
+            size_t slot = group * HASH_INDEX_GROUP_WIDTH + (size_t)__builtin_ctz(match);
+            if (table->slots[slot] == node)
+            {
+                return slot;
+            }
+            match &= match - 1;
+        }
+
+        if (group_match(ctrl, CTRL_EMPTY))
+        {
+            break;
+        }
+
+        group = (group + step) & group_mask;
+    }
+
+    return table->capacity;
+}
+
+// Compares slot pointers only, so the node may already have been retired
+int hash_index_contains(hash_index_t *index, uint64_t hash, Node *node)
+{
+    if (!index || !node)
+    {
+        return 0;
+    }
+
+    if (find_node_slot(index->table, hash, node) != index->table->capacity)
+    {
+        return 1;
+    }
+
+    return index->older && find_node_slot(index->older, hash, node) != index->older->capacity;
+}
+
+// Publishes an empty table for the entries of the current one and starts
+// moving them across
+static int start_rehash(hash_index_t *index, size_t expected_entries)
+{
+    if (expected_entries < index->size)
+    {
+        expected_entries = index->size;
+    }
+
+    size_t capacity = capacity_for(expected_entries + 1);
+    hash_index_table_t *table = allocate_table(capacity);
+    if (!table)
+    {
+        return 0;
+    }
+
+    // Readers load the table pointer first, so the older one must be
+    // visible before the new table is
+    __atomic_store_n(&index->older, index->table, __ATOMIC_RELEASE);
+    __atomic_store_n(&index->table, table, __ATOMIC_RELEASE);
+    index->rehash_cursor = 0;
+    index->growth_left = max_load(capacity);
+
+    // Every insert moves at least rehash_pace groups, so the older table is
+    // gone before inserts can use up the room left in the new one. Growing
+    // doubles the table and moves one group per insert; shrinking a large
+    // table into a small one moves proportionally more.
+    size_t room = index->growth_left - index->size;
+    size_t groups = index->older->capacity / HASH_INDEX_GROUP_WIDTH;
+    index->rehash_pace = (groups + room - 1) / room;
+    return 1;
+}
+
+// Inserts a node, starting a rehash first if the load limit has been reached
+int hash_index_insert(hash_index_t *index, uint64_t hash, Node *node)
+{
+    if (!index || !node)
+    {
+        return 0;
+    }
+
+    if (index->growth_left == 0)
+    {
+        // Grow when live entries fill more than half the table; otherwise
+        // tombstones are the problem and rebuilding at the same size is enough
+        size_t capacity = index->table->capacity;
+        size_t target = max_load(capacity) - 1;
+        if (index->size + 1 > max_load(capacity) / 2)
+        {
+            target = max_load(capacity * 2) - 1;
+        }
+
+        if (!hash_index_rehash(index, target))
+        {
+            return 0;
+        }
+    }
+
+    insert_unchecked(index, hash, node);
+    index->size++;
+    hash_index_rehash_step(index, HASH_INDEX_REHASH_GROUPS);
+    return 1;
+}
+
+// Clears the slot of one table that refers to the given node
+static int remove_from_table(hash_index_table_t *table, uint64_t hash, Node *node, size_t *growth_left)
+{
+    size_t slot = find_node_slot(table, hash, node);
+    if (slot == table->capacity)
+    {
+        return 0;
+    }
+
+    // If the group still has an empty slot no probe ever continued past it,
+    // so the slot can become empty instead of a tombstone
+    const uint8_t *group = table->ctrl + (slot & ~(size_t)(HASH_INDEX_GROUP_WIDTH - 1));
+    if (group_match(load_group(group), CTRL_EMPTY))
+    {
+        __atomic_store_n(&table->ctrl[slot], CTRL_EMPTY, __ATOMIC_RELEASE);
+        if (growth_left)
+        {
+            (*growth_left)++;
+        }
+    }
+    else
+    {
+        __atomic_store_n(&table->ctrl[slot], CTRL_DELETED, __ATOMIC_RELEASE);
+    }
+    return 1;
+}
+
+// Removes the slots that refer to the given node; during a rehash the older
+// table is cleared too, or a reader falling back to it would still find it
+int hash_index_remove(hash_index_t *index, uint64_t hash, Node *node)
+{
+    if (!index || !node)
+    {
+        return 0;
+    }
+
+    int found = remove_from_table(index->table, hash, node, &index->growth_left);
+    if (index->older)
+    {
+        found |= remove_from_table(index->older, hash, node, NULL);
+    }
+
+    if (!found)
+    {
+        return 0;
+    }
+
+    index->size--;
+    hash_index_rehash_step(index, HASH_INDEX_REHASH_GROUPS);
+    return 1;
+}
+
+// Points the slot of an indexed node in one table at its replacement
+static int replace_in_table(hash_index_table_t *table, uint64_t hash, Node *old_node, Node *new_node)
+{
+    size_t slot = find_node_slot(table, hash, old_node);
+    if (slot == table->capacity)
+    {
+        return 0;
+    }
+
+    // Readers see either the old or the new node, both fully initialised
+    __atomic_store_n(&table->slots[slot], new_node, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Points every slot of an indexed node at a replacement node with the same key
+int hash_index_replace(hash_index_t *index, uint64_t hash, Node *old_node, Node *new_node)
+{
+    if (!index || !old_node || !new_node)
+    {
+        return 0;
+    }
+
+    int found = replace_in_table(index->table, hash, old_node, new_node);
+    if (index->older)
+    {
+        found |= replace_in_table(index->older, hash, old_node, new_node);
+    }
+    return found;
+}
+
+// Starts a rebuild into a freshly allocated table, finishing any running one first
+int hash_index_rehash(hash_index_t *index, size_t expected_entries)
+{
+    if (!index)
+    {
+        return 0;
+    }
+
+    hash_index_rehash_step(index, SIZE_MAX);
+    return start_rehash(index, expected_entries);
+}
+
+// Copies the full slots of the next groups of the older table into the
+// current one; once the last group is copied the older table is dropped
+int hash_index_rehash_step(hash_index_t *index, size_t groups)
+{
+    if (!index || !index->older)
+    {
+        return 0;
+    }
+
+    hash_index_table_t *older = index->older;
+    groups = groups > SIZE_MAX / index->rehash_pace ? SIZE_MAX : groups * index->rehash_pace;
+    while (groups > 0 && index->rehash_cursor < older->capacity)
+    {
+        size_t end = index->rehash_cursor + HASH_INDEX_GROUP_WIDTH;
+        for (size_t slot = index->rehash_cursor; slot < end; slot++)
+        {
+            if (!(older->ctrl[slot] & CTRL_EMPTY))
+            {
+                insert_unchecked(index, node_hash(older->slots[slot]), older->slots[slot]);
+            }
+        }
+        index->rehash_cursor = end;
+        groups--;
+    }
+
+    if (index->rehash_cursor < older->capacity)
+    {
+        return 1;
+    }
+
+    __atomic_store_n(&index->older, NULL, __ATOMIC_RELEASE);
+    drop_table(index, older);
+    return 0;
+}
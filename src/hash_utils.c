@@ -1,4 +1,7 @@
 #include "hash_utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 // Implements the djb2 hashing algorithm for strings
 unsigned long djb2_hash(const char *key)
@@ -17,6 +20,146 @@ unsigned long djb2_hash(const char *key)
     return hash;
 }
 
+// djb2 over a length-delimited key, with the seed folded into the start value
+uint64_t djb2_hash_seeded(const void *key, size_t len, uint64_t seed)
+{
+    const unsigned char *p = key;
+    uint64_t hash = 5381 ^ seed;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = ((hash << 5) + hash) + p[i];
+    }
+
+    return hash;
+}
+
+// Default wyhash secret (public domain, Wang Yi)
+static const uint64_t wy_secret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+// 64x64 -> 128 bit multiply, returning the low and high halves in place
+static inline void wy_mum(uint64_t *a, uint64_t *b)
+{
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+}
+
+static inline uint64_t wy_mix(uint64_t a, uint64_t b)
+{
+    wy_mum(&a, &b);
+    return a ^ b;
+}
+
+// Unaligned little-endian loads
+static inline uint64_t wy_read8(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t wy_read4(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t wy_read3(const uint8_t *p, size_t k)
+{
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+// Consumes the key eight bytes at a time, mixing each pair of words with a
+// full-width multiply so every input bit reaches the high output bits
+uint64_t wyhash64(const void *key, size_t len, uint64_t seed)
+{
+    const uint8_t *p = key;
+    uint64_t a, b;
+
+    seed ^= wy_mix(seed ^ wy_secret[0], wy_secret[1]);
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (wy_read4(p) << 32) | wy_read4(p + ((len >> 3) << 2));
+            b = (wy_read4(p + len - 4) << 32) | wy_read4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = wy_read3(p, len);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            // Three independent lanes keep the multipliers busy on long keys
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = wy_mix(wy_read8(p) ^ wy_secret[1], wy_read8(p + 8) ^ seed);
+                see1 = wy_mix(wy_read8(p + 16) ^ wy_secret[2], wy_read8(p + 24) ^ see1);
+                see2 = wy_mix(wy_read8(p + 32) ^ wy_secret[3], wy_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = wy_mix(wy_read8(p) ^ wy_secret[1], wy_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wy_read8(p + i - 16);
+        b = wy_read8(p + i - 8);
+    }
+
+    a ^= wy_secret[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+}
+
+// Reads a seed from /dev/urandom, falling back to the clock and stack address
+uint64_t hash_random_seed(void)
+{
+    uint64_t seed = 0;
+
+    FILE *urandom = fopen("/dev/urandom", "rb");
+    if (urandom)
+    {
+        size_t got = fread(&seed, sizeof(seed), 1, urandom);
+        fclose(urandom);
+        if (got == 1)
+        {
+            return seed;
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    seed = (uint64_t)ts.tv_sec ^ ((uint64_t)ts.tv_nsec << 32) ^ (uint64_t)(uintptr_t)&seed;
+    return wyhash64(&seed, sizeof(seed), (uint64_t)ts.tv_nsec);
+}
+
+// Lemire's fastrange: scales the hash into the range using its high bits
+size_t hash_to_range(uint64_t hash, size_t range)
+{
+    return (size_t)(((__uint128_t)hash * range) >> 64);
+}
+
 // Maps a key to an index within the cache's hash table based on its capacity
 int key_to_index(char *key, int capacity)
 {
@@ -27,8 +170,8 @@ int key_to_index(char *key, int capacity)
     }
 
     // Compute the hash value for the given key
-    unsigned long hash = djb2_hash(key);
+    uint64_t hash = wyhash64(key, strlen(key), 0);
 
-    // Return the index by taking the hash modulo the capacity
-    return hash % capacity;
+    // Scale the hash into the capacity without an integer division
+    return (int)hash_to_range(hash, (size_t)capacity);
 }
@@ -3,30 +3,55 @@
 #include <string.h>
 #include <stdio.h>
 
-// Creates a new key-value pair
-kv_pair_t *kv_new_kv_pair(char *key, char *value)
+// Returns the size of a pair header followed by its key and value bytes
+size_t kv_pair_size(size_t key_len, size_t value_capacity)
 {
-    kv_pair_t *kv_pair = calloc(1, sizeof(kv_pair_t));
-    if (!kv_pair)
+    return sizeof(kv_pair_t) + key_len + 1 + value_capacity;
+}
+
+// Copies the key and value into the bytes that follow the pair header
+void kv_pair_init(kv_pair_t *kv_pair, char *key, size_t key_len, uint64_t hash,
+                  char *value, size_t value_len, size_t value_capacity)
+{
+    kv_pair->hash = hash;
+    kv_pair->key_len = (uint32_t)key_len;
+    kv_pair->value_len = (uint32_t)value_len;
+    kv_pair->value_capacity = (uint32_t)value_capacity;
+
+    memcpy(kv_pair->key, key, key_len);
+    kv_pair->key[key_len] = '\0';
+
+    char *value_bytes = kv_pair->key + key_len + 1;
+    memcpy(value_bytes, value, value_len);
+    value_bytes[value_len] = '\0';
+}
+
+// Creates a new key-value pair in a single allocation
+kv_pair_t *kv_new_kv_pair(char *key, size_t key_len, uint64_t hash, char *value)
+{
+    if (!key || !value)
     {
         return NULL;
     }
 
-    kv_pair->key = strdup(key);
-    if (!kv_pair->key)
+    return kv_new_kv_pair_bin(key, key_len, hash, value, strlen(value));
+}
+
+// Creates a new key-value pair holding value_len bytes of value
+kv_pair_t *kv_new_kv_pair_bin(char *key, size_t key_len, uint64_t hash, char *value, size_t value_len)
+{
+    if (!key || !value)
     {
-        free(kv_pair);
         return NULL;
     }
 
-    kv_pair->value = strdup(value);
-    if (!kv_pair->value)
+    kv_pair_t *kv_pair = malloc(kv_pair_size(key_len, value_len + 1));
+    if (!kv_pair)
     {
-        free(kv_pair->key);
-        free(kv_pair);
         return NULL;
     }
 
+    kv_pair_init(kv_pair, key, key_len, hash, value, value_len, value_len + 1);
     return kv_pair;
 }
 
@@ -38,25 +63,39 @@ char *kv_pair_get_value(kv_pair_t *kv_pair)
         return NULL;
     }
 
-    return kv_pair->value;
+    return kv_pair->key + kv_pair->key_len + 1;
 }
 
-// Updates the value in a key-value pair
-void kv_pair_set_value(kv_pair_t *kv_pair, char *new_value)
+// Overwrites the value in place when it fits in the space reserved for it
+int kv_pair_set_value(kv_pair_t *kv_pair, char *new_value)
 {
-    if (!kv_pair)
+    if (!kv_pair || !new_value)
     {
-        return;
+        return 0;
     }
 
-    char *new_value_dup = strdup(new_value);
-    if (!new_value_dup)
+    return kv_pair_set_value_bin(kv_pair, new_value, strlen(new_value));
+}
+
+// Overwrites the value with value_len bytes when they fit in the space reserved for it
+int kv_pair_set_value_bin(kv_pair_t *kv_pair, char *new_value, size_t value_len)
+{
+    if (!kv_pair || !new_value)
     {
-        return;
+        return 0;
+    }
+
+    if (value_len + 1 > kv_pair->value_capacity)
+    {
+        return 0;
     }
 
-    free(kv_pair->value);
-    kv_pair->value = new_value_dup;
+    // memmove because callers may pass back the pointer returned by a get
+    char *value_bytes = kv_pair_get_value(kv_pair);
+    memmove(value_bytes, new_value, value_len);
+    value_bytes[value_len] = '\0';
+    kv_pair->value_len = (uint32_t)value_len;
+    return 1;
 }
 
 // Returns the key from a key-value pair
@@ -73,13 +112,6 @@ char *kv_pair_get_key(kv_pair_t *kv_pair)
 // Frees the memory allocated for a key-value pair
 void kv_free_kv_pair(kv_pair_t *kv_pair)
 {
-    if (!kv_pair)
-    {
-        return;
-    }
-
-    free(kv_pair->key);
-    free(kv_pair->value);
     free(kv_pair);
 }
 
@@ -91,17 +123,32 @@ int kv_pair_matches_key(kv_pair_t *kv_pair, char *key)
         return 0;
     }
 
-    return strcmp(kv_pair->key, key) == 0;
+    size_t key_len = strlen(key);
+    return kv_pair->key_len == key_len && memcmp(kv_pair->key, key, key_len) == 0;
+}
+
+// Checks a pre-hashed key against the pair; the hash and length reject almost
+// every mismatch before any key bytes are read
+int kv_pair_matches_hashed_key(kv_pair_t *kv_pair, uint64_t hash, char *key, size_t key_len)
+{
+    if (!kv_pair || !key)
+    {
+        return 0;
+    }
+
+    return kv_pair->hash == hash &&
+           kv_pair->key_len == key_len &&
+           memcmp(kv_pair->key, key, key_len) == 0;
 }
 
 // Prints the key-value pair
 void kv_print_kv_pair(kv_pair_t *kv_pair)
 {
-    if (!kv_pair || !kv_pair->key || !kv_pair->value)
+    if (!kv_pair)
     {
         printf("Invalid key-value pair.\n");
         return;
     }
 
-    printf("Key: %s, Value: %s\n", kv_pair->key, kv_pair->value);
+    printf("Key: %s, Value: %s\n", kv_pair->key, kv_pair_get_value(kv_pair));
 }
@@ -4,113 +4,355 @@
 #include "hash_utils.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-// Removes all expired nodes from the cache
-static void remove_expired_nodes(LRUCache *cache)
+// Bytes charged against the memory limit for an entry occupying a block of
+// the given size: the block itself plus its share of the index
+static inline size_t entry_footprint(size_t block_size)
 {
-    if (!cache)
+    return block_size + LRU_ENTRY_INDEX_OVERHEAD;
+}
+
+// Adds to one of the cache's counters. Only the cache's user writes them,
+// so a plain read suffices; the relaxed store keeps a concurrent
+// lru_cache_get_stats from seeing a torn value.
+static inline void add_count(uint64_t *counter, uint64_t n)
+{
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+// Publishes a new entry count and footprint, written like the counters
+static inline void set_usage(LRUCache *cache, int size, size_t bytes_used)
+{
+    __atomic_store_n(&cache->size, size, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache->bytes_used, bytes_used, __ATOMIC_RELAXED);
+}
+
+// Queues a removal for the listener, pinning the entry until it is
+// delivered. If the queue cannot grow the removal goes unreported.
+static void record_removal(LRUCache *cache, Node *node, lru_removal_reason_t reason)
+{
+    if (!cache->listener && !cache->collect_evictions)
     {
         return;
     }
 
-    Node *current = cache->head;
-    while (current)
+    if (cache->evicted_count == cache->evicted_capacity)
+    {
+        size_t capacity = cache->evicted_capacity ? cache->evicted_capacity * 2 : LRU_EVICTION_BATCH;
+        lru_eviction_t *evicted = realloc(cache->evicted, capacity * sizeof(lru_eviction_t));
+        if (!evicted)
+        {
+            return;
+        }
+        cache->evicted = evicted;
+        cache->evicted_capacity = capacity;
+    }
+
+    node->refs++;
+    cache->evicted[cache->evicted_count].entry = node;
+    cache->evicted[cache->evicted_count].reason = reason;
+    cache->evicted_count++;
+}
+
+// Hands queued removals to the listener a batch at a time, while a full
+// batch is queued or, with partial set, until none are. Only called once the
+// cache is consistent; a listener that uses the cache queues its own
+// removals, which this loop then delivers too.
+static void deliver_evictions(LRUCache *cache, int partial)
+{
+    if (!cache->listener || cache->delivering || cache->evicted_count == 0)
     {
-        Node *next_node = current->next;
+        return;
+    }
 
-        if (current->expiration < time(NULL))
+    cache->delivering = 1;
+    lru_eviction_t batch[LRU_EVICTION_BATCH];
+    size_t n;
+    while ((n = lru_cache_take_evictions(cache, batch, LRU_EVICTION_BATCH, partial)) > 0)
+    {
+        cache->listener(cache->listener_ctx, batch, n);
+        for (size_t i = 0; i < n; i++)
         {
-            // Remove from hash table
-            int index = key_to_index(kv_pair_get_key(current->kv_pair), cache->capacity);
-            if (cache->hash_table[index] == current)
-            {
-                cache->hash_table[index] = current->next;
-            }
-            else
+            lru_cache_release(cache, batch[i].entry);
+        }
+    }
+    cache->delivering = 0;
+}
+
+// Unlinks a node without freeing it and returns the block it occupies
+static Node *detach_node(LRUCache *cache, Node *node, lru_removal_reason_t reason)
+{
+    record_removal(cache, node, reason);
+    hash_index_remove(&cache->index, node->kv_pair.hash, node);
+    policy_on_remove(cache, node);
+    timer_wheel_cancel(&cache->timers, &node->timer);
+    set_usage(cache, cache->size - 1, cache->bytes_used - entry_footprint(node_allocation_size(node)));
+    return node;
+}
+
+// Queues memory that lock-free readers may still be using, stamped with the
+// current epoch; it is freed by lru_cache_reclaim once no reader can see it
+static void retire(LRUCache *cache, void *ptr, int is_table)
+{
+    uint64_t epoch = epoch_current(cache->epoch);
+
+    if (cache->retired_count == cache->retired_capacity)
+    {
+        size_t capacity = cache->retired_capacity ? cache->retired_capacity * 2 : LRU_RECLAIM_THRESHOLD;
+        lru_retired_t *retired = realloc(cache->retired, capacity * sizeof(lru_retired_t));
+        if (!retired)
+        {
+            // Without room to defer the free, wait for the readers to move on
+            while (epoch_reclaim_bound(cache->epoch) <= epoch)
             {
-                if (current->prev)
-                {
-                    current->prev->next = current->next;
-                }
-                if (current->next)
-                {
-                    current->next->prev = current->prev;
-                }
             }
-
-            // Update head and tail pointers
-            if (cache->head == current)
+            if (is_table)
             {
-                cache->head = current->next;
+                free(ptr);
             }
-            if (cache->tail == current)
+            else
             {
-                cache->tail = current->prev;
+                free_node(&cache->slabs, ptr);
             }
-
-            // Free the node
-            kv_free_kv_pair(current->kv_pair);
-            free(current);
-            cache->size--;
+            return;
         }
+        cache->retired = retired;
+        cache->retired_capacity = capacity;
+    }
+
+    cache->retired[cache->retired_count++] = (lru_retired_t){ptr, epoch, is_table};
 
-        current = next_node;
+    if (cache->retired_count % LRU_RECLAIM_THRESHOLD == 0)
+    {
+        lru_cache_reclaim(cache);
     }
 }
 
-// Evicts the least recently used block from the cache
-static void evict_least_recently_used_block(LRUCache *cache)
+// Receives index tables replaced by a rehash
+static void retire_table(void *ctx, void *table)
+{
+    retire(ctx, table, 1);
+}
+
+// Frees a detached node now, or defers it while lock-free readers are enabled
+static void free_detached_node(LRUCache *cache, Node *node)
 {
-    if (!cache || !cache->tail)
+    if (cache->epoch)
     {
+        retire(cache, node, 0);
+    }
+    else
+    {
+        free_node(&cache->slabs, node);
+    }
+}
+
+// Drops the cache's reference to a detached node. A node still pinned by a
+// handle is parked on the pinned list and freed by its last release.
+static void release_node(LRUCache *cache, Node *node)
+{
+    if (--node->refs > 0)
+    {
+        add_node_to_front(&cache->pinned, node);
         return;
     }
 
-    Node *node_to_evict = cache->tail;
+    free_detached_node(cache, node);
+}
 
-    // Find the hash table index for the node to be evicted
-    int index = key_to_index(kv_pair_get_key(node_to_evict->kv_pair), cache->capacity);
+// Removes a node from both the hash index and the recency list and frees it
+static void remove_node(LRUCache *cache, Node *node, lru_removal_reason_t reason)
+{
+    release_node(cache, detach_node(cache, node, reason));
+}
 
-    // Remove the node from the hash table
-    if (cache->hash_table[index] == node_to_evict)
+// Checks whether the item count or byte budget leaves no room for an entry
+static int cache_is_full(LRUCache *cache, size_t footprint)
+{
+    if (cache->capacity > 0 && cache->size >= cache->capacity)
     {
-        cache->hash_table[index] = node_to_evict->next;
+        return 1;
     }
-    else
+
+    return cache->memory_limit > 0 && cache->bytes_used + footprint > cache->memory_limit;
+}
+
+// Checks whether an entry is too large to be admitted under the byte budget
+static int entry_is_oversized(LRUCache *cache, size_t footprint)
+{
+    return cache->memory_limit > 0 &&
+           (double)footprint > (double)cache->memory_limit * cache->max_entry_fraction;
+}
+
+// Files an entry in the expiry wheel; it falls due at its expiration time,
+// when lookups start treating it as a miss
+static void schedule_expiry(LRUCache *cache, Node *node)
+{
+    timer_wheel_schedule(&cache->timers, &node->timer, node->expiration);
+}
+
+// Picks the entry to evict: an expired one if the wheel has one ready,
+// otherwise the eviction policy's victim. Never picks keep. Every caller
+// removes the entry, so it is counted here as an expiration or eviction;
+// reason holds the caller's reason for evicting a live entry and is changed
+// to LRU_REMOVAL_EXPIRED for an expired one.
+static Node *choose_victim(LRUCache *cache, Node *keep, lru_removal_reason_t *reason)
+{
+    timer_wheel_advance(&cache->timers, lru_clock_now_ms(cache->clock), LRU_EXPIRE_EVICTION_BUDGET);
+
+    timer_link_t *due = timer_wheel_first_due(&cache->timers);
+    if (due && node_from_timer(due) != keep)
     {
-        if (node_to_evict->prev)
-        {
-            node_to_evict->prev->next = node_to_evict->next;
-        }
-        if (node_to_evict->next)
-        {
-            node_to_evict->next->prev = node_to_evict->prev;
-        }
+        Node *expired = node_from_timer(due);
+        add_count(&cache->counters.expirations, 1);
+        LRU_PROBE2(expire, kv_pair_get_key(&expired->kv_pair), expired->kv_pair.key_len);
+        *reason = LRU_REMOVAL_EXPIRED;
+        return expired;
     }
 
-    // Update the tail pointer of the doubly linked list
-    if (node_to_evict->prev)
+    Node *victim = policy_victim(cache, keep);
+    if (victim)
     {
-        node_to_evict->prev->next = NULL;
+        add_count(&cache->counters.evictions, 1);
+        LRU_PROBE2(evict, kv_pair_get_key(&victim->kv_pair), victim->kv_pair.key_len);
     }
-    cache->tail = node_to_evict->prev;
+    return victim;
+}
 
-    // If the cache is empty, update the head pointer as well
-    if (cache->tail == NULL)
+// Evicts an expired entry if there is one, else the entry chosen by the
+// eviction policy; the least recently used block under LRU. A live victim
+// is reported with the given reason.
+static void evict_least_recently_used_block(LRUCache *cache, lru_removal_reason_t reason)
+{
+    if (!cache || cache->size == 0)
     {
-        cache->head = NULL;
+        return;
     }
 
-    kv_free_kv_pair(node_to_evict->kv_pair);
-    free(node_to_evict);
+    LRU_TIME_START(cache, LRU_PHASE_EVICT, start);
+    Node *victim = choose_victim(cache, NULL, &reason);
+    remove_node(cache, victim, reason);
+    LRU_TIME_END(cache, LRU_PHASE_EVICT, start);
+}
 
-    cache->size--;
+// Evicts the least recently used block and hands its memory straight to the
+// incoming entry when both fall in the same slab class
+static void *evict_for_reuse(LRUCache *cache, size_t needed, size_t *block_size)
+{
+    if (cache->size == 0)
+    {
+        return NULL;
+    }
+
+    LRU_TIME_START(cache, LRU_PHASE_EVICT, start);
+    lru_removal_reason_t reason = LRU_REMOVAL_CAPACITY;
+    Node *victim = choose_victim(cache, NULL, &reason);
+    detach_node(cache, victim, reason);
+    size_t victim_size = node_allocation_size(victim);
+
+    // A lock-free reader, a handle or a queued removal may still be looking
+    // at the victim, so its memory cannot be reused until they have moved on
+    if (!cache->epoch && victim->refs == 1 && victim_size == slab_chunk_size(&cache->slabs, needed))
+    {
+        *block_size = victim_size;
+        LRU_TIME_END(cache, LRU_PHASE_EVICT, start);
+        return victim;
+    }
+
+    release_node(cache, victim);
+    LRU_TIME_END(cache, LRU_PHASE_EVICT, start);
+    return NULL;
+}
+
+// Evicts the entry occupying a chunk of a page being emptied; chunks of
+// pinned, queued or retired entries are left alone
+static void evict_chunk(void *ctx, void *chunk)
+{
+    LRUCache *cache = ctx;
+    Node *node = chunk;
+    if (!hash_index_contains(&cache->index, node->kv_pair.hash, node))
+    {
+        return;
+    }
+
+    add_count(&cache->counters.evictions, 1);
+    LRU_PROBE2(evict, kv_pair_get_key(&node->kv_pair), node->kv_pair.key_len);
+    remove_node(cache, node, LRU_REMOVAL_CAPACITY);
+}
+
+// Moves a slab page to the class serving an entry of the needed size, as
+// memcached's slab rebalancer does: the least used page of another class is
+// emptied by evicting the entries on it, then handed over. Fails while some
+// chunk on the page still belongs to a pinned or queued entry, or to one a
+// lock-free reader may be looking at.
+static int reassign_page(LRUCache *cache, size_t needed)
+{
+    void *page = slab_pick_donor_page(&cache->slabs, needed);
+    if (!page || !slab_for_each_used_chunk(&cache->slabs, page, evict_chunk, cache))
+    {
+        return 0;
+    }
+
+    if (cache->epoch)
+    {
+        lru_cache_reclaim(cache);
+    }
+    return slab_reassign(&cache->slabs, page, needed);
+}
+
+// Hashes a key with the function and seed chosen when the cache was created
+static inline uint64_t hash_key(LRUCache *cache, char *key, size_t key_len)
+{
+    LRU_TIME_START(cache, LRU_PHASE_HASH, start);
+    uint64_t hash = cache->hash_fn(key, key_len, cache->hash_seed);
+    LRU_TIME_END(cache, LRU_PHASE_HASH, start);
+    return hash;
 }
 
 // Creates a new LRU cache with the given capacity
 LRUCache *lru_cache_create(int capacity)
 {
-    if (capacity <= 0)
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, capacity);
+    return lru_cache_create_with_config(&config);
+}
+
+// Creates a new LRU cache bounded by memory footprint rather than item count
+LRUCache *lru_cache_create_with_memory_limit(size_t bytes)
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 0);
+    config.memory_limit = bytes;
+    return lru_cache_create_with_config(&config);
+}
+
+// Fills a config with the default options
+void lru_cache_config_init(lru_cache_config_t *config, int capacity)
+{
+    if (!config)
+    {
+        return;
+    }
+
+    config->capacity = capacity;
+    config->hash_fn = wyhash64;
+    config->hash_seed = 0;
+    config->random_seed = 0;
+    config->slab_page_size = SLAB_DEFAULT_PAGE_SIZE;
+    config->slab_memory_limit = 0;
+    config->slab_preallocate = 0;
+    config->memory_limit = 0;
+    config->max_entry_fraction = LRU_DEFAULT_MAX_ENTRY_FRACTION;
+    config->policy = LRU_POLICY_LRU;
+    config->clock = NULL;
+}
+
+// Creates a new LRU cache from a config
+LRUCache *lru_cache_create_with_config(const lru_cache_config_t *config)
+{
+    // At least one of the item count and the byte budget must bound the cache
+    if (!config || config->capacity < 0 || (config->capacity == 0 && config->memory_limit == 0))
     {
         return NULL;
     }
@@ -121,17 +363,39 @@ LRUCache *lru_cache_create(int capacity)
         return NULL;
     }
 
-    cache->capacity = capacity;
+    cache->capacity = config->capacity;
+    cache->memory_limit = config->memory_limit;
+    cache->max_entry_fraction = config->max_entry_fraction > 0 ? config->max_entry_fraction
+                                                               : LRU_DEFAULT_MAX_ENTRY_FRACTION;
+    cache->bytes_used = 0;
+    cache->hash_fn = config->hash_fn ? config->hash_fn : wyhash64;
+    cache->hash_seed = config->random_seed ? hash_random_seed() : config->hash_seed;
     cache->size = 0;
-    cache->hits = 0;
-    cache->misses = 0;
-    cache->head = NULL;
-    cache->tail = NULL;
+    cache->list.head = NULL;
+    cache->list.tail = NULL;
+    lru_clock_init(&cache->own_clock, LRU_CLOCK_MONOTONIC_COARSE);
+    cache->clock = config->clock ? config->clock : &cache->own_clock;
+    timer_wheel_init(&cache->timers, lru_clock_now_ms(cache->clock));
+
+    if (!policy_init(cache, config->policy))
+    {
+        free(cache);
+        return NULL;
+    }
+
+    if (!slab_init(&cache->slabs, config->slab_page_size, config->slab_memory_limit,
+                   config->slab_preallocate))
+    {
+        policy_destroy(cache);
+        free(cache);
+        return NULL;
+    }
 
-    // Allocate memory for the hash table
-    cache->hash_table = calloc(capacity, sizeof(Node *));
-    if (!cache->hash_table)
+    // The index starts small and grows with its own load factor
+    if (!hash_index_init(&cache->index, 0))
     {
+        slab_destroy(&cache->slabs);
+        policy_destroy(cache);
         free(cache);
         return NULL;
     }
@@ -147,142 +411,515 @@ char *lru_cache_get(LRUCache *cache, char *key)
         return NULL;
     }
 
-    int index = key_to_index(key, cache->capacity);
-    Node *node = cache->hash_table[index];
+    size_t key_len = strlen(key);
+    return lru_cache_get_hashed(cache, key, key_len, hash_key(cache, key, key_len), NULL);
+}
+
+// Finds the live entry for a key, counting the hit or miss and applying the
+// eviction policy's hit; an expired entry is removed and counts as a miss
+static Node *lookup_node(LRUCache *cache, char *key, size_t key_len, uint64_t hash)
+{
+    // Reads carry a running index rebuild forward as well as writes
+    if (cache->index.older)
+    {
+        hash_index_rehash_step(&cache->index, HASH_INDEX_REHASH_GROUPS);
+    }
+
+    LRU_TIME_START(cache, LRU_PHASE_LOOKUP, start);
+    Node *node = hash_index_find(&cache->index, hash, key, key_len);
+    LRU_TIME_END(cache, LRU_PHASE_LOOKUP, start);
+
+    if (!node)
+    {
+        add_count(&cache->counters.misses, 1);
+        return NULL;
+    }
+
+    if (node->expiration <= lru_clock_now_ms(cache->clock))
+    {
+        // Remove the expired node directly
+        LRU_PROBE2(expire, key, key_len);
+        remove_node(cache, node, LRU_REMOVAL_EXPIRED);
+        add_count(&cache->counters.expirations, 1);
+        add_count(&cache->counters.misses, 1);
+        return NULL;
+    }
+
+    policy_on_hit(cache, node);
+    add_count(&cache->counters.hits, 1);
+    return node;
+}
+
+// Retrieves the value for a key of explicit length
+char *lru_cache_get_bin(LRUCache *cache, char *key, size_t key_len, size_t *value_len)
+{
+    if (!cache || !key)
+    {
+        return NULL;
+    }
+
+    return lru_cache_get_hashed(cache, key, key_len, hash_key(cache, key, key_len), value_len);
+}
+
+// Retrieves a value and its length for a key whose hash the caller already computed
+char *lru_cache_get_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash, size_t *value_len)
+{
+    if (!cache || !key)
+    {
+        return NULL;
+    }
+
+    LRU_TIME_START(cache, LRU_PHASE_GET, start);
+    Node *node = lookup_node(cache, key, key_len, hash);
+    LRU_TIME_END(cache, LRU_PHASE_GET, start);
+    LRU_PROBE3(get, key, key_len, node != NULL);
+    if (!node)
+    {
+        return NULL;
+    }
 
-    // Traverse the linked list at the hash table index
-    while (node)
+    if (value_len)
     {
-        if (kv_pair_matches_key(node->kv_pair, key))
+        *value_len = node->kv_pair.value_len;
+    }
+    return kv_pair_get_value(&node->kv_pair);
+}
+
+// Looks up a key and pins its entry for reading in place
+lru_handle_t *lru_cache_acquire(LRUCache *cache, char *key)
+{
+    if (!cache || !key)
+    {
+        return NULL;
+    }
+
+    size_t key_len = strlen(key);
+    return lru_cache_acquire_hashed(cache, key, key_len, hash_key(cache, key, key_len));
+}
+
+// Pins the entry for a key whose hash the caller already computed
+lru_handle_t *lru_cache_acquire_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash)
+{
+    if (!cache || !key)
+    {
+        return NULL;
+    }
+
+    Node *node = lookup_node(cache, key, key_len, hash);
+    if (node)
+    {
+        node->refs++;
+    }
+    return node;
+}
+
+// Unpins an entry, freeing it if it already left the cache and this was the
+// last handle; a resident entry keeps the cache's own reference
+void lru_cache_release(LRUCache *cache, lru_handle_t *handle)
+{
+    if (!cache || !handle)
+    {
+        return;
+    }
+
+    if (--handle->refs == 0)
+    {
+        remove_node_from_list(&cache->pinned, handle);
+        free_detached_node(cache, handle);
+    }
+}
+
+// Returns the value bytes of a pinned entry
+char *lru_handle_value(lru_handle_t *handle)
+{
+    return handle ? kv_pair_get_value(&handle->kv_pair) : NULL;
+}
+
+// Returns the value length of a pinned entry
+size_t lru_handle_value_len(lru_handle_t *handle)
+{
+    return handle ? handle->kv_pair.value_len : 0;
+}
+
+// Returns the key of a pinned entry
+char *lru_handle_key(lru_handle_t *handle)
+{
+    return handle ? kv_pair_get_key(&handle->kv_pair) : NULL;
+}
+
+// Hashes a chunk of keys and prefetches their index groups, then their
+// candidate entries, so the cache misses of the whole chunk overlap instead
+// of being taken one lookup at a time
+static void prefetch_chunk(LRUCache *cache, char **keys, size_t n, size_t *key_lens, uint64_t *hashes)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (keys[i])
         {
-            if (node->expiration < time(NULL))
-            {
-                // Remove the expired node directly
-                if (node->prev)
-                {
-                    node->prev->next = node->next;
-                }
-                if (node->next)
-                {
-                    node->next->prev = node->prev;
-                }
+            key_lens[i] = strlen(keys[i]);
+            hashes[i] = hash_key(cache, keys[i], key_lens[i]);
+            hash_index_prefetch(&cache->index, hashes[i]);
+        }
+    }
 
-                if (cache->head == node)
-                {
-                    cache->head = node->next;
-                }
-                if (cache->tail == node)
-                {
-                    cache->tail = node->prev;
-                }
+    for (size_t i = 0; i < n; i++)
+    {
+        if (keys[i])
+        {
+            hash_index_prefetch_entries(&cache->index, hashes[i]);
+        }
+    }
+}
 
-                // Remove from hash table
-                if (cache->hash_table[index] == node)
-                {
-                    cache->hash_table[index] = node->next;
-                }
+// Looks up a batch of keys chunk by chunk. The clock is read once, so an
+// entry found live for one key cannot be removed as expired for a later
+// duplicate, and the hits of a chunk update recency together once all of
+// its lookups are done.
+size_t lru_cache_mget(LRUCache *cache, char **keys, size_t n, char **values_out)
+{
+    if (!cache || !keys || !values_out)
+    {
+        return 0;
+    }
+
+    if (cache->index.older)
+    {
+        hash_index_rehash_step(&cache->index, HASH_INDEX_REHASH_GROUPS);
+    }
 
-                kv_free_kv_pair(node->kv_pair);
-                free(node);
+    uint64_t now = lru_clock_now_ms(cache->clock);
+    size_t key_lens[LRU_BATCH_CHUNK];
+    uint64_t hashes[LRU_BATCH_CHUNK];
+    Node *found[LRU_BATCH_CHUNK];
+    size_t hits = 0;
+
+    for (size_t start = 0; start < n; start += LRU_BATCH_CHUNK)
+    {
+        size_t count = n - start < LRU_BATCH_CHUNK ? n - start : LRU_BATCH_CHUNK;
+        char **chunk = keys + start;
+        prefetch_chunk(cache, chunk, count, key_lens, hashes);
 
-                cache->size--;
-                cache->misses++;
-                return NULL;
+        for (size_t i = 0; i < count; i++)
+        {
+            Node *node = chunk[i] ? hash_index_find(&cache->index, hashes[i], chunk[i], key_lens[i]) : NULL;
+            if (node && node->expiration <= now)
+            {
+                remove_node(cache, node, LRU_REMOVAL_EXPIRED);
+                add_count(&cache->counters.expirations, 1);
+                node = NULL;
             }
 
-            move_node_to_front(cache, node);
-            cache->hits++;
-            return kv_pair_get_value(node->kv_pair);
+            found[i] = node;
+            values_out[start + i] = node ? kv_pair_get_value(&node->kv_pair) : NULL;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (found[i])
+            {
+                policy_on_hit(cache, found[i]);
+                hits++;
+            }
         }
+    }
+
+    add_count(&cache->counters.hits, hits);
+    add_count(&cache->counters.misses, n - hits);
+    return hits;
+}
 
-        node = node->next;
+// Inserts or updates a batch of pairs, prefetching each chunk's index groups
+// and existing entries before the writes
+void lru_cache_mset(LRUCache *cache, char **keys, char **values, size_t n)
+{
+    if (!cache || !keys || !values)
+    {
+        return;
     }
 
-    cache->misses++;
+    size_t key_lens[LRU_BATCH_CHUNK];
+    uint64_t hashes[LRU_BATCH_CHUNK];
 
-    return NULL;
+    for (size_t start = 0; start < n; start += LRU_BATCH_CHUNK)
+    {
+        size_t count = n - start < LRU_BATCH_CHUNK ? n - start : LRU_BATCH_CHUNK;
+        char **chunk = keys + start;
+        prefetch_chunk(cache, chunk, count, key_lens, hashes);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (chunk[i] && values[start + i])
+            {
+                lru_cache_set_hashed(cache, chunk[i], key_lens[i], hashes[i], values[start + i],
+                                     strlen(values[start + i]), DEFAULT_EXPIRATION_MS);
+            }
+        }
+    }
 }
 
 // Inserts or updates a key-value pair in the cache with a default expiration (2 hours)
 void lru_cache_set(LRUCache *cache, char *key, char *value)
 {
-    lru_cache_set_with_expiration(cache, key, value, DEFAULT_EXPIRATION_TIME);
+    lru_cache_set_with_expiration(cache, key, value, DEFAULT_EXPIRATION_MS);
 }
 
-// Inserts or updates a key-value pair in the cache with custom expiration
-void lru_cache_set_with_expiration(LRUCache *cache, char *key, char *value, int ttl_seconds)
+// Inserts or updates a key-value pair in the cache that expires ttl_ms milliseconds from now
+void lru_cache_set_with_expiration(LRUCache *cache, char *key, char *value, uint64_t ttl_ms)
 {
-    if (!cache || !key || !value || ttl_seconds <= 0)
+    if (!cache || !key || !value || ttl_ms == 0)
     {
         return;
     }
 
-    int index = key_to_index(key, cache->capacity);
-    Node *node = cache->hash_table[index];
+    size_t key_len = strlen(key);
+    lru_cache_set_hashed(cache, key, key_len, hash_key(cache, key, key_len), value, strlen(value), ttl_ms);
+}
+
+// Inserts or updates a key and value of explicit lengths
+void lru_cache_set_bin(LRUCache *cache, char *key, size_t key_len, char *value, size_t value_len,
+                       uint64_t ttl_ms)
+{
+    if (!cache || !key || !value || ttl_ms == 0 || key_len > KV_PAIR_MAX_LEN || value_len > KV_PAIR_MAX_LEN)
+    {
+        return;
+    }
+
+    lru_cache_set_hashed(cache, key, key_len, hash_key(cache, key, key_len), value, value_len, ttl_ms);
+}
+
+// Removes expired entries as the expiry wheel turns up to the current time.
+// Each entry is refiled at most once per wheel level before it falls due, so
+// the wheel work of a call is bounded by that many moves per removal.
+size_t lru_cache_expire(LRUCache *cache, size_t budget)
+{
+    if (!cache)
+    {
+        return 0;
+    }
+
+    size_t moves = budget > SIZE_MAX / TIMER_WHEEL_LEVELS ? SIZE_MAX : budget * TIMER_WHEEL_LEVELS;
+    timer_wheel_advance(&cache->timers, lru_clock_now_ms(cache->clock), moves);
+
+    size_t removed = 0;
+    timer_link_t *due;
+    while (removed < budget && (due = timer_wheel_first_due(&cache->timers)))
+    {
+        Node *expired = node_from_timer(due);
+        LRU_PROBE2(expire, kv_pair_get_key(&expired->kv_pair), expired->kv_pair.key_len);
+        remove_node(cache, expired, LRU_REMOVAL_EXPIRED);
+        removed++;
+    }
+    add_count(&cache->counters.expirations, removed);
+    deliver_evictions(cache, 1);
+
+    return removed;
+}
+
+// Inserts or updates a key, evicting entries as needed to make room
+static void set_entry(LRUCache *cache, char *key, size_t key_len, uint64_t hash,
+                      char *value, size_t value_len, uint64_t ttl_ms)
+{
+    size_t needed = node_size_for(key_len, value_len);
+    size_t footprint = entry_footprint(slab_chunk_size(&cache->slabs, needed));
 
     // Check if the key already exists in the cache
-    while (node)
+    LRU_TIME_START(cache, LRU_PHASE_LOOKUP, lookup_start);
+    Node *node = hash_index_find(&cache->index, hash, key, key_len);
+    LRU_TIME_END(cache, LRU_PHASE_LOOKUP, lookup_start);
+
+    // Entries too large for the byte budget are rejected; any older value is
+    // dropped so that readers never see it after a failed write
+    if (entry_is_oversized(cache, footprint))
     {
-        if (kv_pair_matches_key(node->kv_pair, key))
+        if (node)
         {
-            kv_pair_set_value(node->kv_pair, value);
-            node->expiration = time(NULL) + ttl_seconds; // Update expiration
-            cache->hits++;
-            move_node_to_front(cache, node);
-            return;
+            add_count(&cache->counters.evictions, 1);
+            LRU_PROBE2(evict, kv_pair_get_key(&node->kv_pair), node->kv_pair.key_len);
+            remove_node(cache, node, LRU_REMOVAL_CAPACITY);
         }
+        return;
+    }
+
+    uint64_t expiration = lru_clock_now_ms(cache->clock) + ttl_ms;
 
-        node = node->next;
+    if (node)
+    {
+        // Reuse the entry block when the new value fits; otherwise move the
+        // key into a larger block and repoint the index at it. With lock-free
+        // readers an entry is never modified once published, and a pinned
+        // entry must keep the value its handles read, so those updates take
+        // the second path
+        if (cache->epoch || node->refs > 1 || !kv_pair_set_value_bin(&node->kv_pair, value, value_len))
+        {
+            LRU_TIME_START(cache, LRU_PHASE_ALLOC, alloc_start);
+            Node *grown = alloc_node(&cache->slabs, key, key_len, hash, value, value_len);
+            LRU_TIME_END(cache, LRU_PHASE_ALLOC, alloc_start);
+            if (!grown)
+            {
+                return;
+            }
+            grown->expiration = expiration;
+            timer_wheel_cancel(&cache->timers, &node->timer);
+            schedule_expiry(cache, grown);
+            hash_index_replace(&cache->index, hash, node, grown);
+            policy_on_replace(cache, node, grown);
+            set_usage(cache, cache->size,
+                      cache->bytes_used + footprint - entry_footprint(node_allocation_size(node)));
+            release_node(cache, node);
+            node = grown;
+
+            // The larger value may push the cache over its byte budget
+            while (cache->memory_limit > 0 && cache->bytes_used > cache->memory_limit)
+            {
+                lru_removal_reason_t reason = LRU_REMOVAL_CAPACITY;
+                Node *victim = choose_victim(cache, node, &reason);
+                if (!victim)
+                {
+                    break;
+                }
+                remove_node(cache, victim, reason);
+            }
+        }
+        else
+        {
+            node->expiration = expiration; // Update expiration
+            schedule_expiry(cache, node);
+        }
+        add_count(&cache->counters.updates, 1);
+        add_count(&cache->counters.bytes_written, key_len + value_len);
+        policy_on_hit(cache, node);
+        return;
     }
 
-    // Evict the least recently used block if the cache is full
-    if (cache->size == cache->capacity)
+    Node *new_node = NULL;
+
+    policy_before_insert(cache, hash);
+
+    // Evict least recently used blocks until the entry fits both the item
+    // count and the byte budget, reusing the first victim's memory for the
+    // new entry when the sizes are compatible
+    while (cache->size > 0 && cache_is_full(cache, footprint))
     {
-        evict_least_recently_used_block(cache);
+        if (new_node)
+        {
+            evict_least_recently_used_block(cache, LRU_REMOVAL_CAPACITY);
+            continue;
+        }
+
+        size_t block_size = 0;
+        void *block = evict_for_reuse(cache, needed, &block_size);
+        if (block)
+        {
+            new_node = init_node(block, block_size, key, key_len, hash, value, value_len);
+        }
+    }
+
+    // Create the entry with its key and value stored inline. While the slab
+    // memory limit leaves no room for it, evicting entries frees a chunk once
+    // a victim shares its size class, so a few are evicted in policy order
+    // while that class has entries at all; after that a page is moved over
+    // from another class. If neither works the entry is dropped rather than
+    // emptying the cache.
+    int class_id = slab_class_for(&cache->slabs, needed);
+    int evictions = 0;
+    while (!new_node)
+    {
+        LRU_TIME_START(cache, LRU_PHASE_ALLOC, alloc_start);
+        new_node = alloc_node(&cache->slabs, key, key_len, hash, value, value_len);
+        LRU_TIME_END(cache, LRU_PHASE_ALLOC, alloc_start);
+        if (new_node)
+        {
+            break;
+        }
+
+        if (cache->size > 0 && evictions < LRU_SLAB_EVICTION_BUDGET &&
+            (class_id < 0 || cache->slabs.classes[class_id].used_chunks > 0))
+        {
+            evict_least_recently_used_block(cache, LRU_REMOVAL_CAPACITY);
+            evictions++;
+            if (cache->epoch)
+            {
+                lru_cache_reclaim(cache);
+            }
+        }
+        else if (!reassign_page(cache, needed))
+        {
+            policy_abort_insert(cache);
+            return;
+        }
     }
 
-    // Create a new key-value pair
-    kv_pair_t *new_pair = kv_new_kv_pair(key, value);
-    if (!new_pair)
+    new_node->expiration = expiration; // Set custom expiration
+
+    if (!hash_index_insert(&cache->index, hash, new_node))
     {
+        free_node(&cache->slabs, new_node);
+        policy_abort_insert(cache);
         return;
     }
 
-    Node *new_node = calloc(1, sizeof(Node));
-    if (!new_node)
+    // Link the new node where the eviction policy wants it; the front of the
+    // list under LRU
+    set_usage(cache, cache->size + 1, cache->bytes_used + footprint);
+    policy_on_insert(cache, new_node);
+    schedule_expiry(cache, new_node);
+
+    add_count(&cache->counters.inserts, 1);
+    add_count(&cache->counters.bytes_written, key_len + value_len);
+}
+
+// Inserts or updates a key whose hash the caller already computed
+void lru_cache_set_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash,
+                          char *value, size_t value_len, uint64_t ttl_ms)
+{
+    if (!cache || !key || !value || ttl_ms == 0 || key_len > KV_PAIR_MAX_LEN || value_len > KV_PAIR_MAX_LEN)
     {
-        kv_free_kv_pair(new_pair);
         return;
     }
 
-    new_node->kv_pair = new_pair;
-    new_node->expiration = time(NULL) + ttl_seconds; // Set custom expiration
+    LRU_PROBE4(set, key, key_len, value_len, ttl_ms);
+    LRU_TIME_START(cache, LRU_PHASE_SET, start);
+    set_entry(cache, key, key_len, hash, value, value_len, ttl_ms);
+    LRU_TIME_END(cache, LRU_PHASE_SET, start);
+    deliver_evictions(cache, 0);
+}
 
-    // Insert the new node into the hash table
-    new_node->next = cache->hash_table[index];
-    if (cache->hash_table[index])
+// Builds an entry directly at the least recently used end of its list;
+// snapshot records arrive most recent first, so this keeps their order
+int lru_cache_restore_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash,
+                             char *value, size_t value_len, uint64_t ttl_ms,
+                             int segment, uint8_t policy_flags)
+{
+    if (!cache || !key || !value || ttl_ms == 0 || key_len > KV_PAIR_MAX_LEN || value_len > KV_PAIR_MAX_LEN)
     {
-        cache->hash_table[index]->prev = new_node;
+        return 0;
     }
-    cache->hash_table[index] = new_node;
 
-    // Add the new node to the front of the doubly linked list
-    new_node->next = cache->head;
-    new_node->prev = NULL;
+    size_t needed = node_size_for(key_len, value_len);
+    size_t footprint = entry_footprint(slab_chunk_size(&cache->slabs, needed));
+    if (entry_is_oversized(cache, footprint) || cache_is_full(cache, footprint) ||
+        hash_index_find(&cache->index, hash, key, key_len))
+    {
+        return 0;
+    }
 
-    if (cache->head)
+    Node *node = alloc_node(&cache->slabs, key, key_len, hash, value, value_len);
+    if (!node)
     {
-        cache->head->prev = new_node;
+        return 0;
     }
-    cache->head = new_node;
+    node->expiration = lru_clock_now_ms(cache->clock) + ttl_ms;
 
-    if (!cache->tail)
+    if (!hash_index_insert(&cache->index, hash, node))
     {
-        cache->tail = new_node;
+        free_node(&cache->slabs, node);
+        return 0;
     }
 
-    cache->misses++;
-    cache->size++;
+    set_usage(cache, cache->size + 1, cache->bytes_used + footprint);
+    policy_on_restore(cache, node, segment, policy_flags);
+    schedule_expiry(cache, node);
+    return 1;
 }
 
 // Frees all resources associated with the cache
@@ -293,28 +930,222 @@ void lru_cache_free(LRUCache *cache)
         return;
     }
 
-    Node *current = cache->head;
-    while (current)
-    {
-        Node *next = current->next;
+    // Removals still queued are reported while the cache is intact; any left
+    // undelivered are pinned and freed with the pinned entries below
+    deliver_evictions(cache, 1);
+    free(cache->evicted);
 
-        if (current->kv_pair)
+    for (int i = 0; i < LRU_POLICY_LISTS; i++)
+    {
+        Node *current = policy_list(cache, i)->head;
+        while (current)
         {
-            kv_free_kv_pair(current->kv_pair);
+            Node *next = current->lnext;
+            free_node(&cache->slabs, current);
+            current = next;
         }
+    }
 
-        free(current);
+    // Outstanding handles are invalidated along with the cache
+    Node *current = cache->pinned.head;
+    while (current)
+    {
+        Node *next = current->lnext;
+        free_node(&cache->slabs, current);
         current = next;
     }
 
-    if (cache->hash_table)
+    // No reader may use the cache once it is being freed
+    for (size_t i = 0; i < cache->retired_count; i++)
     {
-        free(cache->hash_table);
+        if (cache->retired[i].is_table)
+        {
+            free(cache->retired[i].ptr);
+        }
+        else
+        {
+            free_node(&cache->slabs, cache->retired[i].ptr);
+        }
     }
+    free(cache->retired);
+
+    hash_index_destroy(&cache->index);
+    slab_destroy(&cache->slabs);
+    policy_destroy(cache);
+    lru_clock_destroy(&cache->own_clock);
 
     free(cache);
 }
 
+// Switches the cache to copy-on-write updates and deferred frees so lock-free
+// readers inside the given epoch domain can safely follow node pointers
+void lru_cache_enable_concurrent_reads(LRUCache *cache, epoch_domain_t *epoch)
+{
+    if (!cache || !epoch)
+    {
+        return;
+    }
+
+    cache->epoch = epoch;
+    cache->index.retire = retire_table;
+    cache->index.retire_ctx = cache;
+}
+
+// Looks a key up without touching recency, statistics or expired entries
+Node *lru_cache_peek_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash)
+{
+    if (!cache || !key)
+    {
+        return NULL;
+    }
+
+    return hash_index_find(&cache->index, hash, key, key_len);
+}
+
+// Applies a deferred hit: the node is only moved if it is still indexed,
+// which is checked without dereferencing it
+void lru_cache_promote(LRUCache *cache, Node *node, uint64_t hash)
+{
+    if (!cache || !node)
+    {
+        return;
+    }
+
+    if (hash_index_contains(&cache->index, hash, node))
+    {
+        policy_on_hit(cache, node);
+    }
+}
+
+// Frees retired memory that every active reader has moved past
+void lru_cache_reclaim(LRUCache *cache)
+{
+    if (!cache || !cache->epoch || cache->retired_count == 0)
+    {
+        return;
+    }
+
+    uint64_t bound = epoch_reclaim_bound(cache->epoch);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < cache->retired_count; i++)
+    {
+        lru_retired_t *retired = &cache->retired[i];
+        if (retired->epoch >= bound)
+        {
+            cache->retired[kept++] = *retired;
+        }
+        else if (retired->is_table)
+        {
+            free(retired->ptr);
+        }
+        else
+        {
+            free_node(&cache->slabs, retired->ptr);
+        }
+    }
+    cache->retired_count = kept;
+}
+
+// Removes a key, reporting it to the listener as deleted
+int lru_cache_delete(LRUCache *cache, char *key)
+{
+    if (!cache || !key)
+    {
+        return 0;
+    }
+
+    size_t key_len = strlen(key);
+    return lru_cache_delete_hashed(cache, key, key_len, hash_key(cache, key, key_len));
+}
+
+// Removes a key whose hash the caller already computed; an entry found
+// expired is removed and reported as expired instead
+int lru_cache_delete_hashed(LRUCache *cache, char *key, size_t key_len, uint64_t hash)
+{
+    if (!cache || !key)
+    {
+        return 0;
+    }
+
+    Node *node = hash_index_find(&cache->index, hash, key, key_len);
+    if (!node)
+    {
+        return 0;
+    }
+
+    int live = node->expiration > lru_clock_now_ms(cache->clock);
+    if (live)
+    {
+        remove_node(cache, node, LRU_REMOVAL_EXPLICIT);
+    }
+    else
+    {
+        LRU_PROBE2(expire, key, key_len);
+        remove_node(cache, node, LRU_REMOVAL_EXPIRED);
+        add_count(&cache->counters.expirations, 1);
+    }
+
+    deliver_evictions(cache, 0);
+    return live;
+}
+
+// Installs or clears the removal listener
+void lru_cache_set_eviction_listener(LRUCache *cache, lru_eviction_listener_t fn, void *ctx)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    // Removals queued for the old listener go to it before it is replaced
+    deliver_evictions(cache, 1);
+    cache->listener = fn;
+    cache->listener_ctx = ctx;
+}
+
+// Delivers every queued removal
+void lru_cache_flush_evictions(LRUCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    deliver_evictions(cache, 1);
+}
+
+// Turns on or off queueing removals for lru_cache_take_evictions
+void lru_cache_collect_evictions(LRUCache *cache, int on)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    cache->collect_evictions = on;
+}
+
+// Moves the oldest queued removals into batch, keeping their pins
+size_t lru_cache_take_evictions(LRUCache *cache, lru_eviction_t *batch, size_t max, int partial)
+{
+    if (!cache || !batch || max == 0)
+    {
+        return 0;
+    }
+
+    size_t n = cache->evicted_count < max ? cache->evicted_count : max;
+    if (n == 0 || (n < max && !partial))
+    {
+        return 0;
+    }
+
+    memcpy(batch, cache->evicted, n * sizeof(lru_eviction_t));
+    cache->evicted_count -= n;
+    memmove(cache->evicted, cache->evicted + n, cache->evicted_count * sizeof(lru_eviction_t));
+    return n;
+}
+
 // Print the stats for the cache
 void lru_cache_print_stats(LRUCache *cache)
 {
@@ -323,71 +1154,149 @@ void lru_cache_print_stats(LRUCache *cache)
         return;
     }
 
-    if (cache->misses + cache->hits == 0)
+    lru_cache_stats_t stats;
+    lru_cache_get_stats(cache, &stats);
+
+    if (stats.misses + stats.hits == 0)
     {
         printf("No requests processed yet.\n");
         return;
     }
 
-    printf("Hits: %d\nMisses: %d\nMiss Rate: %.2f%%\n",
-           cache->hits, cache->misses, 100.0 * (double)cache->misses / (cache->misses + cache->hits));
+    printf("Hits: %llu\nMisses: %llu\nMiss Rate: %.2f%%\n", (unsigned long long)stats.hits,
+           (unsigned long long)stats.misses, 100.0 * (double)stats.misses / (double)(stats.misses + stats.hits));
+    printf("Inserts: %llu\nUpdates: %llu\nEvictions: %llu\nExpirations: %llu\n",
+           (unsigned long long)stats.inserts, (unsigned long long)stats.updates,
+           (unsigned long long)stats.evictions, (unsigned long long)stats.expirations);
+
+    if (cache->memory_limit > 0)
+    {
+        printf("Bytes Used: %zu of %zu\n", cache->bytes_used, cache->memory_limit);
+    }
 }
 
-void lru_cache_resize_cache(LRUCache *cache, int new_capacity) {
-    if (!cache || new_capacity <= 0 || new_capacity == cache->capacity) {
+// Print per-size-class occupancy of the entry allocator
+void lru_cache_print_slab_stats(LRUCache *cache)
+{
+    if (!cache)
+    {
         return;
     }
 
-    // Remove all expired nodes first
-    remove_expired_nodes(cache);
+    slab_print_stats(&cache->slabs);
+}
 
-    // If the size is already within the new capacity, no need to resize
-    if (cache->size <= new_capacity)
-    {
+void lru_cache_resize_cache(LRUCache *cache, int new_capacity) {
+    if (!cache || new_capacity <= 0 || new_capacity == cache->capacity) {
         return;
     }
 
+    // Remove all expired entries first
+    lru_cache_expire(cache, (size_t)-1);
+
     // Evict extra nodes if downsizing
     while (cache->size > new_capacity) {
-        evict_least_recently_used_block(cache);
+        evict_least_recently_used_block(cache, LRU_REMOVAL_RESIZE);
     }
 
-    Node **new_hash_table = calloc(new_capacity, sizeof(Node *));
-    if (!new_hash_table)
+    // Shrink the index along with the cache; growth happens on insert
+    if (new_capacity < cache->capacity)
+    {
+        hash_index_rehash(&cache->index, cache->size);
+    }
+
+    cache->capacity = new_capacity;
+    deliver_evictions(cache, 1);
+}
+
+void lru_cache_reset_stats(LRUCache *cache)
+{
+    if (!cache)
     {
         return;
     }
 
-    // Rehash existing nodes into the new table
-    Node *current = cache->head;
-    while (current)
+    // The counters are all uint64_t, so they can be cleared as an array
+    uint64_t *counters = (uint64_t *)&cache->counters;
+    for (size_t i = 0; i < sizeof(lru_cache_counters_t) / sizeof(uint64_t); i++)
     {
-        int new_index = key_to_index(kv_pair_get_key(current->kv_pair), new_capacity);
-        Node *next_node = current->next;
+        __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+    }
 
-        // Insert current node into the new hash table
-        current->next = new_hash_table[new_index];
-        if (new_hash_table[new_index])
-        {
-            new_hash_table[new_index]->prev = current;
-        }
-        new_hash_table[new_index] = current;
+#ifdef LRU_CACHE_INSTRUMENT
+    // The sampled timings are likewise all uint64_t
+    uint64_t *timings = (uint64_t *)&cache->instrument;
+    for (size_t i = 0; i < sizeof(lru_instrument_t) / sizeof(uint64_t); i++)
+    {
+        __atomic_store_n(&timings[i], 0, __ATOMIC_RELAXED);
+    }
+#endif
+}
 
-        current = next_node;
+// Reads each counter and gauge atomically, so the caller needs no lock
+void lru_cache_get_stats(LRUCache *cache, lru_cache_stats_t *stats)
+{
+    if (!cache || !stats)
+    {
+        return;
     }
 
-    free(cache->hash_table);
-    cache->hash_table = new_hash_table;
-    cache->capacity = new_capacity;
+    lru_cache_counters_t *counters = &cache->counters;
+    stats->hits = __atomic_load_n(&counters->hits, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&counters->misses, __ATOMIC_RELAXED);
+    stats->inserts = __atomic_load_n(&counters->inserts, __ATOMIC_RELAXED);
+    stats->updates = __atomic_load_n(&counters->updates, __ATOMIC_RELAXED);
+    stats->evictions = __atomic_load_n(&counters->evictions, __ATOMIC_RELAXED);
+    stats->expirations = __atomic_load_n(&counters->expirations, __ATOMIC_RELAXED);
+    stats->bytes_written = __atomic_load_n(&counters->bytes_written, __ATOMIC_RELAXED);
+    stats->size = (uint64_t)__atomic_load_n(&cache->size, __ATOMIC_RELAXED);
+    stats->bytes_used = __atomic_load_n(&cache->bytes_used, __ATOMIC_RELAXED);
 }
 
-void lru_cache_reset_stats(LRUCache *cache)
+// Reads each sample count atomically, like lru_cache_get_stats
+int lru_cache_get_latency(LRUCache *cache, lru_phase_t phase, lru_latency_histogram_t *histogram)
 {
-    if (!cache)
+#ifdef LRU_CACHE_INSTRUMENT
+    if (!cache || !histogram || (unsigned)phase >= LRU_PHASE_COUNT)
+    {
+        return 0;
+    }
+
+    lru_latency_histogram_t *source = &cache->instrument.phases[phase];
+    histogram->count = __atomic_load_n(&source->count, __ATOMIC_RELAXED);
+    histogram->cycles = __atomic_load_n(&source->cycles, __ATOMIC_RELAXED);
+    for (size_t i = 0; i < LRU_LATENCY_BUCKETS; i++)
     {
+        histogram->buckets[i] = __atomic_load_n(&source->buckets[i], __ATOMIC_RELAXED);
+    }
+    return 1;
+#else
+    (void)cache;
+    (void)phase;
+    (void)histogram;
+    return 0;
+#endif
+}
+
+// Print the sampled timings of every phase
+void lru_cache_print_latency(LRUCache *cache)
+{
+    lru_latency_histogram_t histogram;
+    if (!lru_cache_get_latency(cache, LRU_PHASE_GET, &histogram))
+    {
+        printf("Latency instrumentation not built in (LRU_CACHE_INSTRUMENT).\n");
         return;
     }
 
-    cache->hits = 0;
-    cache->misses = 0;
+    printf("%-8s %10s %10s %10s %10s %10s\n", "phase", "samples", "mean", "p50", "p99", "p99.9");
+    for (int phase = 0; phase < LRU_PHASE_COUNT; phase++)
+    {
+        lru_cache_get_latency(cache, (lru_phase_t)phase, &histogram);
+        double mean = histogram.count ? (double)histogram.cycles / (double)histogram.count : 0;
+        printf("%-8s %10llu %10.0f %10llu %10llu %10llu\n", lru_phase_name((lru_phase_t)phase),
+               (unsigned long long)histogram.count, mean,
+               (unsigned long long)lru_latency_percentile(&histogram, 0.5),
+               (unsigned long long)lru_latency_percentile(&histogram, 0.99),
+               (unsigned long long)lru_latency_percentile(&histogram, 0.999));
+    }
 }
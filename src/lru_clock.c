@@ -0,0 +1,111 @@
+#include "lru_clock.h"
+#include <time.h>
+
+#ifndef CLOCK_MONOTONIC_COARSE
+#define CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC
+#endif
+
+static uint64_t read_ms(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static inline void store_now(lru_clock_t *clock, uint64_t ms)
+{
+    __atomic_store_n(&clock->now_ms, ms, __ATOMIC_RELAXED);
+}
+
+// Refreshes a cached clock until asked to stop
+static void *run_ticker(void *arg)
+{
+    lru_clock_t *clock = arg;
+    struct timespec interval = {clock->tick_ms / 1000, (long)(clock->tick_ms % 1000) * 1000000};
+
+    while (!__atomic_load_n(&clock->stop, __ATOMIC_ACQUIRE))
+    {
+        store_now(clock, read_ms(CLOCK_MONOTONIC_COARSE));
+        nanosleep(&interval, NULL);
+    }
+
+    return NULL;
+}
+
+void lru_clock_init(lru_clock_t *clock, lru_clock_kind_t kind)
+{
+    clock->kind = kind;
+    clock->now_ms = read_ms(CLOCK_MONOTONIC_COARSE);
+    clock->reads = 0;
+    clock->refresh_ops = LRU_CLOCK_DEFAULT_REFRESH_OPS;
+    clock->ticking = 0;
+    clock->stop = 0;
+    clock->tick_ms = 0;
+}
+
+void lru_clock_destroy(lru_clock_t *clock)
+{
+    if (clock->ticking)
+    {
+        __atomic_store_n(&clock->stop, 1, __ATOMIC_RELEASE);
+        pthread_join(clock->ticker, NULL);
+        clock->ticking = 0;
+    }
+}
+
+uint64_t lru_clock_now_ms(lru_clock_t *clock)
+{
+    switch (clock->kind)
+    {
+    case LRU_CLOCK_MONOTONIC:
+        return read_ms(CLOCK_MONOTONIC);
+    case LRU_CLOCK_MONOTONIC_COARSE:
+        return read_ms(CLOCK_MONOTONIC_COARSE);
+    case LRU_CLOCK_CACHED:
+        if (!clock->ticking)
+        {
+            // A plain load and store rather than an atomic increment: a
+            // lost count only delays the refresh by a read
+            uint32_t reads = __atomic_load_n(&clock->reads, __ATOMIC_RELAXED) + 1;
+            if (reads >= clock->refresh_ops)
+            {
+                reads = 0;
+                store_now(clock, read_ms(CLOCK_MONOTONIC_COARSE));
+            }
+            __atomic_store_n(&clock->reads, reads, __ATOMIC_RELAXED);
+        }
+        return __atomic_load_n(&clock->now_ms, __ATOMIC_RELAXED);
+    case LRU_CLOCK_FAKE:
+        return __atomic_load_n(&clock->now_ms, __ATOMIC_RELAXED);
+    }
+
+    return 0;
+}
+
+int lru_clock_start_ticker(lru_clock_t *clock, uint32_t tick_ms)
+{
+    if (clock->kind != LRU_CLOCK_CACHED || clock->ticking || tick_ms == 0)
+    {
+        return 0;
+    }
+
+    clock->tick_ms = tick_ms;
+    clock->stop = 0;
+    if (pthread_create(&clock->ticker, NULL, run_ticker, clock) != 0)
+    {
+        return 0;
+    }
+
+    clock->ticking = 1;
+    return 1;
+}
+
+void lru_clock_set(lru_clock_t *clock, uint64_t ms)
+{
+    store_now(clock, ms);
+}
+
+void lru_clock_advance(lru_clock_t *clock, uint64_t ms)
+{
+    __atomic_fetch_add(&clock->now_ms, ms, __ATOMIC_RELAXED);
+}
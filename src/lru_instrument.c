@@ -0,0 +1,58 @@
+#include "lru_instrument.h"
+
+static const char *const phase_names[LRU_PHASE_COUNT] = {"get", "set", "hash", "lookup", "evict", "alloc"};
+
+const char *lru_phase_name(lru_phase_t phase)
+{
+    return (unsigned)phase < LRU_PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+// Buckets below 1 << LRU_LATENCY_SUB_BITS hold one duration each; above
+// that, bucket g << SUB_BITS | s starts at (1 << SUB_BITS | s) << (g - 1)
+uint64_t lru_latency_bucket_floor(size_t bucket)
+{
+    size_t sub_buckets = (size_t)1 << LRU_LATENCY_SUB_BITS;
+    if (bucket < sub_buckets)
+    {
+        return bucket;
+    }
+
+    size_t group = bucket >> LRU_LATENCY_SUB_BITS;
+    uint64_t sub = bucket & (sub_buckets - 1);
+    return (sub_buckets | sub) << (group - 1);
+}
+
+uint64_t lru_latency_percentile(const lru_latency_histogram_t *histogram, double p)
+{
+    if (!histogram || histogram->count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(p * (double)histogram->count);
+    if (rank >= histogram->count)
+    {
+        rank = histogram->count - 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LRU_LATENCY_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen > rank)
+        {
+            return lru_latency_bucket_floor(i);
+        }
+    }
+    return lru_latency_bucket_floor(LRU_LATENCY_BUCKETS - 1);
+}
+
+void lru_latency_merge(lru_latency_histogram_t *into, const lru_latency_histogram_t *from)
+{
+    into->count += from->count;
+    into->cycles += from->cycles;
+    for (size_t i = 0; i < LRU_LATENCY_BUCKETS; i++)
+    {
+        into->buckets[i] += from->buckets[i];
+    }
+}
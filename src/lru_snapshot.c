@@ -0,0 +1,379 @@
+#include "lru_cache.h"
+#include "lru_snapshot.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Records gathered for the block being written
+typedef struct snapshot_writer
+{
+    FILE *file;
+    char *buffer;
+    size_t used;
+    size_t capacity;
+    uint32_t entries;
+    uint64_t total_entries;
+} snapshot_writer_t;
+
+// Checksum of a header's fields, excluding the checksum itself
+static uint64_t header_checksum(const lru_snapshot_header_t *header)
+{
+    return wyhash64(header, offsetof(lru_snapshot_header_t, checksum), LRU_SNAPSHOT_CHECKSUM_SEED);
+}
+
+// Writes the gathered records as one block
+static int flush_block(snapshot_writer_t *writer)
+{
+    if (writer->entries == 0)
+    {
+        return 1;
+    }
+
+    lru_snapshot_block_t block = {writer->entries, (uint32_t)writer->used,
+                                  wyhash64(writer->buffer, writer->used, LRU_SNAPSHOT_CHECKSUM_SEED)};
+    if (fwrite(&block, sizeof(block), 1, writer->file) != 1 ||
+        fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used)
+    {
+        return 0;
+    }
+
+    writer->total_entries += writer->entries;
+    writer->used = 0;
+    writer->entries = 0;
+    return 1;
+}
+
+// Appends one entry's record, first writing out the block if it would overflow
+static int write_record(snapshot_writer_t *writer, Node *node, uint64_t ttl_ms, int segment)
+{
+    kv_pair_t *kv_pair = &node->kv_pair;
+    size_t size = sizeof(lru_snapshot_record_t) + kv_pair->key_len + kv_pair->value_len;
+
+    if (writer->used + size > writer->capacity && !flush_block(writer))
+    {
+        return 0;
+    }
+
+    // A record too large for a block gets a block of its own
+    if (size > writer->capacity)
+    {
+        char *buffer = realloc(writer->buffer, size);
+        if (!buffer)
+        {
+            return 0;
+        }
+        writer->buffer = buffer;
+        writer->capacity = size;
+    }
+
+    lru_snapshot_record_t record = {kv_pair->key_len, kv_pair->value_len, ttl_ms, (uint8_t)segment,
+                                    (uint8_t)(node->policy_flags & ~NODE_SEGMENT_MASK)};
+    char *out = writer->buffer + writer->used;
+    memcpy(out, &record, sizeof(record));
+    memcpy(out + sizeof(record), kv_pair->key, kv_pair->key_len);
+    memcpy(out + sizeof(record) + kv_pair->key_len, kv_pair_get_value(kv_pair), kv_pair->value_len);
+
+    writer->used += size;
+    writer->entries++;
+    return 1;
+}
+
+// Fills in the order lists are written: the one whose entries the policy
+// values most first, so a smaller cache loading the snapshot keeps those.
+// W-TinyLFU's protected segment leads and its admission window comes last;
+// ARC's T2 leads T1; CLOCK-Pro's hot list already comes first.
+static void segment_write_order(lru_policy_t policy, int order[LRU_POLICY_LISTS])
+{
+    for (int i = 0; i < LRU_POLICY_LISTS; i++)
+    {
+        order[i] = i;
+    }
+
+    if (policy == LRU_POLICY_TINYLFU)
+    {
+        order[0] = TINYLFU_PROTECTED;
+        order[1] = TINYLFU_PROBATION;
+        order[2] = TINYLFU_WINDOW;
+    }
+    else if (policy == LRU_POLICY_ARC)
+    {
+        order[0] = ARC_T2;
+        order[1] = ARC_T1;
+    }
+}
+
+// Writes the header, then every live entry list by list from head to tail,
+// most valuable list first, and fills in the entry count once it is known
+static int write_snapshot(LRUCache *cache, FILE *file)
+{
+    lru_snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LRU_SNAPSHOT_MAGIC, sizeof(LRU_SNAPSHOT_MAGIC));
+    header.version = LRU_SNAPSHOT_VERSION;
+    header.policy = (uint32_t)cache->policy;
+    header.capacity = cache->capacity;
+    header.memory_limit = cache->memory_limit;
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        return 0;
+    }
+
+    snapshot_writer_t writer = {file, malloc(LRU_SNAPSHOT_BLOCK_SIZE), 0, LRU_SNAPSHOT_BLOCK_SIZE, 0, 0};
+    if (!writer.buffer)
+    {
+        return 0;
+    }
+
+    int order[LRU_POLICY_LISTS];
+    segment_write_order(cache->policy, order);
+
+    uint64_t now = lru_clock_now_ms(cache->clock);
+    int ok = 1;
+    for (int i = 0; i < LRU_POLICY_LISTS && ok; i++)
+    {
+        int segment = order[i];
+        for (Node *node = policy_list(cache, segment)->head; node && ok; node = node->lnext)
+        {
+            // Entries that already expired would only be dropped on load
+            if (node->expiration > now)
+            {
+                ok = write_record(&writer, node, node->expiration - now, segment);
+            }
+        }
+    }
+    ok = ok && flush_block(&writer);
+    free(writer.buffer);
+
+    header.entry_count = writer.total_entries;
+    header.checksum = header_checksum(&header);
+    return ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+// Saves to a temporary file beside the target and renames it into place, so
+// a crash mid-save never leaves a truncated snapshot under the real name
+int lru_cache_save(LRUCache *cache, const char *path)
+{
+    if (!cache || !path)
+    {
+        return 0;
+    }
+
+    size_t path_len = strlen(path);
+    char *tmp_path = malloc(path_len + sizeof(".tmp"));
+    if (!tmp_path)
+    {
+        return 0;
+    }
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file)
+    {
+        free(tmp_path);
+        return 0;
+    }
+
+    int ok = write_snapshot(cache, file);
+    ok = fflush(file) == 0 && ok;
+    ok = ok && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    ok = ok && rename(tmp_path, path) == 0;
+
+    if (!ok)
+    {
+        unlink(tmp_path);
+    }
+    free(tmp_path);
+    return ok;
+}
+
+// Restores a run of parsed records, most recent first
+static void restore_records(LRUCache *cache, lru_snapshot_record_t *records, char **keys,
+                            uint64_t *hashes, size_t n, int same_policy)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        lru_snapshot_record_t *record = &records[i];
+        lru_cache_restore_hashed(cache, keys[i], record->key_len, hashes[i], keys[i] + record->key_len,
+                                 record->value_len, record->ttl_ms, same_policy ? record->segment : -1,
+                                 record->policy_flags);
+    }
+}
+
+// Verifies one block and restores its records; returns 0 if the block is
+// damaged in any way. Records are parsed and hashed a chunk at a time and
+// their index groups prefetched, so the index misses of a chunk overlap as
+// they do in lru_cache_mget. Keys and values are copied straight out of the
+// mapping; entries that do not fit the cache are skipped.
+static int restore_block(LRUCache *cache, const char *data, const lru_snapshot_block_t *block,
+                         int same_policy)
+{
+    if (wyhash64(data, block->size, LRU_SNAPSHOT_CHECKSUM_SEED) != block->checksum)
+    {
+        return 0;
+    }
+
+    lru_snapshot_record_t records[LRU_BATCH_CHUNK];
+    char *keys[LRU_BATCH_CHUNK];
+    uint64_t hashes[LRU_BATCH_CHUNK];
+    size_t pending = 0;
+
+    const char *end = data + block->size;
+    for (uint32_t i = 0; i < block->entry_count; i++)
+    {
+        lru_snapshot_record_t *record = &records[pending];
+        if ((size_t)(end - data) < sizeof(*record))
+        {
+            return 0;
+        }
+        memcpy(record, data, sizeof(*record));
+        data += sizeof(*record);
+
+        if ((size_t)(end - data) < (size_t)record->key_len + record->value_len)
+        {
+            return 0;
+        }
+
+        keys[pending] = (char *)data;
+        hashes[pending] = cache->hash_fn(keys[pending], record->key_len, cache->hash_seed);
+        hash_index_prefetch(&cache->index, hashes[pending]);
+        data += record->key_len + record->value_len;
+
+        if (++pending == LRU_BATCH_CHUNK)
+        {
+            restore_records(cache, records, keys, hashes, pending, same_policy);
+            pending = 0;
+        }
+    }
+    restore_records(cache, records, keys, hashes, pending, same_policy);
+
+    return data == end;
+}
+
+// Checks the header and restores every block of a mapped snapshot in one
+// pass; a config of NULL creates the cache the snapshot was saved from
+static LRUCache *load_mapped(const char *data, size_t size, const lru_cache_config_t *config)
+{
+    lru_snapshot_header_t header;
+    if (size < sizeof(header))
+    {
+        return NULL;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, LRU_SNAPSHOT_MAGIC, sizeof(LRU_SNAPSHOT_MAGIC)) != 0 ||
+        header.version != LRU_SNAPSHOT_VERSION || header.checksum != header_checksum(&header))
+    {
+        return NULL;
+    }
+
+    lru_cache_config_t saved;
+    if (!config)
+    {
+        lru_cache_config_init(&saved, (int)header.capacity);
+        saved.memory_limit = (size_t)header.memory_limit;
+        saved.policy = (lru_policy_t)header.policy;
+        config = &saved;
+    }
+
+    LRUCache *cache = lru_cache_create_with_config(config);
+    if (!cache)
+    {
+        return NULL;
+    }
+
+    // Size the index once for every entry rather than growing it repeatedly
+    size_t expected = (size_t)header.entry_count;
+    if (cache->capacity > 0 && expected > (size_t)cache->capacity)
+    {
+        expected = (size_t)cache->capacity;
+    }
+    hash_index_rehash(&cache->index, expected);
+
+    // Saved list positions only mean something to the same policy; under
+    // another one the entries keep their order on its starting list
+    int same_policy = (uint32_t)cache->policy == header.policy;
+
+    const char *pos = data + sizeof(header);
+    const char *end = data + size;
+    uint64_t entries = 0;
+    while (pos < end)
+    {
+        lru_snapshot_block_t block;
+        if ((size_t)(end - pos) < sizeof(block))
+        {
+            break;
+        }
+        memcpy(&block, pos, sizeof(block));
+        pos += sizeof(block);
+
+        if ((size_t)(end - pos) < block.size)
+        {
+            break;
+        }
+
+        if (!restore_block(cache, pos, &block, same_policy))
+        {
+            break;
+        }
+        pos += block.size;
+        entries += block.entry_count;
+    }
+
+    if (pos != end || entries != header.entry_count)
+    {
+        lru_cache_free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+// Creates a cache shaped like the one that was saved
+LRUCache *lru_cache_load(const char *path)
+{
+    return lru_cache_load_with_config(path, NULL);
+}
+
+// Maps the snapshot read-only and rebuilds the cache from it; the kernel is
+// told the file is read front to back so it reads ahead aggressively
+LRUCache *lru_cache_load_with_config(const char *path, const lru_cache_config_t *config)
+{
+    if (!path)
+    {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return NULL;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    LRUCache *cache = load_mapped(data, size, config);
+
+    munmap(data, size);
+    return cache;
+}
@@ -0,0 +1,310 @@
+#include "miss_ratio_curve.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MRC_INITIAL_TIMES 1024
+#define MRC_INITIAL_TABLE 1024
+
+// Adds delta at a time and every Fenwick node covering it
+static void fenwick_add(mrc_t *mrc, size_t time, int delta)
+{
+    for (; time <= mrc->time_capacity; time += time & -time)
+    {
+        mrc->tree[time] += (uint32_t)delta;
+    }
+}
+
+// Marked times at or before a time
+static size_t fenwick_prefix(mrc_t *mrc, size_t time)
+{
+    size_t sum = 0;
+    for (; time > 0; time -= time & -time)
+    {
+        sum += mrc->tree[time];
+    }
+    return sum;
+}
+
+// Rebuilds the tree from the marks in linear time
+static void fenwick_build(mrc_t *mrc)
+{
+    memset(mrc->tree, 0, (mrc->time_capacity + 1) * sizeof(uint32_t));
+    for (size_t i = 1; i <= mrc->time_capacity; i++)
+    {
+        mrc->tree[i] += mrc->marks[i];
+        size_t parent = i + (i & -i);
+        if (parent <= mrc->time_capacity)
+        {
+            mrc->tree[parent] += mrc->tree[i];
+        }
+    }
+}
+
+// Home slot of a hash in the table; the low bits of the hash are well mixed
+static inline size_t table_home(mrc_t *mrc, uint64_t hash)
+{
+    return (size_t)(hash ^ (hash >> 32)) & (mrc->table_capacity - 1);
+}
+
+// Slot holding a hash, or the empty slot where it would go
+static size_t table_find(mrc_t *mrc, uint64_t hash)
+{
+    size_t mask = mrc->table_capacity - 1;
+    size_t slot = table_home(mrc, hash);
+
+    while (mrc->table_times[slot] && mrc->table_keys[slot] != hash)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Doubles the table, reinserting every key
+static int table_grow(mrc_t *mrc)
+{
+    uint64_t *old_keys = mrc->table_keys;
+    size_t *old_times = mrc->table_times;
+    size_t old_capacity = mrc->table_capacity;
+
+    uint64_t *keys = malloc(old_capacity * 2 * sizeof(uint64_t));
+    size_t *times = calloc(old_capacity * 2, sizeof(size_t));
+    if (!keys || !times)
+    {
+        free(keys);
+        free(times);
+        return 0;
+    }
+
+    mrc->table_keys = keys;
+    mrc->table_times = times;
+    mrc->table_capacity = old_capacity * 2;
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old_times[i])
+        {
+            size_t slot = table_find(mrc, old_keys[i]);
+            mrc->table_keys[slot] = old_keys[i];
+            mrc->table_times[slot] = old_times[i];
+        }
+    }
+
+    free(old_keys);
+    free(old_times);
+    return 1;
+}
+
+// Renumbers the marked times 1..live, keeping their order, so the time
+// range stays within a small multiple of the number of distinct keys
+static void compact_times(mrc_t *mrc)
+{
+    for (size_t i = 0; i < mrc->table_capacity; i++)
+    {
+        if (mrc->table_times[i])
+        {
+            mrc->table_times[i] = fenwick_prefix(mrc, mrc->table_times[i]);
+        }
+    }
+
+    memset(mrc->marks, 0, (mrc->time_capacity + 1) * sizeof(uint8_t));
+    memset(mrc->marks + 1, 1, mrc->live);
+    mrc->now = mrc->live;
+    fenwick_build(mrc);
+}
+
+// Doubles the time range
+static int grow_times(mrc_t *mrc)
+{
+    size_t capacity = mrc->time_capacity * 2;
+    uint32_t *tree = realloc(mrc->tree, (capacity + 1) * sizeof(uint32_t));
+    if (!tree)
+    {
+        return 0;
+    }
+    mrc->tree = tree;
+
+    uint8_t *marks = realloc(mrc->marks, (capacity + 1) * sizeof(uint8_t));
+    if (!marks)
+    {
+        return 0;
+    }
+    mrc->marks = marks;
+
+    memset(mrc->marks + mrc->time_capacity + 1, 0, capacity - mrc->time_capacity);
+    mrc->time_capacity = capacity;
+    fenwick_build(mrc);
+    return 1;
+}
+
+// Counts one sampled access at a stack distance
+static int record_distance(mrc_t *mrc, size_t distance)
+{
+    if (distance >= mrc->distances_capacity)
+    {
+        size_t capacity = mrc->distances_capacity;
+        while (capacity <= distance)
+        {
+            capacity *= 2;
+        }
+
+        uint64_t *distances = realloc(mrc->distances, capacity * sizeof(uint64_t));
+        if (!distances)
+        {
+            return 0;
+        }
+        memset(distances + mrc->distances_capacity, 0, (capacity - mrc->distances_capacity) * sizeof(uint64_t));
+        mrc->distances = distances;
+        mrc->distances_capacity = capacity;
+    }
+
+    mrc->distances[distance]++;
+    return 1;
+}
+
+// Sets up empty structures; the threshold keeps hashes whose top bits fall
+// within the sampled share of their range
+int mrc_init(mrc_t *mrc, double sample_rate)
+{
+    if (!mrc || !(sample_rate > 0 && sample_rate <= 1))
+    {
+        return 0;
+    }
+
+    memset(mrc, 0, sizeof(mrc_t));
+    mrc->sample_rate = sample_rate;
+    mrc->threshold = (uint64_t)(sample_rate * (double)(1ULL << MRC_SAMPLE_BITS));
+    if (mrc->threshold == 0)
+    {
+        mrc->threshold = 1;
+    }
+
+    mrc->distances_capacity = MRC_INITIAL_TIMES;
+    mrc->distances = calloc(mrc->distances_capacity, sizeof(uint64_t));
+    mrc->time_capacity = MRC_INITIAL_TIMES;
+    mrc->tree = calloc(mrc->time_capacity + 1, sizeof(uint32_t));
+    mrc->marks = calloc(mrc->time_capacity + 1, sizeof(uint8_t));
+    mrc->table_capacity = MRC_INITIAL_TABLE;
+    mrc->table_keys = malloc(mrc->table_capacity * sizeof(uint64_t));
+    mrc->table_times = calloc(mrc->table_capacity, sizeof(size_t));
+
+    if (!mrc->distances || !mrc->tree || !mrc->marks || !mrc->table_keys || !mrc->table_times)
+    {
+        mrc_destroy(mrc);
+        return 0;
+    }
+    return 1;
+}
+
+void mrc_destroy(mrc_t *mrc)
+{
+    if (!mrc)
+    {
+        return;
+    }
+
+    free(mrc->distances);
+    free(mrc->tree);
+    free(mrc->marks);
+    free(mrc->table_keys);
+    free(mrc->table_times);
+    memset(mrc, 0, sizeof(mrc_t));
+}
+
+// Finds the key's previous access, counts the distinct keys marked after
+// it, and moves the key's mark to the current time
+int mrc_access(mrc_t *mrc, uint64_t hash)
+{
+    mrc->accesses++;
+    if ((hash >> (64 - MRC_SAMPLE_BITS)) >= mrc->threshold)
+    {
+        return 1;
+    }
+    mrc->sampled++;
+
+    if (mrc->now == mrc->time_capacity)
+    {
+        // Half the times or more are stale: renumber instead of growing
+        if (mrc->live * 2 <= mrc->time_capacity)
+        {
+            compact_times(mrc);
+        }
+        else if (!grow_times(mrc))
+        {
+            return 0;
+        }
+    }
+    size_t now = ++mrc->now;
+
+    size_t slot = table_find(mrc, hash);
+    size_t last = mrc->table_times[slot];
+    if (last)
+    {
+        if (!record_distance(mrc, mrc->live - fenwick_prefix(mrc, last) + 1))
+        {
+            return 0;
+        }
+        fenwick_add(mrc, last, -1);
+        mrc->marks[last] = 0;
+    }
+    else
+    {
+        mrc->cold++;
+        mrc->live++;
+        mrc->table_keys[slot] = hash;
+    }
+
+    fenwick_add(mrc, now, 1);
+    mrc->marks[now] = 1;
+    mrc->table_times[slot] = now;
+
+    if (!last && mrc->live * 2 > mrc->table_capacity)
+    {
+        return table_grow(mrc);
+    }
+    return 1;
+}
+
+// An access hits when its scaled distance fits in the capacity. Following
+// SHARDS-adj, the gap between the expected and actual number of sampled
+// accesses is credited to the smallest distance.
+double mrc_miss_ratio(mrc_t *mrc, size_t capacity)
+{
+    if (!mrc || mrc->sampled == 0)
+    {
+        return 0;
+    }
+
+    size_t limit = (size_t)((double)capacity * mrc->sample_rate);
+    if (limit >= mrc->distances_capacity)
+    {
+        limit = mrc->distances_capacity - 1;
+    }
+
+    double hits = 0;
+    for (size_t d = 1; d <= limit; d++)
+    {
+        hits += (double)mrc->distances[d];
+    }
+
+    double total = (double)mrc->sampled;
+    if (mrc->sample_rate < 1)
+    {
+        double adjust = (double)mrc->accesses * mrc->sample_rate - total;
+        total += adjust;
+        if (limit >= 1)
+        {
+            hits += adjust;
+        }
+    }
+
+    if (total <= 0)
+    {
+        return 0;
+    }
+    double ratio = 1.0 - hits / total;
+    return ratio < 0 ? 0 : ratio > 1 ? 1 : ratio;
+}
+
+size_t mrc_unique_keys(mrc_t *mrc)
+{
+    return mrc ? (size_t)((double)mrc->live / mrc->sample_rate) : 0;
+}
@@ -1,56 +1,191 @@
 #include "node_utils.h"
-#include "lru_cache.h" // Include full definition of LRUCache
-#include <stdlib.h>
 #include <time.h>
 
-// Moves a node to the front of the doubly linked list in the cache
-void move_node_to_front(struct LRUCache *cache, Node *node)
+// Bytes of a node before its value: the header, the key and its terminator
+static size_t node_header_size(size_t key_len)
+{
+    return offsetof(Node, kv_pair) + kv_pair_size(key_len, 0);
+}
+
+// Returns the size to request for a node with the given key and value
+size_t node_size_for(size_t key_len, size_t value_len)
+{
+    return node_header_size(key_len) + value_len + 1;
+}
+
+// Recovers the block size from the node; any slack became value capacity
+size_t node_allocation_size(Node *node)
+{
+    return node_header_size(node->kv_pair.key_len) + node->kv_pair.value_capacity;
+}
+
+// Lays out a node in a block, turning slack at the end into value capacity
+Node *init_node(void *block, size_t block_size, char *key, size_t key_len, uint64_t hash,
+                char *value, size_t value_len)
+{
+    Node *node = block;
+    size_t header = node_header_size(key_len);
+
+    node->lprev = NULL;
+    node->lnext = NULL;
+    node->expiration = 0;
+    node->timer.prev = NULL;
+    node->timer.next = NULL;
+    node->timer.deadline = 0;
+    node->policy_flags = 0;
+    node->refs = 1;
+    kv_pair_init(&node->kv_pair, key, key_len, hash, value, value_len, block_size - header);
+
+    return node;
+}
+
+// Steps back from the embedded timer link to the start of its node
+Node *node_from_timer(timer_link_t *link)
+{
+    return (Node *)((char *)link - offsetof(Node, timer));
+}
+
+// Allocates a node with its key and value stored inline after the header
+Node *alloc_node(slab_allocator_t *slabs, char *key, size_t key_len, uint64_t hash,
+                 char *value, size_t value_len)
 {
-    if (!cache || !node || cache->head == node)
+    size_t size = node_size_for(key_len, value_len);
+
+    void *block = slab_alloc(slabs, size);
+    if (!block)
+    {
+        return NULL;
+    }
+
+    return init_node(block, slab_chunk_size(slabs, size), key, key_len, hash, value, value_len);
+}
+
+// Inserts a node that is not yet on the recency list at its front
+void add_node_to_front(node_list_t *list, Node *node)
+{
+    if (!list || !node)
     {
         return;
     }
 
-    // Update the next pointer of the previous node
-    if (node->next)
+    node->lprev = NULL;
+    node->lnext = list->head;
+
+    if (list->head)
     {
-        node->next->prev = node->prev;
+        list->head->lprev = node;
     }
-    // Update the prev pointer of the next node
-    if (node->prev)
+    list->head = node;
+
+    // If the list was empty, the node is also the tail
+    if (!list->tail)
     {
-        node->prev->next = node->next;
+        list->tail = node;
     }
+}
 
-    // Update the tail pointer if the node is the tail
-    if (cache->tail == node)
+// Inserts a node that is not yet on the recency list directly after pos
+void insert_node_after(node_list_t *list, Node *pos, Node *node)
+{
+    if (!list || !pos || !node)
     {
-        cache->tail = node->prev;
+        return;
     }
 
-    // Set the node as the new head
-    node->next = cache->head;
-    node->prev = NULL;
+    node->lprev = pos;
+    node->lnext = pos->lnext;
 
-    if (cache->head)
+    if (pos->lnext)
+    {
+        pos->lnext->lprev = node;
+    }
+    else
     {
-        cache->head->prev = node;
+        list->tail = node;
     }
+    pos->lnext = node;
+}
 
-    cache->head = node;
+// Swaps a node that is not yet on the recency list into another's position
+void replace_node_in_list(node_list_t *list, Node *old_node, Node *new_node)
+{
+    if (!list || !old_node || !new_node)
+    {
+        return;
+    }
+
+    new_node->lprev = old_node->lprev;
+    new_node->lnext = old_node->lnext;
+
+    if (old_node->lprev)
+    {
+        old_node->lprev->lnext = new_node;
+    }
+    else
+    {
+        list->head = new_node;
+    }
+
+    if (old_node->lnext)
+    {
+        old_node->lnext->lprev = new_node;
+    }
+    else
+    {
+        list->tail = new_node;
+    }
+
+    old_node->lprev = NULL;
+    old_node->lnext = NULL;
+}
 
-    // If the cache was empty, update the tail pointer
-    if (!cache->tail)
+// Unlinks a node from the recency list, leaving its hash index entry untouched
+void remove_node_from_list(node_list_t *list, Node *node)
+{
+    if (!list || !node)
     {
-        cache->tail = node;
+        return;
     }
+
+    if (node->lprev)
+    {
+        node->lprev->lnext = node->lnext;
+    }
+    else
+    {
+        list->head = node->lnext;
+    }
+
+    if (node->lnext)
+    {
+        node->lnext->lprev = node->lprev;
+    }
+    else
+    {
+        list->tail = node->lprev;
+    }
+
+    node->lprev = NULL;
+    node->lnext = NULL;
+}
+
+// Moves a node to the front of the doubly linked list in the cache
+void move_node_to_front(node_list_t *list, Node *node)
+{
+    if (!list || !node || list->head == node)
+    {
+        return;
+    }
+
+    remove_node_from_list(list, node);
+    add_node_to_front(list, node);
 }
 
-// Frees the memory associated with a node
-void free_node(Node *node)
+// Returns the memory associated with a node to its allocator
+void free_node(slab_allocator_t *slabs, Node *node)
 {
     if (node)
     {
-        free(node);
+        slab_free(slabs, node, node_allocation_size(node));
     }
 }
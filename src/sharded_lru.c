@@ -0,0 +1,567 @@
+#include "sharded_lru.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Picks the shard for a hash from its top bits, which the index never uses
+static inline lru_shard_t *shard_for(ShardedLRUCache *cache, uint64_t hash)
+{
+    size_t shard = cache->shard_bits ? (size_t)(hash >> (64 - cache->shard_bits)) : 0;
+    return &cache->shards[shard];
+}
+
+// Applies every recorded hit in the shard. Must hold the shard lock. A slot
+// whose reader has claimed it but not yet filled it is skipped; promotions
+// are hints, so losing one only costs a little recency accuracy.
+static void drain_read_buffers(lru_shard_t *shard)
+{
+    if (!shard->read_buffers)
+    {
+        return;
+    }
+
+    for (int i = 0; i < SHARDED_LRU_READ_STRIPES; i++)
+    {
+        lru_read_buffer_t *buffer = &shard->read_buffers[i];
+        uint64_t head = __atomic_load_n(&buffer->head, __ATOMIC_RELAXED);
+        uint64_t tail = __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++)
+        {
+            lru_read_entry_t *entry = &buffer->entries[head % SHARDED_LRU_READ_BUFFER_SIZE];
+            Node *node = __atomic_exchange_n(&entry->node, NULL, __ATOMIC_ACQUIRE);
+            if (node)
+            {
+                uint64_t hash = __atomic_load_n(&entry->hash, __ATOMIC_RELAXED);
+                lru_cache_promote(shard->cache, node, hash);
+            }
+        }
+
+        __atomic_store_n(&buffer->head, tail, __ATOMIC_RELEASE);
+    }
+}
+
+// Records a hit in the reader's stripe, dropping it if the ring is full, and
+// drains the shard if the stripe is filling up and the lock is free
+static void record_read(lru_shard_t *shard, int thread_id, Node *node, uint64_t hash)
+{
+    lru_read_buffer_t *buffer = &shard->read_buffers[thread_id % SHARDED_LRU_READ_STRIPES];
+    uint64_t tail = __atomic_load_n(&buffer->tail, __ATOMIC_RELAXED);
+    uint64_t pending;
+
+    do
+    {
+        pending = tail - __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+        if (pending >= SHARDED_LRU_READ_BUFFER_SIZE)
+        {
+            break;
+        }
+    } while (!__atomic_compare_exchange_n(&buffer->tail, &tail, tail + 1, 1,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    if (pending < SHARDED_LRU_READ_BUFFER_SIZE)
+    {
+        lru_read_entry_t *entry = &buffer->entries[tail % SHARDED_LRU_READ_BUFFER_SIZE];
+        __atomic_store_n(&entry->hash, hash, __ATOMIC_RELAXED);
+        __atomic_store_n(&entry->node, node, __ATOMIC_RELEASE);
+    }
+
+    if (pending + 1 >= SHARDED_LRU_DRAIN_THRESHOLD && pthread_mutex_trylock(&shard->lock) == 0)
+    {
+        drain_read_buffers(shard);
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+// Copies a value into the caller's buffer and returns its full length
+static long copy_value(const char *value, size_t value_len, char *buf, size_t buf_size)
+{
+    if (buf && buf_size > 0)
+    {
+        size_t copy = value_len < buf_size - 1 ? value_len : buf_size - 1;
+        memcpy(buf, value, copy);
+        buf[copy] = '\0';
+    }
+    return (long)value_len;
+}
+
+// Serves a get without the shard lock. The epoch keeps the node alive while
+// its value is copied; expired entries are reported as misses and left for a
+// writer to remove.
+static long get_lockfree(ShardedLRUCache *cache, lru_shard_t *shard, char *key, size_t key_len,
+                         uint64_t hash, char *buf, size_t buf_size)
+{
+    int thread_id = epoch_thread_id();
+    long result = -1;
+
+    epoch_enter(cache->epoch, thread_id);
+    Node *node = lru_cache_peek_hashed(shard->cache, key, key_len, hash);
+    if (node && node->expiration > lru_clock_now_ms(shard->cache->clock))
+    {
+        result = copy_value(kv_pair_get_value(&node->kv_pair), node->kv_pair.value_len, buf, buf_size);
+    }
+    epoch_exit(cache->epoch, thread_id);
+
+    lru_read_buffer_t *buffer = &shard->read_buffers[thread_id % SHARDED_LRU_READ_STRIPES];
+    if (result < 0)
+    {
+        __atomic_fetch_add(&buffer->misses, 1, __ATOMIC_RELAXED);
+        return result;
+    }
+
+    __atomic_fetch_add(&buffer->hits, 1, __ATOMIC_RELAXED);
+    record_read(shard, thread_id, node, hash);
+    return result;
+}
+
+// Releases the shard lock, first taking each batch of queued removals and
+// handing it to the listener while the lock is not held. The entries stay
+// pinned meanwhile and are released under the lock afterwards. Must hold the
+// shard lock; returns without it.
+static void unlock_and_deliver(ShardedLRUCache *cache, lru_shard_t *shard, int partial)
+{
+    if (!cache->listener)
+    {
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+
+    lru_eviction_t batch[LRU_EVICTION_BATCH];
+    size_t n;
+    while ((n = lru_cache_take_evictions(shard->cache, batch, LRU_EVICTION_BATCH, partial)) > 0)
+    {
+        pthread_mutex_unlock(&shard->lock);
+        cache->listener(cache->listener_ctx, batch, n);
+        pthread_mutex_lock(&shard->lock);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            lru_cache_release(shard->cache, batch[i].entry);
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Releases a shard's cache and read buffers
+static void destroy_shard(lru_shard_t *shard)
+{
+    pthread_mutex_destroy(&shard->lock);
+    lru_cache_free(shard->cache);
+    free(shard->read_buffers);
+}
+
+// Creates a sharded cache with default options
+ShardedLRUCache *sharded_lru_create(int shards, int capacity)
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, capacity);
+    return sharded_lru_create_with_config(shards, &config);
+}
+
+// Creates a sharded cache whose reads take the shard lock
+ShardedLRUCache *sharded_lru_create_with_config(int shards, const lru_cache_config_t *config)
+{
+    return sharded_lru_create_with_flags(shards, config, 0);
+}
+
+// Creates the shards, splitting the item and byte limits evenly between them
+ShardedLRUCache *sharded_lru_create_with_flags(int shards, const lru_cache_config_t *config,
+                                               unsigned flags)
+{
+    if (!config || shards <= 0 || shards > SHARDED_LRU_MAX_SHARDS)
+    {
+        return NULL;
+    }
+
+    ShardedLRUCache *cache = calloc(1, sizeof(ShardedLRUCache));
+    if (!cache)
+    {
+        return NULL;
+    }
+
+    // Round the shard count up to a power of two so routing is a shift
+    while ((1 << cache->shard_bits) < shards)
+    {
+        cache->shard_bits++;
+    }
+    cache->shard_count = 1 << cache->shard_bits;
+    cache->flags = flags;
+
+    // Every shard must hash keys identically, so the seed is fixed here once
+    lru_cache_config_t shard_config = *config;
+    shard_config.hash_fn = config->hash_fn ? config->hash_fn : wyhash64;
+    shard_config.hash_seed = config->random_seed ? hash_random_seed() : config->hash_seed;
+    shard_config.random_seed = 0;
+    shard_config.capacity = (config->capacity + cache->shard_count - 1) / cache->shard_count;
+    shard_config.memory_limit = config->memory_limit / (size_t)cache->shard_count;
+    shard_config.slab_memory_limit = config->slab_memory_limit / (size_t)cache->shard_count;
+
+    cache->hash_fn = shard_config.hash_fn;
+    cache->hash_seed = shard_config.hash_seed;
+
+    if (flags & SHARDED_LRU_LOCKFREE_READS)
+    {
+        if (posix_memalign((void **)&cache->epoch, 64, sizeof(epoch_domain_t)) != 0)
+        {
+            free(cache);
+            return NULL;
+        }
+        epoch_init(cache->epoch);
+    }
+
+    if (posix_memalign((void **)&cache->shards, 64, cache->shard_count * sizeof(lru_shard_t)) != 0)
+    {
+        free(cache->epoch);
+        free(cache);
+        return NULL;
+    }
+
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        lru_shard_t *shard = &cache->shards[i];
+        shard->cache = lru_cache_create_with_config(&shard_config);
+        shard->read_buffers = NULL;
+
+        if (shard->cache && cache->epoch)
+        {
+            lru_cache_enable_concurrent_reads(shard->cache, cache->epoch);
+            if (posix_memalign((void **)&shard->read_buffers, 64,
+                               SHARDED_LRU_READ_STRIPES * sizeof(lru_read_buffer_t)) != 0)
+            {
+                lru_cache_free(shard->cache);
+                shard->cache = NULL;
+                shard->read_buffers = NULL;
+            }
+            else
+            {
+                memset(shard->read_buffers, 0, SHARDED_LRU_READ_STRIPES * sizeof(lru_read_buffer_t));
+            }
+        }
+
+        if (!shard->cache)
+        {
+            while (--i >= 0)
+            {
+                destroy_shard(&cache->shards[i]);
+            }
+            free(cache->shards);
+            free(cache->epoch);
+            free(cache);
+            return NULL;
+        }
+        pthread_mutex_init(&shard->lock, NULL);
+    }
+
+    return cache;
+}
+
+// Looks up a key under its shard's lock and copies the value out before
+// unlocking, since the entry may be evicted as soon as the lock is dropped
+long sharded_lru_get(ShardedLRUCache *cache, char *key, char *buf, size_t buf_size)
+{
+    if (!cache || !key)
+    {
+        return -1;
+    }
+
+    return sharded_lru_get_bin(cache, key, strlen(key), buf, buf_size);
+}
+
+// Looks up a key of explicit length, copying its value as sharded_lru_get does
+long sharded_lru_get_bin(ShardedLRUCache *cache, char *key, size_t key_len, char *buf, size_t buf_size)
+{
+    if (!cache || !key)
+    {
+        return -1;
+    }
+
+    uint64_t hash = cache->hash_fn(key, key_len, cache->hash_seed);
+    lru_shard_t *shard = shard_for(cache, hash);
+
+    if (cache->flags & SHARDED_LRU_LOCKFREE_READS)
+    {
+        return get_lockfree(cache, shard, key, key_len, hash, buf, buf_size);
+    }
+
+    long result = -1;
+
+    pthread_mutex_lock(&shard->lock);
+    size_t value_len;
+    char *value = lru_cache_get_hashed(shard->cache, key, key_len, hash, &value_len);
+    if (value)
+    {
+        result = copy_value(value, value_len, buf, buf_size);
+    }
+    unlock_and_deliver(cache, shard, 0);
+
+    return result;
+}
+
+// Pins an entry under its shard's lock; the pin, not the lock, keeps the
+// value readable once the lock is dropped
+lru_handle_t *sharded_lru_acquire(ShardedLRUCache *cache, char *key)
+{
+    if (!cache || !key)
+    {
+        return NULL;
+    }
+
+    size_t key_len = strlen(key);
+    uint64_t hash = cache->hash_fn(key, key_len, cache->hash_seed);
+    lru_shard_t *shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    drain_read_buffers(shard);
+    lru_handle_t *handle = lru_cache_acquire_hashed(shard->cache, key, key_len, hash);
+    unlock_and_deliver(cache, shard, 0);
+
+    return handle;
+}
+
+// Unpins an entry in the shard its stored hash routes to
+void sharded_lru_release(ShardedLRUCache *cache, lru_handle_t *handle)
+{
+    if (!cache || !handle)
+    {
+        return;
+    }
+
+    lru_shard_t *shard = shard_for(cache, handle->kv_pair.hash);
+
+    pthread_mutex_lock(&shard->lock);
+    lru_cache_release(shard->cache, handle);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Inserts or updates a key-value pair with the default expiration
+void sharded_lru_set(ShardedLRUCache *cache, char *key, char *value)
+{
+    sharded_lru_set_with_expiration(cache, key, value, DEFAULT_EXPIRATION_MS);
+}
+
+// Inserts or updates a key-value pair in its shard
+void sharded_lru_set_with_expiration(ShardedLRUCache *cache, char *key, char *value, uint64_t ttl_ms)
+{
+    if (!cache || !key || !value)
+    {
+        return;
+    }
+
+    sharded_lru_set_bin(cache, key, strlen(key), value, strlen(value), ttl_ms);
+}
+
+// Inserts or updates a key and value of explicit lengths in their shard
+void sharded_lru_set_bin(ShardedLRUCache *cache, char *key, size_t key_len, char *value,
+                         size_t value_len, uint64_t ttl_ms)
+{
+    if (!cache || !key || !value || key_len > KV_PAIR_MAX_LEN || value_len > KV_PAIR_MAX_LEN)
+    {
+        return;
+    }
+
+    uint64_t hash = cache->hash_fn(key, key_len, cache->hash_seed);
+    lru_shard_t *shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    drain_read_buffers(shard);
+    lru_cache_set_hashed(shard->cache, key, key_len, hash, value, value_len, ttl_ms);
+    unlock_and_deliver(cache, shard, 0);
+}
+
+// Removes a key from its shard
+int sharded_lru_delete(ShardedLRUCache *cache, char *key)
+{
+    if (!cache || !key)
+    {
+        return 0;
+    }
+
+    size_t key_len = strlen(key);
+    uint64_t hash = cache->hash_fn(key, key_len, cache->hash_seed);
+    lru_shard_t *shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    drain_read_buffers(shard);
+    int removed = lru_cache_delete_hashed(shard->cache, key, key_len, hash);
+    unlock_and_deliver(cache, shard, 0);
+
+    return removed;
+}
+
+// Has every shard queue its removals for delivery outside the shard lock
+void sharded_lru_set_eviction_listener(ShardedLRUCache *cache, lru_eviction_listener_t fn, void *ctx)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    // Removals queued for the old listener go to it before it is replaced
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        pthread_mutex_lock(&cache->shards[i].lock);
+        unlock_and_deliver(cache, &cache->shards[i], 1);
+    }
+
+    cache->listener = fn;
+    cache->listener_ctx = ctx;
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        pthread_mutex_lock(&cache->shards[i].lock);
+        lru_cache_collect_evictions(cache->shards[i].cache, fn != NULL);
+        pthread_mutex_unlock(&cache->shards[i].lock);
+    }
+}
+
+// Frees every shard and the front end
+void sharded_lru_free(ShardedLRUCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        pthread_mutex_lock(&cache->shards[i].lock);
+        unlock_and_deliver(cache, &cache->shards[i], 1);
+    }
+
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        destroy_shard(&cache->shards[i]);
+    }
+
+    free(cache->shards);
+    free(cache->epoch);
+    free(cache);
+}
+
+// Sums the statistics of every shard. Each shard's counters are written
+// only by its lock holder and the read buffers' by atomic adds, so all of
+// them can be read while the shards keep serving requests.
+void sharded_lru_get_stats(ShardedLRUCache *cache, sharded_lru_stats_t *stats)
+{
+    if (!cache || !stats)
+    {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        lru_shard_t *shard = &cache->shards[i];
+
+        lru_cache_stats_t part;
+        lru_cache_get_stats(shard->cache, &part);
+        stats->hits += part.hits;
+        stats->misses += part.misses;
+        stats->inserts += part.inserts;
+        stats->updates += part.updates;
+        stats->evictions += part.evictions;
+        stats->expirations += part.expirations;
+        stats->bytes_written += part.bytes_written;
+        stats->size += part.size;
+        stats->bytes_used += part.bytes_used;
+
+        for (int j = 0; shard->read_buffers && j < SHARDED_LRU_READ_STRIPES; j++)
+        {
+            stats->hits += __atomic_load_n(&shard->read_buffers[j].hits, __ATOMIC_RELAXED);
+            stats->misses += __atomic_load_n(&shard->read_buffers[j].misses, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Merges the sampled timings of every shard; like the counters they have a
+// single writer per shard and can be read at any time
+int sharded_lru_get_latency(ShardedLRUCache *cache, lru_phase_t phase, lru_latency_histogram_t *histogram)
+{
+    if (!cache || !histogram)
+    {
+        return 0;
+    }
+
+    memset(histogram, 0, sizeof(*histogram));
+
+    lru_latency_histogram_t part;
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        if (!lru_cache_get_latency(cache->shards[i].cache, phase, &part))
+        {
+            return 0;
+        }
+        lru_latency_merge(histogram, &part);
+    }
+    return 1;
+}
+
+// Prints the aggregated statistics
+void sharded_lru_print_stats(ShardedLRUCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    sharded_lru_stats_t stats;
+    sharded_lru_get_stats(cache, &stats);
+
+    if (stats.hits + stats.misses == 0)
+    {
+        printf("No requests processed yet.\n");
+        return;
+    }
+
+    printf("Shards: %d\nHits: %llu\nMisses: %llu\nMiss Rate: %.2f%%\n",
+           cache->shard_count, (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           100.0 * (double)stats.misses / (double)(stats.misses + stats.hits));
+    printf("Inserts: %llu\nUpdates: %llu\nEvictions: %llu\nExpirations: %llu\n",
+           (unsigned long long)stats.inserts, (unsigned long long)stats.updates,
+           (unsigned long long)stats.evictions, (unsigned long long)stats.expirations);
+}
+
+// Resets the statistics of every shard
+void sharded_lru_reset_stats(ShardedLRUCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        lru_shard_t *shard = &cache->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        lru_cache_reset_stats(shard->cache);
+        pthread_mutex_unlock(&shard->lock);
+
+        for (int j = 0; shard->read_buffers && j < SHARDED_LRU_READ_STRIPES; j++)
+        {
+            __atomic_store_n(&shard->read_buffers[j].hits, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&shard->read_buffers[j].misses, 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Applies pending promotions, frees retired entries and delivers queued
+// removals shard by shard; in lock-free read mode this bounds how stale the
+// recency order can get
+void sharded_lru_maintenance(ShardedLRUCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        lru_shard_t *shard = &cache->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        drain_read_buffers(shard);
+        lru_cache_reclaim(shard->cache);
+        unlock_and_deliver(cache, shard, 1);
+    }
+}
@@ -0,0 +1,657 @@
+#include "shm_cache.h"
+#include "hash_utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Byte offsets of the bucket array and the first slot within a region
+typedef struct shm_layout
+{
+    uint32_t bucket_count;
+    size_t buckets_offset;
+    size_t slots_offset;
+    uint64_t slot_stride;
+    size_t region_size;
+} shm_layout_t;
+
+// Rounds up to a multiple of a power of two
+static inline size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Works out where everything goes for a capacity and slot size; buckets
+// are the next power of two at or above the capacity. One slot beyond the
+// capacity is kept spare, so an update always has a free slot to write the
+// new value into while the old one stays live.
+static void region_layout(uint32_t capacity, uint32_t slot_size, shm_layout_t *layout)
+{
+    uint32_t buckets = 1;
+    while (buckets < capacity)
+    {
+        buckets <<= 1;
+    }
+
+    layout->bucket_count = buckets;
+    layout->buckets_offset = align_up(sizeof(shm_cache_header_t), 64);
+    layout->slots_offset = align_up(layout->buckets_offset + (size_t)buckets * sizeof(uint32_t), 64);
+    layout->slot_stride = align_up(sizeof(shm_entry_t) + slot_size, 8);
+    layout->region_size = layout->slots_offset + ((size_t)capacity + 1) * layout->slot_stride;
+}
+
+// Milliseconds of wall-clock time; unlike the monotonic clocks it means the
+// same in every process and after a reboot
+static uint64_t realtime_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Reads the kernel's id for the current boot, or leaves zeros if it has none
+static void read_boot_id(char *boot_id)
+{
+    memset(boot_id, 0, SHM_CACHE_BOOT_ID_SIZE);
+
+    FILE *file = fopen("/proc/sys/kernel/random/boot_id", "r");
+    if (file)
+    {
+        if (!fgets(boot_id, SHM_CACHE_BOOT_ID_SIZE, file))
+        {
+            memset(boot_id, 0, SHM_CACHE_BOOT_ID_SIZE);
+        }
+        fclose(file);
+    }
+}
+
+// Sets up the region's mutex to be shared between processes and to report
+// a holder's death to the next locker
+static int init_lock(pthread_mutex_t *lock)
+{
+    pthread_mutexattr_t attr;
+    if (pthread_mutexattr_init(&attr) != 0)
+    {
+        return 0;
+    }
+
+    int ok = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0 &&
+             pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) == 0 &&
+             pthread_mutex_init(lock, &attr) == 0;
+
+    pthread_mutexattr_destroy(&attr);
+    return ok;
+}
+
+// Finds a slot from its number
+static inline shm_entry_t *entry_at(shm_cache_t *cache, uint32_t slot)
+{
+    return (shm_entry_t *)(cache->slots + (size_t)slot * cache->header->slot_stride);
+}
+
+// Bucket a hash falls in
+static inline uint32_t *bucket_for(shm_cache_t *cache, uint64_t hash)
+{
+    return &cache->buckets[hash & (cache->header->bucket_count - 1)];
+}
+
+// Looks a key up in its bucket's chain
+static uint32_t find_slot(shm_cache_t *cache, uint64_t hash, char *key, size_t key_len)
+{
+    for (uint32_t slot = *bucket_for(cache, hash); slot != SHM_CACHE_NIL; slot = entry_at(cache, slot)->chain)
+    {
+        shm_entry_t *entry = entry_at(cache, slot);
+        if (entry->hash == hash && entry->key_len == key_len && memcmp(entry->data, key, key_len) == 0)
+        {
+            return slot;
+        }
+    }
+
+    return SHM_CACHE_NIL;
+}
+
+// Adds a slot at the front of its bucket's chain
+static void chain_link(shm_cache_t *cache, uint32_t slot)
+{
+    uint32_t *bucket = bucket_for(cache, entry_at(cache, slot)->hash);
+    entry_at(cache, slot)->chain = *bucket;
+    *bucket = slot;
+}
+
+// Takes a slot out of its bucket's chain
+static void chain_unlink(shm_cache_t *cache, uint32_t slot)
+{
+    uint32_t *link = bucket_for(cache, entry_at(cache, slot)->hash);
+    while (*link != SHM_CACHE_NIL && *link != slot)
+    {
+        link = &entry_at(cache, *link)->chain;
+    }
+
+    if (*link == slot)
+    {
+        *link = entry_at(cache, slot)->chain;
+    }
+}
+
+// Links a slot at the most recently used end of the list
+static void list_push_front(shm_cache_t *cache, uint32_t slot)
+{
+    shm_cache_header_t *header = cache->header;
+    shm_entry_t *entry = entry_at(cache, slot);
+
+    entry->prev = SHM_CACHE_NIL;
+    entry->next = header->head;
+    if (header->head != SHM_CACHE_NIL)
+    {
+        entry_at(cache, header->head)->prev = slot;
+    }
+    header->head = slot;
+    if (header->tail == SHM_CACHE_NIL)
+    {
+        header->tail = slot;
+    }
+}
+
+// Links a slot at the least recently used end of the list
+static void list_push_back(shm_cache_t *cache, uint32_t slot)
+{
+    shm_cache_header_t *header = cache->header;
+    shm_entry_t *entry = entry_at(cache, slot);
+
+    entry->next = SHM_CACHE_NIL;
+    entry->prev = header->tail;
+    if (header->tail != SHM_CACHE_NIL)
+    {
+        entry_at(cache, header->tail)->next = slot;
+    }
+    header->tail = slot;
+    if (header->head == SHM_CACHE_NIL)
+    {
+        header->head = slot;
+    }
+}
+
+// Unlinks a slot from the recency list
+static void list_unlink(shm_cache_t *cache, uint32_t slot)
+{
+    shm_cache_header_t *header = cache->header;
+    shm_entry_t *entry = entry_at(cache, slot);
+
+    if (entry->prev != SHM_CACHE_NIL)
+    {
+        entry_at(cache, entry->prev)->next = entry->next;
+    }
+    else
+    {
+        header->head = entry->next;
+    }
+
+    if (entry->next != SHM_CACHE_NIL)
+    {
+        entry_at(cache, entry->next)->prev = entry->prev;
+    }
+    else
+    {
+        header->tail = entry->prev;
+    }
+}
+
+// Marks a slot unused before anything else about it changes, then puts it
+// on the free list
+static void free_slot(shm_cache_t *cache, uint32_t slot)
+{
+    shm_entry_t *entry = entry_at(cache, slot);
+    __atomic_store_n(&entry->state, SHM_ENTRY_FREE, __ATOMIC_RELEASE);
+    entry->chain = cache->header->free_head;
+    cache->header->free_head = slot;
+}
+
+// Removes a live entry from the index and the list and frees its slot
+static void remove_slot(shm_cache_t *cache, uint32_t slot)
+{
+    chain_unlink(cache, slot);
+    list_unlink(cache, slot);
+    cache->header->size--;
+    free_slot(cache, slot);
+}
+
+// Pops a slot that holds no entry: from the free list, else one never used
+static uint32_t pop_free_slot(shm_cache_t *cache)
+{
+    shm_cache_header_t *header = cache->header;
+
+    if (header->free_head != SHM_CACHE_NIL)
+    {
+        uint32_t slot = header->free_head;
+        header->free_head = entry_at(cache, slot)->chain;
+        return slot;
+    }
+
+    if (header->unused <= header->capacity)
+    {
+        return header->unused++;
+    }
+
+    return SHM_CACHE_NIL;
+}
+
+// A live slot and its stamp, for ordering slots during a rebuild
+typedef struct shm_stamped_slot
+{
+    uint64_t stamp;
+    uint32_t slot;
+} shm_stamped_slot_t;
+
+// Orders slots most recently used first
+static int compare_stamps(const void *a, const void *b)
+{
+    uint64_t x = ((const shm_stamped_slot_t *)a)->stamp;
+    uint64_t y = ((const shm_stamped_slot_t *)b)->stamp;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+// Rebuilds the index, recency list and free list from the slots alone,
+// after a process died part way through changing them. Live slots are
+// relinked in stamp order; of two live slots with the same key, left when a
+// set died before freeing the old one, the more recent wins.
+static void rebuild(shm_cache_t *cache)
+{
+    shm_cache_header_t *header = cache->header;
+
+    memset(cache->buckets, 0xff, (size_t)header->bucket_count * sizeof(uint32_t));
+    header->head = SHM_CACHE_NIL;
+    header->tail = SHM_CACHE_NIL;
+    header->free_head = SHM_CACHE_NIL;
+    header->size = 0;
+    if (header->unused > header->capacity + 1)
+    {
+        header->unused = header->capacity + 1;
+    }
+
+    shm_stamped_slot_t *live = malloc(((size_t)header->unused + 1) * sizeof(shm_stamped_slot_t));
+    size_t live_count = 0;
+
+    for (uint32_t slot = 0; slot < header->unused; slot++)
+    {
+        shm_entry_t *entry = entry_at(cache, slot);
+        int valid = entry->state == SHM_ENTRY_LIVE &&
+                    (uint64_t)entry->key_len + entry->value_len <= header->slot_size;
+        if (live && valid)
+        {
+            live[live_count++] = (shm_stamped_slot_t){entry->stamp, slot};
+            if (entry->stamp > header->stamp)
+            {
+                header->stamp = entry->stamp;
+            }
+        }
+        else
+        {
+            // Without memory to sort them, the entries are dropped
+            free_slot(cache, slot);
+        }
+    }
+
+    if (live_count > 0)
+    {
+        qsort(live, live_count, sizeof(shm_stamped_slot_t), compare_stamps);
+    }
+    for (size_t i = 0; i < live_count; i++)
+    {
+        uint32_t slot = live[i].slot;
+        shm_entry_t *entry = entry_at(cache, slot);
+        if (find_slot(cache, entry->hash, entry->data, entry->key_len) != SHM_CACHE_NIL)
+        {
+            free_slot(cache, slot);
+            continue;
+        }
+
+        chain_link(cache, slot);
+        list_push_back(cache, slot);
+        header->size++;
+    }
+
+    // Never come back holding more entries than the capacity
+    while (header->size > header->capacity)
+    {
+        remove_slot(cache, header->tail);
+    }
+
+    free(live);
+    header->recoveries++;
+}
+
+// Takes the region's lock, repairing the region first if the previous
+// holder died with it
+static void lock_region(shm_cache_t *cache)
+{
+    if (pthread_mutex_lock(&cache->header->lock) == EOWNERDEAD)
+    {
+        rebuild(cache);
+        pthread_mutex_consistent(&cache->header->lock);
+    }
+}
+
+static void unlock_region(shm_cache_t *cache)
+{
+    pthread_mutex_unlock(&cache->header->lock);
+}
+
+// Fills a config with default geometry
+void shm_cache_config_init(shm_cache_config_t *config, uint32_t capacity)
+{
+    if (!config)
+    {
+        return;
+    }
+
+    config->capacity = capacity;
+    config->slot_size = SHM_CACHE_DEFAULT_SLOT_SIZE;
+}
+
+// Lays out a new region in a zero-filled mapping; the magic is written last
+// so a creator that dies part way leaves a region the next opener redoes
+static int init_region(shm_cache_t *cache, const shm_cache_config_t *config, const shm_layout_t *layout)
+{
+    shm_cache_header_t *header = cache->header;
+
+    header->version = SHM_CACHE_VERSION;
+    header->capacity = config->capacity;
+    header->bucket_count = layout->bucket_count;
+    header->slot_size = config->slot_size;
+    header->slot_stride = layout->slot_stride;
+    header->region_size = layout->region_size;
+    header->hash_seed = hash_random_seed();
+    read_boot_id(header->boot_id);
+    header->head = SHM_CACHE_NIL;
+    header->tail = SHM_CACHE_NIL;
+    header->free_head = SHM_CACHE_NIL;
+    header->unused = 0;
+    header->size = 0;
+    memset(cache->buckets, 0xff, (size_t)layout->bucket_count * sizeof(uint32_t));
+
+    if (!init_lock(&header->lock))
+    {
+        return 0;
+    }
+
+    memcpy(header->magic, SHM_CACHE_MAGIC, sizeof(SHM_CACHE_MAGIC));
+    return 1;
+}
+
+// Checks an existing region against the layout its own header implies
+static int region_is_valid(shm_cache_header_t *header, size_t file_size)
+{
+    if (memcmp(header->magic, SHM_CACHE_MAGIC, sizeof(SHM_CACHE_MAGIC)) != 0 ||
+        header->version != SHM_CACHE_VERSION || header->capacity == 0)
+    {
+        return 0;
+    }
+
+    shm_layout_t layout = {0};
+    region_layout(header->capacity, header->slot_size, &layout);
+    return layout.region_size == file_size && header->region_size == file_size &&
+           layout.bucket_count == header->bucket_count && layout.slot_stride == header->slot_stride;
+}
+
+// Maps the region, creating it under an exclusive file lock when it is new
+// or was never finished. After a reboot the lock word may still claim an
+// owner that no longer exists, so the lock is set up again and the region
+// rebuilt, as after a crash.
+shm_cache_t *shm_cache_open(const char *path, const shm_cache_config_t *config)
+{
+    if (!path)
+    {
+        return NULL;
+    }
+
+    shm_cache_t *cache = calloc(1, sizeof(shm_cache_t));
+    if (!cache)
+    {
+        return NULL;
+    }
+
+    cache->fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (cache->fd < 0)
+    {
+        free(cache);
+        return NULL;
+    }
+    flock(cache->fd, LOCK_EX);
+
+    struct stat st;
+    int ok = fstat(cache->fd, &st) == 0;
+    int create = ok && st.st_size == 0;
+
+    shm_layout_t layout = {0};
+    if (create)
+    {
+        ok = config && config->capacity > 0 && config->capacity < SHM_CACHE_NIL - 1 && config->slot_size > 0;
+        if (ok)
+        {
+            region_layout(config->capacity, config->slot_size, &layout);
+            ok = ftruncate(cache->fd, (off_t)layout.region_size) == 0;
+        }
+        cache->region_size = layout.region_size;
+    }
+    else
+    {
+        cache->region_size = (size_t)st.st_size;
+        ok = ok && cache->region_size >= sizeof(shm_cache_header_t);
+    }
+
+    void *region = MAP_FAILED;
+    if (ok)
+    {
+        region = mmap(NULL, cache->region_size, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+        ok = region != MAP_FAILED;
+    }
+
+    if (ok)
+    {
+        cache->header = region;
+        if (!create && cache->header->magic[0] == '\0' && config && config->capacity > 0)
+        {
+            // A creator died before finishing; start over if the size agrees
+            region_layout(config->capacity, config->slot_size, &layout);
+            create = layout.region_size == cache->region_size;
+            if (create)
+            {
+                memset(region, 0, cache->region_size);
+            }
+        }
+
+        if (create)
+        {
+            cache->buckets = (uint32_t *)((char *)region + layout.buckets_offset);
+            cache->slots = (char *)region + layout.slots_offset;
+            ok = init_region(cache, config, &layout);
+        }
+        else if ((ok = region_is_valid(cache->header, cache->region_size)))
+        {
+            region_layout(cache->header->capacity, cache->header->slot_size, &layout);
+            cache->buckets = (uint32_t *)((char *)region + layout.buckets_offset);
+            cache->slots = (char *)region + layout.slots_offset;
+
+            char boot_id[SHM_CACHE_BOOT_ID_SIZE];
+            read_boot_id(boot_id);
+            if (memcmp(boot_id, cache->header->boot_id, SHM_CACHE_BOOT_ID_SIZE) != 0)
+            {
+                ok = init_lock(&cache->header->lock);
+                rebuild(cache);
+                memcpy(cache->header->boot_id, boot_id, SHM_CACHE_BOOT_ID_SIZE);
+            }
+        }
+    }
+
+    flock(cache->fd, LOCK_UN);
+
+    if (!ok)
+    {
+        if (region != MAP_FAILED)
+        {
+            munmap(region, cache->region_size);
+        }
+        close(cache->fd);
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+// Unmaps the region and closes the file
+void shm_cache_close(shm_cache_t *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    munmap(cache->header, cache->region_size);
+    close(cache->fd);
+    free(cache);
+}
+
+// Looks a key up under the region lock and copies the value out before
+// unlocking, since another process may evict it as soon as the lock drops
+long shm_cache_get(shm_cache_t *cache, char *key, size_t key_len, char *buf, size_t buf_size)
+{
+    if (!cache || !key)
+    {
+        return -1;
+    }
+
+    shm_cache_header_t *header = cache->header;
+    uint64_t hash = wyhash64(key, key_len, header->hash_seed);
+
+    lock_region(cache);
+    uint32_t slot = find_slot(cache, hash, key, key_len);
+    if (slot != SHM_CACHE_NIL && entry_at(cache, slot)->expiration <= realtime_ms())
+    {
+        remove_slot(cache, slot);
+        slot = SHM_CACHE_NIL;
+    }
+
+    if (slot == SHM_CACHE_NIL)
+    {
+        header->misses++;
+        unlock_region(cache);
+        return -1;
+    }
+
+    shm_entry_t *entry = entry_at(cache, slot);
+    size_t value_len = entry->value_len;
+    if (buf && buf_size > 0)
+    {
+        size_t copy = value_len < buf_size - 1 ? value_len : buf_size - 1;
+        memcpy(buf, entry->data + entry->key_len, copy);
+        buf[copy] = '\0';
+    }
+
+    entry->stamp = ++header->stamp;
+    if (header->head != slot)
+    {
+        list_unlink(cache, slot);
+        list_push_front(cache, slot);
+    }
+    header->hits++;
+    unlock_region(cache);
+
+    return (long)value_len;
+}
+
+// Writes the new entry into a free slot and marks it live before the old
+// entry, if any, is unlinked, so a crash at any point leaves either the old
+// or the new value for the rebuild to find
+int shm_cache_set(shm_cache_t *cache, char *key, size_t key_len, char *value, size_t value_len,
+                  uint64_t ttl_ms)
+{
+    if (!cache || !key || !value || ttl_ms == 0)
+    {
+        return 0;
+    }
+
+    shm_cache_header_t *header = cache->header;
+    if (key_len + value_len > header->slot_size)
+    {
+        return 0;
+    }
+
+    uint64_t hash = wyhash64(key, key_len, header->hash_seed);
+
+    lock_region(cache);
+    uint32_t old = find_slot(cache, hash, key, key_len);
+    if (old == SHM_CACHE_NIL && header->size >= header->capacity)
+    {
+        remove_slot(cache, header->tail);
+        header->evictions++;
+    }
+
+    uint32_t slot = pop_free_slot(cache);
+
+    shm_entry_t *entry = entry_at(cache, slot);
+    entry->hash = hash;
+    entry->expiration = realtime_ms() + ttl_ms;
+    entry->stamp = ++header->stamp;
+    entry->key_len = (uint32_t)key_len;
+    entry->value_len = (uint32_t)value_len;
+    memcpy(entry->data, key, key_len);
+    memcpy(entry->data + key_len, value, value_len);
+    __atomic_store_n(&entry->state, SHM_ENTRY_LIVE, __ATOMIC_RELEASE);
+
+    if (old != SHM_CACHE_NIL)
+    {
+        remove_slot(cache, old);
+    }
+    chain_link(cache, slot);
+    list_push_front(cache, slot);
+    header->size++;
+
+    unlock_region(cache);
+    return 1;
+}
+
+// Removes a key if it is cached
+int shm_cache_delete(shm_cache_t *cache, char *key, size_t key_len)
+{
+    if (!cache || !key)
+    {
+        return 0;
+    }
+
+    uint64_t hash = wyhash64(key, key_len, cache->header->hash_seed);
+
+    lock_region(cache);
+    uint32_t slot = find_slot(cache, hash, key, key_len);
+    if (slot != SHM_CACHE_NIL)
+    {
+        remove_slot(cache, slot);
+    }
+    unlock_region(cache);
+
+    return slot != SHM_CACHE_NIL;
+}
+
+// Copies the counters under the lock so they are consistent with each other
+void shm_cache_get_stats(shm_cache_t *cache, shm_cache_stats_t *stats)
+{
+    if (!cache || !stats)
+    {
+        return;
+    }
+
+    lock_region(cache);
+    stats->hits = cache->header->hits;
+    stats->misses = cache->header->misses;
+    stats->evictions = cache->header->evictions;
+    stats->recoveries = cache->header->recoveries;
+    stats->size = cache->header->size;
+    stats->capacity = cache->header->capacity;
+    unlock_region(cache);
+}
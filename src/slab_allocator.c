@@ -0,0 +1,530 @@
+#include "slab_allocator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// Chunks are multiples of this, so any chunk can hold a Node
+#define SLAB_CHUNK_ALIGNMENT 16
+
+static size_t align_up(size_t size)
+{
+    return (size + SLAB_CHUNK_ALIGNMENT - 1) & ~(size_t)(SLAB_CHUNK_ALIGNMENT - 1);
+}
+
+// Builds the class table: geometric steps from the minimum chunk up to half a
+// page, then a final class holding one whole page
+static void init_classes(slab_allocator_t *slabs)
+{
+    size_t size = SLAB_MIN_CHUNK_SIZE;
+    int count = 0;
+
+    while (count < SLAB_MAX_CLASSES - 1 && size <= slabs->page_size / 2)
+    {
+        slabs->classes[count++].chunk_size = size;
+
+        size_t next = align_up((size_t)(size * SLAB_GROWTH_FACTOR));
+        size = next > size ? next : size + SLAB_CHUNK_ALIGNMENT;
+    }
+    slabs->classes[count++].chunk_size = slabs->page_size;
+
+    slabs->class_count = count;
+}
+
+// Initialises an allocator and optionally reserves its whole budget
+int slab_init(slab_allocator_t *slabs, size_t page_size, size_t memory_limit, int preallocate)
+{
+    if (!slabs)
+    {
+        return 0;
+    }
+
+    *slabs = (slab_allocator_t){0};
+    slabs->page_size = align_up(page_size ? page_size : SLAB_DEFAULT_PAGE_SIZE);
+    slabs->memory_limit = memory_limit;
+    init_classes(slabs);
+
+    if (preallocate && memory_limit >= slabs->page_size)
+    {
+        slabs->prealloc_pages = memory_limit / slabs->page_size;
+        slabs->prealloc_base = malloc(slabs->prealloc_pages * slabs->page_size);
+        if (!slabs->prealloc_base)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Frees the preallocated region and every page allocated since
+void slab_destroy(slab_allocator_t *slabs)
+{
+    if (!slabs)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < slabs->page_count; i++)
+    {
+        free(slabs->pages[i]);
+    }
+    free(slabs->pages);
+    free(slabs->page_map);
+    free(slabs->prealloc_base);
+
+    *slabs = (slab_allocator_t){0};
+}
+
+// Finds the smallest class whose chunks fit the request
+int slab_class_for(slab_allocator_t *slabs, size_t size)
+{
+    if (!slabs || size > slabs->page_size)
+    {
+        return -1;
+    }
+
+    // Binary search over the increasing chunk sizes
+    int low = 0, high = slabs->class_count - 1;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (slabs->classes[mid].chunk_size < size)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Returns how many bytes a request of the given size actually receives
+size_t slab_chunk_size(slab_allocator_t *slabs, size_t size)
+{
+    int id = slab_class_for(slabs, size);
+    return id < 0 ? align_up(size) : slabs->classes[id].chunk_size;
+}
+
+// Reserves bytes against the memory limit
+static int reserve_memory(slab_allocator_t *slabs, size_t bytes)
+{
+    if (slabs->memory_limit && slabs->memory_allocated + bytes > slabs->memory_limit)
+    {
+        return 0;
+    }
+
+    slabs->memory_allocated += bytes;
+    return 1;
+}
+
+// Index in the page map of the page holding ptr, or -1
+static long find_page(slab_allocator_t *slabs, const char *ptr)
+{
+    size_t low = 0, high = slabs->page_map_count;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (slabs->page_map[mid].base + slabs->page_size <= ptr)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if (low < slabs->page_map_count && slabs->page_map[low].base <= ptr)
+    {
+        return (long)low;
+    }
+    return -1;
+}
+
+// Makes room in the page map for one more page
+static int reserve_page_map(slab_allocator_t *slabs)
+{
+    if (slabs->page_map_count < slabs->page_map_capacity)
+    {
+        return 1;
+    }
+
+    size_t capacity = slabs->page_map_capacity ? slabs->page_map_capacity * 2 : 16;
+    slab_page_t *map = realloc(slabs->page_map, capacity * sizeof(slab_page_t));
+    if (!map)
+    {
+        return 0;
+    }
+    slabs->page_map = map;
+    slabs->page_map_capacity = capacity;
+    return 1;
+}
+
+// Records a page's class, keeping the map sorted by address
+static void map_page(slab_allocator_t *slabs, char *page, int id)
+{
+    size_t pos = slabs->page_map_count;
+    while (pos > 0 && slabs->page_map[pos - 1].base > page)
+    {
+        pos--;
+    }
+
+    memmove(&slabs->page_map[pos + 1], &slabs->page_map[pos],
+            (slabs->page_map_count - pos) * sizeof(slab_page_t));
+    slabs->page_map[pos] = (slab_page_t){page, id};
+    slabs->page_map_count++;
+}
+
+// Hands a page to a class; its chunks are carved lazily so untouched parts of
+// the page are never faulted in
+static void assign_page(slab_allocator_t *slabs, int id, char *page)
+{
+    slab_class_t *class = &slabs->classes[id];
+    size_t chunks = slabs->page_size / class->chunk_size;
+    class->carve_next = page;
+    class->carve_left = chunks;
+    class->total_chunks += chunks;
+    class->pages++;
+}
+
+// Assigns a new page to a class, from the preallocated region if possible
+static int grow_class(slab_allocator_t *slabs, int id)
+{
+    char *page;
+
+    if (!reserve_page_map(slabs))
+    {
+        return 0;
+    }
+
+    if (slabs->prealloc_next < slabs->prealloc_pages)
+    {
+        // Region pages count against the limit as they are handed to a class
+        if (!reserve_memory(slabs, slabs->page_size))
+        {
+            return 0;
+        }
+        page = slabs->prealloc_base + slabs->prealloc_next * slabs->page_size;
+        slabs->prealloc_next++;
+    }
+    else
+    {
+        if (slabs->prealloc_base || !reserve_memory(slabs, slabs->page_size))
+        {
+            return 0;
+        }
+
+        if (slabs->page_count == slabs->page_capacity)
+        {
+            size_t capacity = slabs->page_capacity ? slabs->page_capacity * 2 : 16;
+            void **pages = realloc(slabs->pages, capacity * sizeof(void *));
+            if (!pages)
+            {
+                slabs->memory_allocated -= slabs->page_size;
+                return 0;
+            }
+            slabs->pages = pages;
+            slabs->page_capacity = capacity;
+        }
+
+        page = malloc(slabs->page_size);
+        if (!page)
+        {
+            slabs->memory_allocated -= slabs->page_size;
+            return 0;
+        }
+        slabs->pages[slabs->page_count++] = page;
+    }
+
+    map_page(slabs, page, id);
+    assign_page(slabs, id, page);
+    return 1;
+}
+
+// Allocates a chunk from the matching class, or from malloc for oversized requests
+void *slab_alloc(slab_allocator_t *slabs, size_t size)
+{
+    if (!slabs || size == 0)
+    {
+        return NULL;
+    }
+
+    int id = slab_class_for(slabs, size);
+    if (id < 0)
+    {
+        size_t bytes = align_up(size);
+        if (!reserve_memory(slabs, bytes))
+        {
+            return NULL;
+        }
+        void *ptr = malloc(bytes);
+        if (!ptr)
+        {
+            slabs->memory_allocated -= bytes;
+            return NULL;
+        }
+        slabs->large_count++;
+        slabs->large_bytes += bytes;
+        return ptr;
+    }
+
+    slab_class_t *class = &slabs->classes[id];
+    void *chunk = class->free_list;
+    if (chunk)
+    {
+        class->free_list = *(void **)chunk;
+    }
+    else
+    {
+        if (class->carve_left == 0 && !grow_class(slabs, id))
+        {
+            return NULL;
+        }
+        chunk = class->carve_next;
+        class->carve_next += class->chunk_size;
+        class->carve_left--;
+    }
+
+    class->used_chunks++;
+    return chunk;
+}
+
+// Pushes a chunk back onto its class's free list
+void slab_free(slab_allocator_t *slabs, void *ptr, size_t size)
+{
+    if (!slabs || !ptr)
+    {
+        return;
+    }
+
+    int id = slab_class_for(slabs, size);
+    if (id < 0)
+    {
+        size_t bytes = align_up(size);
+        free(ptr);
+        slabs->large_count--;
+        slabs->large_bytes -= bytes;
+        slabs->memory_allocated -= bytes;
+        return;
+    }
+
+    slab_class_t *class = &slabs->classes[id];
+    *(void **)ptr = class->free_list;
+    class->free_list = ptr;
+    class->used_chunks--;
+}
+
+// Marks the chunks of a page that are not handed out: those on the class's
+// free list and those of its newest page not yet carved
+static void mark_free_chunks(slab_allocator_t *slabs, slab_class_t *class, char *page, unsigned char *is_free)
+{
+    for (char *chunk = class->free_list; chunk; chunk = *(char **)chunk)
+    {
+        if (chunk >= page && chunk < page + slabs->page_size)
+        {
+            is_free[(size_t)(chunk - page) / class->chunk_size] = 1;
+        }
+    }
+
+    if (class->carve_left > 0 && class->carve_next >= page && class->carve_next < page + slabs->page_size)
+    {
+        size_t first = (size_t)(class->carve_next - page) / class->chunk_size;
+        memset(is_free + first, 1, class->carve_left);
+    }
+}
+
+// Scores every page by its chunks in use and picks the least used one outside
+// the requesting class. The scan walks the free lists, but it only runs when
+// the memory limit has left a class without a chunk to hand out.
+void *slab_pick_donor_page(slab_allocator_t *slabs, size_t size)
+{
+    int target = slab_class_for(slabs, size);
+    if (target < 0 || slabs->page_map_count == 0)
+    {
+        return NULL;
+    }
+
+    size_t *free_counts = calloc(slabs->page_map_count, sizeof(size_t));
+    if (!free_counts)
+    {
+        return NULL;
+    }
+
+    for (int id = 0; id < slabs->class_count; id++)
+    {
+        slab_class_t *class = &slabs->classes[id];
+        if (id == target || class->pages == 0)
+        {
+            continue;
+        }
+
+        for (char *chunk = class->free_list; chunk; chunk = *(char **)chunk)
+        {
+            free_counts[find_page(slabs, chunk)]++;
+        }
+        if (class->carve_left > 0)
+        {
+            free_counts[find_page(slabs, class->carve_next)] += class->carve_left;
+        }
+    }
+
+    void *best = NULL;
+    size_t best_used = SIZE_MAX;
+    for (size_t i = 0; i < slabs->page_map_count; i++)
+    {
+        slab_page_t *page = &slabs->page_map[i];
+        if (page->class_id == target)
+        {
+            continue;
+        }
+
+        size_t used = slabs->page_size / slabs->classes[page->class_id].chunk_size - free_counts[i];
+        if (used < best_used)
+        {
+            best = page->base;
+            best_used = used;
+        }
+    }
+
+    free(free_counts);
+    return best;
+}
+
+// Finds the chunks in use on a page by ruling out the free ones
+int slab_for_each_used_chunk(slab_allocator_t *slabs, void *page,
+                             void (*fn)(void *ctx, void *chunk), void *ctx)
+{
+    long index = slabs && page ? find_page(slabs, page) : -1;
+    if (index < 0 || slabs->page_map[index].base != page)
+    {
+        return 0;
+    }
+
+    slab_class_t *class = &slabs->classes[slabs->page_map[index].class_id];
+    size_t chunks = slabs->page_size / class->chunk_size;
+    unsigned char *is_free = calloc(chunks, 1);
+    if (!is_free)
+    {
+        return 0;
+    }
+
+    // fn may free chunks, so the page is judged as it was before the first call
+    mark_free_chunks(slabs, class, page, is_free);
+    for (size_t i = 0; i < chunks; i++)
+    {
+        if (!is_free[i])
+        {
+            fn(ctx, (char *)page + i * class->chunk_size);
+        }
+    }
+
+    free(is_free);
+    return 1;
+}
+
+// Takes a fully free page away from its class, dropping its chunks from that
+// class's free list, and hands it to the class serving size
+int slab_reassign(slab_allocator_t *slabs, void *page, size_t size)
+{
+    int target = slab_class_for(slabs, size);
+    long index = target >= 0 && page ? find_page(slabs, page) : -1;
+    if (index < 0 || slabs->page_map[index].base != page)
+    {
+        return 0;
+    }
+
+    slab_class_t *class = &slabs->classes[target];
+    if (class->free_list || class->carve_left > 0)
+    {
+        return 1;
+    }
+
+    int donor_id = slabs->page_map[index].class_id;
+    if (donor_id == target)
+    {
+        return 0;
+    }
+
+    slab_class_t *donor = &slabs->classes[donor_id];
+    size_t chunks = slabs->page_size / donor->chunk_size;
+    unsigned char *is_free = calloc(chunks, 1);
+    if (!is_free)
+    {
+        return 0;
+    }
+    mark_free_chunks(slabs, donor, page, is_free);
+    size_t free_chunks = 0;
+    for (size_t i = 0; i < chunks; i++)
+    {
+        free_chunks += is_free[i];
+    }
+    free(is_free);
+    if (free_chunks < chunks)
+    {
+        return 0;
+    }
+
+    // Unlink the page's chunks, keeping the rest of the free list in order
+    char *start = page;
+    void **link = &donor->free_list;
+    while (*link)
+    {
+        char *chunk = *link;
+        if (chunk >= start && chunk < start + slabs->page_size)
+        {
+            *link = *(void **)chunk;
+        }
+        else
+        {
+            link = (void **)chunk;
+        }
+    }
+    if (donor->carve_left > 0 && donor->carve_next >= start && donor->carve_next < start + slabs->page_size)
+    {
+        donor->carve_next = NULL;
+        donor->carve_left = 0;
+    }
+    donor->total_chunks -= chunks;
+    donor->pages--;
+
+    slabs->page_map[index].class_id = target;
+    assign_page(slabs, target, page);
+    return 1;
+}
+
+// Prints occupancy for every class that owns at least one page
+void slab_print_stats(slab_allocator_t *slabs)
+{
+    if (!slabs)
+    {
+        return;
+    }
+
+    printf("Slab memory: %zu bytes allocated", slabs->memory_allocated);
+    if (slabs->memory_limit)
+    {
+        printf(" of %zu", slabs->memory_limit);
+    }
+    printf("\n");
+
+    for (int i = 0; i < slabs->class_count; i++)
+    {
+        slab_class_t *class = &slabs->classes[i];
+        if (class->pages == 0)
+        {
+            continue;
+        }
+
+        printf("Class %2d: chunk %7zu B, pages %4zu, chunks %8zu used / %8zu total (%.1f%%)\n",
+               i, class->chunk_size, class->pages, class->used_chunks, class->total_chunks,
+               100.0 * (double)class->used_chunks / (double)class->total_chunks);
+    }
+
+    if (slabs->large_count)
+    {
+        printf("Large: %zu allocations, %zu bytes\n", slabs->large_count, slabs->large_bytes);
+    }
+}
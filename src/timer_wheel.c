@@ -0,0 +1,195 @@
+#include "timer_wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static inline void list_init(timer_link_t *head)
+{
+    head->prev = head;
+    head->next = head;
+}
+
+static inline int list_empty(timer_link_t *head)
+{
+    return head->next == head;
+}
+
+// Appends a link at the tail of a sentinel list
+static inline void list_append(timer_link_t *head, timer_link_t *link)
+{
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+static inline void list_unlink(timer_link_t *link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->prev = NULL;
+    link->next = NULL;
+}
+
+// Files a timer relative to base, the last processed tick. The level is the
+// highest 6-bit group in which the deadline differs from base, so the slot
+// is reached exactly when the wheel's position catches up with that group.
+// Deadlines beyond the top level wait in the top level's last slot and are
+// filed again when it comes round.
+static void place(timer_wheel_t *wheel, timer_link_t *link, uint64_t base)
+{
+    if (link->deadline <= base)
+    {
+        list_append(&wheel->due, link);
+        return;
+    }
+
+    uint64_t deadline = link->deadline;
+    uint64_t span = (uint64_t)1 << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS);
+    if (deadline - base >= span)
+    {
+        deadline = base + span - 1;
+    }
+
+    int level = TIMER_WHEEL_LEVELS - 1;
+    while (level > 0 && (deadline >> (level * TIMER_WHEEL_SLOT_BITS)) ==
+                            (base >> (level * TIMER_WHEEL_SLOT_BITS)))
+    {
+        level--;
+    }
+
+    size_t slot = (size_t)(deadline >> (level * TIMER_WHEEL_SLOT_BITS)) & SLOT_MASK;
+    list_append(&wheel->slots[level][slot], link);
+    wheel->occupied[level] |= 1ULL << slot;
+    wheel->scheduled++;
+}
+
+// First tick after the wheel's position at which an occupied slot comes
+// round. Below the top level every timer sits ahead of the level's position
+// in the current rotation; the top level's may wait for the next rotation.
+static uint64_t next_event(timer_wheel_t *wheel)
+{
+    uint64_t next = UINT64_MAX;
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        uint64_t occupied = wheel->occupied[level];
+        if (!occupied)
+        {
+            continue;
+        }
+
+        int shift = level * TIMER_WHEEL_SLOT_BITS;
+        uint64_t group = wheel->now >> shift;
+        int position = (int)(group & SLOT_MASK);
+        uint64_t rotation = group - (uint64_t)position;
+
+        uint64_t ahead = position == SLOT_MASK ? 0 : occupied & (~0ULL << (position + 1));
+        uint64_t tick = ahead ? (rotation + (uint64_t)__builtin_ctzll(ahead)) << shift
+                              : (rotation + TIMER_WHEEL_SLOTS + (uint64_t)__builtin_ctzll(occupied)) << shift;
+        if (tick < next)
+        {
+            next = tick;
+        }
+    }
+
+    return next;
+}
+
+// Moves every timer in a slot, refiling it relative to base
+static size_t drain_slot(timer_wheel_t *wheel, timer_link_t *slot, uint64_t base)
+{
+    size_t moved = 0;
+
+    while (!list_empty(slot))
+    {
+        timer_link_t *link = slot->next;
+        list_unlink(link);
+        wheel->scheduled--;
+        place(wheel, link, base);
+        moved++;
+    }
+
+    return moved;
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now)
+{
+    wheel->now = now;
+    wheel->scheduled = 0;
+    list_init(&wheel->due);
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        wheel->occupied[level] = 0;
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+        {
+            list_init(&wheel->slots[level][slot]);
+        }
+    }
+}
+
+void timer_wheel_schedule(timer_wheel_t *wheel, timer_link_t *link, uint64_t deadline)
+{
+    timer_wheel_cancel(wheel, link);
+    link->deadline = deadline;
+    place(wheel, link, wheel->now);
+}
+
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_link_t *link)
+{
+    if (!link->next)
+    {
+        return;
+    }
+
+    // Timers on the due list are no longer counted as scheduled
+    if (link->deadline > wheel->now)
+    {
+        wheel->scheduled--;
+    }
+    list_unlink(link);
+}
+
+size_t timer_wheel_advance(timer_wheel_t *wheel, uint64_t now, size_t budget)
+{
+    size_t moved = 0;
+
+    while (wheel->now < now && moved < budget)
+    {
+        uint64_t next = wheel->scheduled ? next_event(wheel) : UINT64_MAX;
+        if (next > now)
+        {
+            wheel->now = now;
+            break;
+        }
+
+        // Drain every level whose slot boundary falls on this tick, highest
+        // first, so cascaded timers land in the slots below before those are
+        // drained in turn. A slot's bit is cleared as it is emptied, which
+        // also drops bits left by cancelled timers.
+        for (int level = TIMER_WHEEL_LEVELS - 1; level >= 0; level--)
+        {
+            int shift = level * TIMER_WHEEL_SLOT_BITS;
+            if ((next & ((1ULL << shift) - 1)) != 0)
+            {
+                continue;
+            }
+
+            size_t slot = (size_t)(next >> shift) & SLOT_MASK;
+            if (wheel->occupied[level] & (1ULL << slot))
+            {
+                wheel->occupied[level] &= ~(1ULL << slot);
+                moved += drain_slot(wheel, &wheel->slots[level][slot], next);
+            }
+        }
+
+        wheel->now = next;
+    }
+
+    return moved;
+}
+
+timer_link_t *timer_wheel_first_due(timer_wheel_t *wheel)
+{
+    return list_empty(&wheel->due) ? NULL : wheel->due.next;
+}
@@ -0,0 +1,20 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include "lru_cache.h"
+
+// Creates a cache under the given policy whose expirations follow a fake
+// clock, set well past zero so tests can move it either way
+static inline LRUCache *create_with_clock(int capacity, lru_policy_t policy, lru_clock_t *clock)
+{
+    lru_clock_init(clock, LRU_CLOCK_FAKE);
+    lru_clock_set(clock, 1000000);
+
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, capacity);
+    config.policy = policy;
+    config.clock = clock;
+    return lru_cache_create_with_config(&config);
+}
+
+#endif // TEST_HELPERS_H
@@ -29,6 +29,12 @@ void test_key_to_index_behavior();
 void test_resize_cache_up();
 void test_resize_cache_down();
 void test_resize_cache_same_size();
+void test_custom_hash_function();
+void test_random_hash_seed();
+void test_value_update_in_place();
+void test_mget_and_mset();
+void test_mget_expired_duplicates();
+void test_binary_keys_and_values();
 
 // Main function to execute all tests
 void run_test_lru_cache_basics()
@@ -58,6 +64,12 @@ void run_test_lru_cache_basics()
     test_resize_cache_up();
     test_resize_cache_down();
     test_resize_cache_same_size();
+    test_custom_hash_function();
+    test_random_hash_seed();
+    test_value_update_in_place();
+    test_mget_and_mset();
+    test_mget_expired_duplicates();
+    test_binary_keys_and_values();
 
     printf("Basic tests passed!\n");
 }
@@ -462,3 +474,220 @@ void test_resize_cache_same_size()
 
     lru_cache_free(cache);
 }
+
+// Test: Cache created with a caller-selected hash function
+void test_custom_hash_function()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 3);
+    config.hash_fn = djb2_hash_seeded;
+    config.hash_seed = 42;
+
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+    assert(cache->hash_fn == djb2_hash_seeded);
+
+    lru_cache_set(cache, "key1", "value1");
+    lru_cache_set(cache, "key2", "value2");
+    assert(strcmp(lru_cache_get(cache, "key1"), "value1") == 0);
+    assert(strcmp(lru_cache_get(cache, "key2"), "value2") == 0);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Custom Hash Function\n");
+}
+
+// Test: A randomly seeded cache still finds its keys
+void test_random_hash_seed()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 100);
+    config.random_seed = 1;
+
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+
+    char key[16];
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, key);
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        assert(strcmp(lru_cache_get(cache, key), key) == 0);
+    }
+
+    // Different seeds must give different hashes for the same key
+    assert(wyhash64("key", 3, 1) != wyhash64("key", 3, 2));
+
+    lru_cache_free(cache);
+    printf("Test Passed: Random Hash Seed\n");
+}
+
+// Test: Updates reuse the entry block when the value fits and grow it when not
+void test_value_update_in_place()
+{
+    LRUCache *cache = lru_cache_create(2);
+    assert(cache);
+
+    lru_cache_set(cache, "key1", "a fairly long value");
+    lru_cache_set(cache, "key2", "value2");
+    char *before = lru_cache_get(cache, "key1");
+
+    lru_cache_set(cache, "key1", "short");
+    char *after = lru_cache_get(cache, "key1");
+    assert(after == before);
+    assert(strcmp(after, "short") == 0);
+
+    char long_value[256];
+    memset(long_value, 'v', sizeof(long_value) - 1);
+    long_value[sizeof(long_value) - 1] = '\0';
+    lru_cache_set(cache, "key1", long_value);
+    assert(strcmp(lru_cache_get(cache, "key1"), long_value) == 0);
+
+    // The regrown entry keeps its place at the front of the recency list
+    lru_cache_set(cache, "key3", "value3"); // Evicts "key2"
+    assert(lru_cache_get(cache, "key2") == NULL);
+    assert(strcmp(lru_cache_get(cache, "key1"), long_value) == 0);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Value Update In Place\n");
+}
+
+// Test: Batched gets and sets match the single-key API, across chunk boundaries
+void test_mget_and_mset()
+{
+    int count = 3 * LRU_BATCH_CHUNK + 5;
+    LRUCache *cache = lru_cache_create(count);
+    assert(cache);
+
+    char key_buf[256][24], value_buf[256][24];
+    char *keys[256], *values[256], *out[256];
+    for (int i = 0; i < 2 * count; i++)
+    {
+        snprintf(key_buf[i], sizeof(key_buf[i]), "key%d", i);
+        snprintf(value_buf[i], sizeof(value_buf[i]), "value%d", i);
+        keys[i] = key_buf[i];
+        values[i] = value_buf[i];
+    }
+
+    lru_cache_mset(cache, keys, values, count);
+    assert(cache->size == count);
+
+    // Present and absent keys interleaved, with a NULL key and a duplicate
+    char *mixed[256];
+    for (int i = 0; i < count; i++)
+    {
+        mixed[i] = keys[i % 2 ? i : count + i];
+    }
+    mixed[7] = NULL;
+    mixed[9] = keys[1];
+
+    lru_cache_reset_stats(cache);
+    size_t hits = lru_cache_mget(cache, mixed, count, out);
+    size_t expected = 0;
+    for (int i = 0; i < count; i++)
+    {
+        char *single = mixed[i] ? lru_cache_get(cache, mixed[i]) : NULL;
+        assert((out[i] == NULL) == (single == NULL));
+        assert(!out[i] || strcmp(out[i], single) == 0);
+        expected += out[i] != NULL;
+    }
+    assert(hits == expected);
+    lru_cache_stats_t stats;
+    lru_cache_get_stats(cache, &stats);
+    assert(stats.hits == 2 * hits);
+    assert(stats.misses == 2 * (count - hits) - 1); // The batch counts its NULL key as a miss
+
+    // The batch's hits became most recently used, so inserting evicts the rest first
+    lru_cache_mget(cache, keys, 4, out);
+    lru_cache_mset(cache, keys + count, values + count, count - 4);
+    for (int i = 0; i < 4; i++)
+    {
+        assert(lru_cache_get(cache, keys[i]));
+    }
+    assert(lru_cache_get(cache, keys[5]) == NULL);
+
+    // Pairs with a NULL value are skipped and the rest of the batch is stored
+    char *batch_keys[] = {keys[0], "fresh", "other"};
+    char *batch_values[] = {NULL, NULL, "set"};
+    lru_cache_mset(cache, batch_keys, batch_values, 3);
+    assert(strcmp(lru_cache_get(cache, keys[0]), values[0]) == 0);
+    assert(lru_cache_get(cache, "fresh") == NULL);
+    assert(strcmp(lru_cache_get(cache, "other"), "set") == 0);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Mget and Mset\n");
+}
+
+// Test: A key repeated in a batch sees one expiry decision
+void test_mget_expired_duplicates()
+{
+    lru_clock_t clock;
+    lru_clock_init(&clock, LRU_CLOCK_FAKE);
+
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 4);
+    config.clock = &clock;
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+
+    lru_cache_set_with_expiration(cache, "short", "1", 10);
+    lru_cache_set(cache, "long", "2");
+    lru_clock_advance(&clock, 10);
+
+    char *keys[] = {"short", "long", "short", "long"};
+    char *out[4];
+    assert(lru_cache_mget(cache, keys, 4, out) == 2);
+    assert(!out[0] && !out[2]);
+    assert(strcmp(out[1], "2") == 0 && out[1] == out[3]);
+    assert(cache->size == 1);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Mget Expired Duplicates\n");
+}
+
+// Test: Keys and values with embedded NULs round-trip by length
+void test_binary_keys_and_values()
+{
+    LRUCache *cache = lru_cache_create(8);
+    assert(cache);
+
+    char key_a[] = {'k', '\0', 'a'};
+    char key_b[] = {'k', '\0', 'b'};
+    char blob[] = {0x08, 0x00, 0x12, 0x00, 0x00, 0x1a};
+    size_t len = 0;
+
+    lru_cache_set_bin(cache, key_a, sizeof(key_a), blob, sizeof(blob), DEFAULT_EXPIRATION_MS);
+    lru_cache_set_bin(cache, key_b, sizeof(key_b), "b", 1, DEFAULT_EXPIRATION_MS);
+    lru_cache_set(cache, "k", "string");
+    assert(cache->size == 3);
+
+    // Keys sharing a prefix up to the NUL stay distinct
+    char *value = lru_cache_get_bin(cache, key_a, sizeof(key_a), &len);
+    assert(value && len == sizeof(blob) && memcmp(value, blob, len) == 0);
+    value = lru_cache_get_bin(cache, key_b, sizeof(key_b), &len);
+    assert(value && len == 1 && value[0] == 'b');
+    assert(strcmp(lru_cache_get(cache, "k"), "string") == 0);
+    assert(lru_cache_get_bin(cache, key_a, 2, &len) == NULL);
+
+    // A shorter blob overwrites in place; an empty value is still a hit
+    char *before = lru_cache_get_bin(cache, key_a, sizeof(key_a), NULL);
+    lru_cache_set_bin(cache, key_a, sizeof(key_a), blob + 1, 3, DEFAULT_EXPIRATION_MS);
+    value = lru_cache_get_bin(cache, key_a, sizeof(key_a), &len);
+    assert(value == before && len == 3 && memcmp(value, blob + 1, 3) == 0);
+
+    lru_cache_set_bin(cache, key_b, sizeof(key_b), "", 0, DEFAULT_EXPIRATION_MS);
+    value = lru_cache_get_bin(cache, key_b, sizeof(key_b), &len);
+    assert(value && len == 0 && value[0] == '\0');
+
+    // Lengths that do not fit an entry are rejected before anything is read
+    lru_cache_set_bin(cache, key_a, sizeof(key_a), blob, KV_PAIR_MAX_LEN + 1, DEFAULT_EXPIRATION_MS);
+    lru_cache_set_bin(cache, key_b, KV_PAIR_MAX_LEN + 1, "c", 1, DEFAULT_EXPIRATION_MS);
+    value = lru_cache_get_bin(cache, key_a, sizeof(key_a), &len);
+    assert(value && len == 3 && cache->size == 3);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Binary Keys and Values\n");
+}
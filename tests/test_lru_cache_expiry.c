@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "lru_cache.h"
+#include "timer_wheel.h"
+#include "test_helpers.h"
+
+#define WHEEL_TIMERS 5000
+
+// Test: Timers fall due exactly at their deadline across every wheel level
+void test_timer_wheel_deadlines()
+{
+    timer_wheel_t *wheel = malloc(sizeof(timer_wheel_t));
+    timer_link_t *timers = calloc(WHEEL_TIMERS, sizeof(timer_link_t));
+    assert(wheel && timers);
+
+    uint64_t start = 1000;
+    timer_wheel_init(wheel, start);
+
+    // Spread deadlines from one tick to beyond a level-2 rotation
+    unsigned int state = 12345;
+    for (int i = 0; i < WHEEL_TIMERS; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        uint64_t delay = 1 + (state >> 8) % (i % 2 ? 300000 : 200);
+        timer_wheel_schedule(wheel, &timers[i], start + delay);
+    }
+
+    // Cancelled timers never fall due
+    for (int i = 0; i < WHEEL_TIMERS; i += 7)
+    {
+        timer_wheel_cancel(wheel, &timers[i]);
+        assert(timers[i].next == NULL);
+    }
+
+    // Advance in uneven steps with a small budget, draining the due list
+    // after each call and checking every timer against the wheel's position
+    int fired = 0;
+    uint64_t now = start;
+    while (now < start + 300001)
+    {
+        now += 1 + now % 977;
+        do
+        {
+            uint64_t before = wheel->now;
+            timer_wheel_advance(wheel, now, 32);
+
+            timer_link_t *due;
+            while ((due = timer_wheel_first_due(wheel)))
+            {
+                assert(due->deadline > before && due->deadline <= wheel->now);
+                timer_wheel_cancel(wheel, due);
+                fired++;
+            }
+        } while (wheel->now < now);
+    }
+
+    assert(fired == WHEEL_TIMERS - (WHEEL_TIMERS + 6) / 7);
+    assert(wheel->scheduled == 0);
+
+    free(timers);
+    free(wheel);
+    printf("Test Passed: Timer Wheel Deadlines\n");
+}
+
+// Test: Rescheduling moves a timer and the wheel stops between ticks at its budget
+void test_timer_wheel_reschedule_and_budget()
+{
+    timer_wheel_t *wheel = malloc(sizeof(timer_wheel_t));
+    timer_link_t timers[100] = {{0}}; // Timers start unlinked
+    assert(wheel);
+
+    timer_wheel_init(wheel, 0);
+    for (int i = 0; i < 100; i++)
+    {
+        timer_wheel_schedule(wheel, &timers[i], 10 + i / 10);
+    }
+
+    // A rescheduled timer leaves its old slot
+    timer_wheel_schedule(wheel, &timers[0], 5000);
+
+    // Nine timers fall due at tick 10 and ten at tick 11; a budget of 15
+    // stops the wheel after tick 11
+    assert(timer_wheel_advance(wheel, 100, 15) == 19);
+    assert(wheel->now == 11);
+
+    timer_wheel_advance(wheel, 100, (size_t)-1);
+    assert(wheel->now == 100);
+
+    int due_count = 0;
+    timer_link_t *due;
+    while ((due = timer_wheel_first_due(wheel)))
+    {
+        assert(due != &timers[0]);
+        timer_wheel_cancel(wheel, due);
+        due_count++;
+    }
+    assert(due_count == 99);
+    assert(wheel->scheduled == 1);
+
+    timer_wheel_advance(wheel, 5000, (size_t)-1);
+    assert(timer_wheel_first_due(wheel) == &timers[0]);
+
+    free(wheel);
+    printf("Test Passed: Timer Wheel Reschedule and Budget\n");
+}
+
+// Test: Millisecond TTLs expire exactly when the clock reaches them
+void test_millisecond_ttl()
+{
+    lru_clock_t clock;
+    LRUCache *cache = create_with_clock(10, LRU_POLICY_LRU, &clock);
+    assert(cache);
+
+    lru_cache_set_with_expiration(cache, "short", "1", 1500);
+    lru_cache_set(cache, "long", "2");
+
+    lru_clock_advance(&clock, 1499);
+    assert(lru_cache_get(cache, "short"));
+    lru_clock_advance(&clock, 1);
+    assert(lru_cache_get(cache, "short") == NULL);
+    assert(cache->size == 1);
+
+    lru_clock_advance(&clock, DEFAULT_EXPIRATION_MS - 1501);
+    assert(lru_cache_get(cache, "long"));
+    lru_clock_advance(&clock, 1);
+    assert(lru_cache_get(cache, "long") == NULL);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Millisecond TTL\n");
+}
+
+// Test: lru_cache_expire removes expired entries within its budget and leaves live ones
+void test_cache_expire_budget()
+{
+    lru_clock_t clock;
+    LRUCache *cache = create_with_clock(100, LRU_POLICY_LRU, &clock);
+    assert(cache);
+
+    char key[16];
+    for (int i = 0; i < 50; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set_with_expiration(cache, key, "value", i % 2 ? 60000 : 1000 + i);
+    }
+
+    lru_clock_advance(&clock, 2000);
+    assert(lru_cache_expire(cache, 10) == 10);
+    assert(cache->size == 40);
+    assert(lru_cache_expire(cache, 100) == 15);
+    assert(cache->size == 25);
+    assert(lru_cache_expire(cache, 100) == 0);
+
+    for (int i = 0; i < 50; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        assert((lru_cache_get(cache, key) != NULL) == (i % 2 == 1));
+    }
+
+    // A long idle stretch costs one step per occupied slot, not per millisecond
+    lru_clock_advance(&clock, 3600 * 1000);
+    assert(lru_cache_expire(cache, 100) == 25);
+    assert(cache->size == 0);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Cache Expire Budget\n");
+}
+
+// Test: A full cache evicts an expired entry before its least recently used one
+void test_eviction_prefers_expired()
+{
+    lru_clock_t clock;
+    LRUCache *cache = create_with_clock(3, LRU_POLICY_LRU, &clock);
+    assert(cache);
+
+    lru_cache_set(cache, "a", "1");
+    lru_cache_set(cache, "b", "2");
+    lru_cache_set_with_expiration(cache, "c", "3", 100); // Most recently used, but expires first
+    lru_clock_advance(&clock, 100);
+
+    lru_cache_set(cache, "d", "4");
+    assert(cache->size == 3);
+    assert(lru_cache_get(cache, "a"));
+    assert(lru_cache_get(cache, "b"));
+    assert(lru_cache_get(cache, "d"));
+    assert(lru_cache_get(cache, "c") == NULL);
+
+    // Updating an entry gives it a fresh deadline
+    lru_cache_set_with_expiration(cache, "a", "1", 50);
+    lru_clock_advance(&clock, 50);
+    lru_cache_set(cache, "a", "10");
+    lru_cache_set(cache, "e", "5");
+    assert(lru_cache_get(cache, "a"));
+    assert(lru_cache_get(cache, "b") == NULL);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Eviction Prefers Expired Entries\n");
+}
+
+// Test: A cached clock refreshes every refresh_ops reads or from its ticker thread
+void test_cached_clock()
+{
+    lru_clock_t clock;
+    lru_clock_init(&clock, LRU_CLOCK_CACHED);
+    clock.refresh_ops = 4;
+    clock.now_ms = 0;
+
+    assert(lru_clock_now_ms(&clock) == 0);
+    assert(lru_clock_now_ms(&clock) == 0);
+    assert(lru_clock_now_ms(&clock) == 0);
+    assert(lru_clock_now_ms(&clock) > 0); // The fourth read refreshes
+    lru_clock_destroy(&clock);
+
+    lru_clock_init(&clock, LRU_CLOCK_CACHED);
+    clock.now_ms = 0;
+    assert(lru_clock_start_ticker(&clock, 1));
+    struct timespec pause = {0, 20 * 1000000};
+    nanosleep(&pause, NULL);
+    assert(lru_clock_now_ms(&clock) > 0);
+    lru_clock_destroy(&clock);
+
+    lru_clock_init(&clock, LRU_CLOCK_FAKE);
+    assert(!lru_clock_start_ticker(&clock, 1));
+    lru_clock_set(&clock, 5);
+    lru_clock_advance(&clock, 7);
+    assert(lru_clock_now_ms(&clock) == 12);
+
+    printf("Test Passed: Cached Clock\n");
+}
+
+void run_test_lru_cache_expiry()
+{
+    printf("Running timer wheel and expiry tests...\n");
+    test_timer_wheel_deadlines();
+    test_timer_wheel_reschedule_and_budget();
+    test_millisecond_ttl();
+    test_cache_expire_budget();
+    test_eviction_prefers_expired();
+    test_cached_clock();
+    printf("Expiry tests passed!\n");
+}
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "lru_cache.h"
+#include "sharded_lru.h"
+
+#define HANDLE_THREADS 4
+#define HANDLE_OPERATIONS 50000
+
+// Test: Acquire pins hits, misses return NULL and both count in the stats
+void test_acquire_and_release()
+{
+    LRUCache *cache = lru_cache_create(4);
+    lru_cache_set(cache, "key", "value");
+
+    lru_handle_t *handle = lru_cache_acquire(cache, "key");
+    assert(handle);
+    assert(strcmp(lru_handle_value(handle), "value") == 0);
+    assert(lru_handle_value_len(handle) == 5);
+    assert(strcmp(lru_handle_key(handle), "key") == 0);
+    assert(lru_cache_acquire(cache, "missing") == NULL);
+    lru_cache_stats_t stats;
+    lru_cache_get_stats(cache, &stats);
+    assert(stats.hits == 1 && stats.misses == 1);
+
+    // Releasing a resident entry leaves it cached
+    lru_cache_release(cache, handle);
+    assert(strcmp(lru_cache_get(cache, "key"), "value") == 0);
+    assert(cache->pinned.head == NULL);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Acquire and Release\n");
+}
+
+// Test: An evicted entry stays readable until its last handle is released
+void test_pinned_entry_outlives_eviction()
+{
+    LRUCache *cache = lru_cache_create(2);
+    lru_cache_set(cache, "a", "first");
+
+    lru_handle_t *first = lru_cache_acquire(cache, "a");
+    lru_handle_t *second = lru_cache_acquire(cache, "a");
+    lru_cache_set(cache, "b", "2");
+    lru_cache_set(cache, "c", "3");
+
+    // The victim's block must not be reused for the incoming entry
+    assert(lru_cache_get(cache, "a") == NULL);
+    assert(cache->pinned.head == first);
+    assert(strcmp(lru_handle_value(first), "first") == 0);
+
+    lru_cache_release(cache, first);
+    assert(cache->pinned.head == second);
+    assert(strcmp(lru_handle_value(second), "first") == 0);
+    lru_cache_release(cache, second);
+    assert(cache->pinned.head == NULL);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Pinned Entry Outlives Eviction\n");
+}
+
+// Test: Updating a pinned entry copies it, so handles keep the old value
+void test_update_copies_pinned_entry()
+{
+    LRUCache *cache = lru_cache_create(4);
+    lru_cache_set(cache, "key", "old-value");
+
+    lru_handle_t *handle = lru_cache_acquire(cache, "key");
+    lru_cache_set(cache, "key", "new");
+    assert(strcmp(lru_handle_value(handle), "old-value") == 0);
+    assert(strcmp(lru_cache_get(cache, "key"), "new") == 0);
+    assert(cache->size == 1);
+
+    // Without a handle the shorter value is written in place again
+    lru_cache_release(cache, handle);
+    assert(cache->pinned.head == NULL);
+    char *value = lru_cache_get(cache, "key");
+    lru_cache_set(cache, "key", "v2");
+    assert(lru_cache_get(cache, "key") == value);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Update Copies Pinned Entry\n");
+}
+
+// Test: Expired and still pinned entries are freed along with the cache
+void test_pinned_entry_expires()
+{
+    lru_clock_t clock;
+    lru_clock_init(&clock, LRU_CLOCK_FAKE);
+    lru_clock_set(&clock, 1000);
+
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 4);
+    config.clock = &clock;
+    LRUCache *cache = lru_cache_create_with_config(&config);
+
+    lru_cache_set_with_expiration(cache, "short", "lived", 10);
+    lru_cache_set(cache, "long", "lived");
+    lru_handle_t *expiring = lru_cache_acquire(cache, "short");
+    lru_handle_t *resident = lru_cache_acquire(cache, "long");
+
+    lru_clock_advance(&clock, 10);
+    assert(lru_cache_expire(cache, 8) == 1);
+    assert(cache->size == 1);
+    assert(strcmp(lru_handle_value(expiring), "lived") == 0);
+
+    // Both handles are left outstanding; freeing the cache reclaims them
+    (void)resident;
+    lru_cache_free(cache);
+    printf("Test Passed: Pinned Entry Expires\n");
+}
+
+typedef struct handle_worker
+{
+    ShardedLRUCache *cache;
+    int id;
+    long reads;
+} handle_worker_t;
+
+// Churns a small keyspace while checking that every pinned value still
+// matches its key after the shard lock has been dropped
+static void *handle_worker(void *arg)
+{
+    handle_worker_t *worker = arg;
+    char key[32], value[64];
+
+    for (int i = 0; i < HANDLE_OPERATIONS; i++)
+    {
+        int k = (i * 7 + worker->id * 13) % 256;
+        snprintf(key, sizeof(key), "key%d", k);
+
+        if (i % 3 == 0)
+        {
+            // Alternate value lengths so updates both fit and outgrow the entry
+            snprintf(value, sizeof(value), "%s:%s", key, i % 2 ? "short" : "a-rather-longer-value");
+            sharded_lru_set(worker->cache, key, value);
+            continue;
+        }
+
+        lru_handle_t *handle = sharded_lru_acquire(worker->cache, key);
+        if (handle)
+        {
+            char *bytes = lru_handle_value(handle);
+            assert(strncmp(bytes, key, strlen(key)) == 0 && bytes[strlen(key)] == ':');
+            assert(strlen(bytes) == lru_handle_value_len(handle));
+            worker->reads++;
+            sharded_lru_release(worker->cache, handle);
+        }
+    }
+
+    return NULL;
+}
+
+// Test: Handles read values in place while other threads update and evict
+void test_sharded_handles_concurrent()
+{
+    // Far fewer slots than keys, so pinned entries are evicted constantly
+    ShardedLRUCache *cache = sharded_lru_create(4, 64);
+    pthread_t threads[HANDLE_THREADS];
+    handle_worker_t workers[HANDLE_THREADS];
+
+    for (int i = 0; i < HANDLE_THREADS; i++)
+    {
+        workers[i] = (handle_worker_t){cache, i, 0};
+        pthread_create(&threads[i], NULL, handle_worker, &workers[i]);
+    }
+
+    long reads = 0;
+    for (int i = 0; i < HANDLE_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        reads += workers[i].reads;
+    }
+    assert(reads > 0);
+
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        assert(cache->shards[i].cache->pinned.head == NULL);
+    }
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Handles Concurrent\n");
+}
+
+void run_test_lru_cache_handles()
+{
+    test_acquire_and_release();
+    test_pinned_entry_outlives_eviction();
+    test_update_copies_pinned_entry();
+    test_pinned_entry_expires();
+    test_sharded_handles_concurrent();
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <assert.h>
+#include "lru_cache.h"
+#include "sharded_lru.h"
+
+// Test: Every duration lands in a bucket whose floor is at most the duration
+// and within a quarter of it
+void test_latency_buckets()
+{
+    for (uint64_t cycles = 0; cycles < 100000; cycles++)
+    {
+        size_t bucket = lru_latency_bucket(cycles);
+        assert(bucket < LRU_LATENCY_BUCKETS);
+        assert(lru_latency_bucket_floor(bucket) <= cycles);
+        assert(cycles - lru_latency_bucket_floor(bucket) <= cycles / 4);
+        assert(lru_latency_bucket(lru_latency_bucket_floor(bucket)) == bucket);
+    }
+
+    assert(lru_latency_bucket(UINT64_MAX) == LRU_LATENCY_BUCKETS - 1);
+    printf("Test Passed: Latency Buckets\n");
+}
+
+// Test: Percentiles read the floor of the bucket holding the ranked sample
+void test_latency_percentiles()
+{
+    lru_latency_histogram_t histogram = {0};
+    assert(lru_latency_percentile(&histogram, 0.99) == 0);
+
+    for (uint64_t cycles = 1; cycles <= 100; cycles++)
+    {
+        histogram.buckets[lru_latency_bucket(cycles)]++;
+        histogram.count++;
+        histogram.cycles += cycles;
+    }
+    histogram.buckets[lru_latency_bucket(100000)]++;
+    histogram.count++;
+
+    assert(lru_latency_percentile(&histogram, 0) == 1);
+    assert(lru_latency_percentile(&histogram, 0.5) == lru_latency_bucket_floor(lru_latency_bucket(50)));
+    assert(lru_latency_percentile(&histogram, 1.0) == lru_latency_bucket_floor(lru_latency_bucket(100000)));
+
+    lru_latency_histogram_t merged = {0};
+    lru_latency_merge(&merged, &histogram);
+    lru_latency_merge(&merged, &histogram);
+    assert(merged.count == 2 * histogram.count);
+    assert(lru_latency_percentile(&merged, 0.5) == lru_latency_percentile(&histogram, 0.5));
+    printf("Test Passed: Latency Percentiles\n");
+}
+
+// Test: With instrumentation built in, one occurrence of each phase in
+// LRU_INSTRUMENT_SAMPLE_EVERY is timed; without it nothing is reported
+void test_phase_sampling()
+{
+    int operations = 64 * LRU_INSTRUMENT_SAMPLE_EVERY;
+    LRUCache *cache = lru_cache_create(operations / 2);
+    char key[32];
+
+    for (int i = 0; i < operations; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+        lru_cache_get(cache, key);
+    }
+
+    lru_latency_histogram_t histogram;
+#ifdef LRU_CACHE_INSTRUMENT
+    assert(lru_cache_get_latency(cache, LRU_PHASE_GET, &histogram));
+    assert(histogram.count == (uint64_t)operations / LRU_INSTRUMENT_SAMPLE_EVERY);
+    assert(lru_cache_get_latency(cache, LRU_PHASE_SET, &histogram));
+    assert(histogram.count == (uint64_t)operations / LRU_INSTRUMENT_SAMPLE_EVERY);
+    assert(lru_cache_get_latency(cache, LRU_PHASE_HASH, &histogram));
+    assert(histogram.count == (uint64_t)operations * 2 / LRU_INSTRUMENT_SAMPLE_EVERY);
+    assert(lru_cache_get_latency(cache, LRU_PHASE_EVICT, &histogram));
+    assert(histogram.count == (uint64_t)operations / 2 / LRU_INSTRUMENT_SAMPLE_EVERY);
+    assert(lru_latency_percentile(&histogram, 0.99) >= lru_latency_percentile(&histogram, 0.5));
+
+    lru_cache_print_latency(cache);
+    lru_cache_reset_stats(cache);
+    assert(lru_cache_get_latency(cache, LRU_PHASE_GET, &histogram));
+    assert(histogram.count == 0);
+#else
+    assert(!lru_cache_get_latency(cache, LRU_PHASE_GET, &histogram));
+#endif
+
+    lru_cache_free(cache);
+    printf("Test Passed: Phase Sampling\n");
+}
+
+// Test: A sharded cache merges its shards' timings
+void test_sharded_latency()
+{
+    ShardedLRUCache *cache = sharded_lru_create(4, 1024);
+    char key[32];
+    char buf[16];
+
+    for (int i = 0; i < 16 * LRU_INSTRUMENT_SAMPLE_EVERY; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        sharded_lru_set(cache, key, "value");
+        sharded_lru_get(cache, key, buf, sizeof(buf));
+    }
+
+    lru_latency_histogram_t histogram;
+#ifdef LRU_CACHE_INSTRUMENT
+    assert(sharded_lru_get_latency(cache, LRU_PHASE_SET, &histogram));
+    assert(histogram.count > 0 && histogram.count <= 16);
+#else
+    assert(!sharded_lru_get_latency(cache, LRU_PHASE_SET, &histogram));
+#endif
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Latency\n");
+}
+
+void run_test_lru_cache_instrument()
+{
+    test_latency_buckets();
+    test_latency_percentiles();
+    test_phase_sampling();
+    test_sharded_latency();
+}
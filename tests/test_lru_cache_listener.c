@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "lru_cache.h"
+#include "sharded_lru.h"
+#include "test_helpers.h"
+
+#define LISTENER_THREADS 4
+#define LISTENER_OPERATIONS 20000
+
+// What a listener has been told
+typedef struct removal_log
+{
+    int batches;
+    int largest_batch;
+    int removals;
+    int reasons[LRU_REMOVAL_RESIZE + 1];
+    char first_key[32];
+    char first_value[32];
+    LRUCache *refill;   // Cache the listener writes to, if any
+    int refills_left;
+} removal_log_t;
+
+// Records each batch and copies the first key and value ever reported
+static void log_removals(void *ctx, const lru_eviction_t *evictions, size_t count)
+{
+    removal_log_t *log = ctx;
+    log->batches++;
+    if ((int)count > log->largest_batch)
+    {
+        log->largest_batch = (int)count;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (log->removals == 0)
+        {
+            snprintf(log->first_key, sizeof(log->first_key), "%s", lru_handle_key(evictions[i].entry));
+            snprintf(log->first_value, sizeof(log->first_value), "%s", lru_handle_value(evictions[i].entry));
+        }
+        log->removals++;
+        log->reasons[evictions[i].reason]++;
+
+        if (log->refill && log->refills_left > 0)
+        {
+            log->refills_left--;
+            lru_cache_set(log->refill, lru_handle_key(evictions[i].entry), "refilled");
+        }
+    }
+}
+
+// Test: Evictions arrive oldest first in full batches, the rest on a flush
+void test_listener_batches()
+{
+    LRUCache *cache = lru_cache_create(10);
+    removal_log_t log = {0};
+    lru_cache_set_eviction_listener(cache, log_removals, &log);
+
+    char key[32], value[32];
+    for (int i = 0; i < 140; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        snprintf(value, sizeof(value), "v%d", i);
+        lru_cache_set(cache, key, value);
+    }
+
+    assert(log.batches == 2 && log.removals == 2 * LRU_EVICTION_BATCH);
+    assert(log.largest_batch == LRU_EVICTION_BATCH);
+    assert(strcmp(log.first_key, "key0") == 0 && strcmp(log.first_value, "v0") == 0);
+    assert(cache->pinned.head != NULL);
+
+    lru_cache_flush_evictions(cache);
+    assert(log.batches == 3 && log.removals == 130);
+    assert(log.reasons[LRU_REMOVAL_CAPACITY] == 130);
+    assert(cache->pinned.head == NULL);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Listener Batches\n");
+}
+
+// Test: Each kind of removal carries its reason
+void test_listener_reasons()
+{
+    lru_clock_t clock;
+    LRUCache *cache = create_with_clock(4, LRU_POLICY_LRU, &clock);
+    removal_log_t log = {0};
+    lru_cache_set_eviction_listener(cache, log_removals, &log);
+
+    lru_cache_set_with_expiration(cache, "a", "1", 100);
+    lru_cache_set(cache, "b", "2");
+    lru_cache_set(cache, "c", "3");
+    assert(lru_cache_delete(cache, "b") == 1);
+    assert(lru_cache_delete(cache, "b") == 0);
+    assert(lru_cache_delete(cache, "missing") == 0);
+    assert(lru_cache_get(cache, "b") == NULL);
+    assert(log.removals == 0);
+
+    // Expiring delivers everything queued, the delete included
+    lru_clock_advance(&clock, 200);
+    assert(lru_cache_expire(cache, 10) == 1);
+    assert(log.reasons[LRU_REMOVAL_EXPLICIT] == 1 && log.reasons[LRU_REMOVAL_EXPIRED] == 1);
+    assert(strcmp(log.first_key, "b") == 0);
+
+    // A lookup or delete that finds an expired entry reports it as expired
+    lru_cache_set_with_expiration(cache, "d", "4", 100);
+    lru_cache_set_with_expiration(cache, "e", "5", 100);
+    lru_clock_advance(&clock, 200);
+    assert(lru_cache_get(cache, "d") == NULL);
+    assert(lru_cache_delete(cache, "e") == 0);
+    lru_cache_flush_evictions(cache);
+    assert(log.reasons[LRU_REMOVAL_EXPIRED] == 3);
+
+    // Shrinking evicts for the resize; a full cache evicts for capacity
+    lru_cache_set(cache, "f", "6");
+    lru_cache_set(cache, "g", "7");
+    lru_cache_set(cache, "h", "8");
+    lru_cache_resize_cache(cache, 2);
+    assert(log.reasons[LRU_REMOVAL_RESIZE] == 2);
+    lru_cache_set(cache, "i", "9");
+    lru_cache_flush_evictions(cache);
+    assert(log.reasons[LRU_REMOVAL_CAPACITY] == 1);
+    assert(log.removals == 7);
+
+    lru_cache_stats_t stats;
+    lru_cache_get_stats(cache, &stats);
+    assert(stats.expirations == 3 && stats.evictions == 3 && stats.size == 2);
+    lru_cache_free(cache);
+
+    // An update too large for the byte budget drops the old value, and is
+    // counted as an eviction like every other capacity removal
+    cache = lru_cache_create_with_memory_limit(4096);
+    removal_log_t budget_log = {0};
+    lru_cache_set_eviction_listener(cache, log_removals, &budget_log);
+    char large[4096];
+    memset(large, 'x', sizeof(large) - 1);
+    large[sizeof(large) - 1] = '\0';
+    lru_cache_set(cache, "a", "1");
+    lru_cache_set(cache, "a", large);
+    assert(lru_cache_get(cache, "a") == NULL);
+    lru_cache_flush_evictions(cache);
+
+    lru_cache_get_stats(cache, &stats);
+    assert(budget_log.reasons[LRU_REMOVAL_CAPACITY] == 1);
+    assert(stats.evictions == (uint64_t)budget_log.reasons[LRU_REMOVAL_CAPACITY]);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Listener Reasons\n");
+}
+
+// Test: The listener may write to the cache that called it, and removals
+// it causes are delivered by the same flush
+void test_listener_refills_cache()
+{
+    LRUCache *cache = lru_cache_create(8);
+    removal_log_t log = {0};
+    log.refill = cache;
+    log.refills_left = 100;
+    lru_cache_set_eviction_listener(cache, log_removals, &log);
+
+    char key[32];
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+    lru_cache_flush_evictions(cache);
+
+    // Every insert beyond the capacity, refills included, evicted one entry
+    lru_cache_stats_t stats;
+    lru_cache_get_stats(cache, &stats);
+    assert(log.refills_left == 0);
+    assert(stats.inserts + stats.updates == 300);
+    assert((uint64_t)log.removals == stats.evictions);
+    assert(stats.evictions == stats.inserts - 8);
+    assert(cache->evicted_count == 0 && cache->pinned.head == NULL);
+
+    // Removals still queued are delivered when the cache is freed
+    lru_cache_set_eviction_listener(cache, log_removals, &log);
+    lru_cache_set(cache, "x", "1");
+    lru_cache_set(cache, "y", "2");
+    int before = log.removals;
+    lru_cache_free(cache);
+    assert(log.removals == before + 2);
+    printf("Test Passed: Listener Refills Cache\n");
+}
+
+// Counts removals across threads and writes some back through the sharded
+// cache, which deadlocks if the listener runs under a shard lock
+typedef struct sharded_log
+{
+    ShardedLRUCache *cache;
+    int removals;
+    int refills_left;
+} sharded_log_t;
+
+static void count_sharded_removals(void *ctx, const lru_eviction_t *evictions, size_t count)
+{
+    sharded_log_t *log = ctx;
+    __atomic_add_fetch(&log->removals, (int)count, __ATOMIC_RELAXED);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (__atomic_sub_fetch(&log->refills_left, 1, __ATOMIC_RELAXED) >= 0)
+        {
+            sharded_lru_set(log->cache, lru_handle_key(evictions[i].entry), lru_handle_value(evictions[i].entry));
+        }
+    }
+}
+
+typedef struct
+{
+    ShardedLRUCache *cache;
+    int seed;
+} listener_worker_args_t;
+
+// Mixes sets, gets and deletes over more keys than the cache holds
+static void *listener_worker(void *arg)
+{
+    listener_worker_args_t *args = arg;
+    unsigned int state = (unsigned int)args->seed * 2654435761u + 1;
+    char key[32];
+    char buf[32];
+
+    for (int i = 0; i < LISTENER_OPERATIONS; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        snprintf(key, sizeof(key), "key%u", (state >> 8) % 4096);
+        if (i % 3 == 0)
+        {
+            sharded_lru_set(args->cache, key, "value");
+        }
+        else if (i % 17 == 0)
+        {
+            sharded_lru_delete(args->cache, key);
+        }
+        else
+        {
+            sharded_lru_get(args->cache, key, buf, sizeof(buf));
+        }
+    }
+    return NULL;
+}
+
+// Test: A sharded cache reports every removal once, outside the shard locks
+void test_sharded_listener()
+{
+    ShardedLRUCache *cache = sharded_lru_create(4, 256);
+    sharded_log_t log = {cache, 0, 1000};
+    sharded_lru_set_eviction_listener(cache, count_sharded_removals, &log);
+
+    pthread_t threads[LISTENER_THREADS];
+    listener_worker_args_t args[LISTENER_THREADS];
+    for (int i = 0; i < LISTENER_THREADS; i++)
+    {
+        args[i].cache = cache;
+        args[i].seed = i + 1;
+        pthread_create(&threads[i], NULL, listener_worker, &args[i]);
+    }
+    for (int i = 0; i < LISTENER_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    sharded_lru_maintenance(cache);
+
+    // Entries leave by eviction or deletion; none stays queued or pinned
+    sharded_lru_stats_t stats;
+    sharded_lru_get_stats(cache, &stats);
+    assert(stats.inserts - stats.size == (uint64_t)log.removals);
+    assert(stats.evictions > 0 && stats.evictions < (uint64_t)log.removals);
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        assert(cache->shards[i].cache->evicted_count == 0);
+        assert(cache->shards[i].cache->pinned.head == NULL);
+    }
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Listener\n");
+}
+
+void run_test_lru_cache_listener()
+{
+    test_listener_batches();
+    test_listener_reasons();
+    test_listener_refills_cache();
+    test_sharded_listener();
+}
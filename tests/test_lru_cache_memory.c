@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "lru_cache.h"
+
+// Sums the footprint of every resident entry by walking the recency list
+static size_t resident_bytes(LRUCache *cache)
+{
+    size_t total = 0;
+    for (Node *node = cache->list.head; node; node = node->lnext)
+    {
+        total += node_allocation_size(node) + LRU_ENTRY_INDEX_OVERHEAD;
+    }
+    return total;
+}
+
+static void fill_value(char *buf, size_t len, char c)
+{
+    memset(buf, c, len);
+    buf[len] = '\0';
+}
+
+// Test: A byte-budgeted cache needs a limit and starts empty
+void test_memory_limit_creation()
+{
+    assert(lru_cache_create_with_memory_limit(0) == NULL);
+
+    LRUCache *cache = lru_cache_create_with_memory_limit(64 * 1024);
+    assert(cache);
+    assert(cache->memory_limit == 64 * 1024);
+    assert(cache->bytes_used == 0);
+
+    lru_cache_set(cache, "key1", "value1");
+    assert(cache->bytes_used == resident_bytes(cache));
+    assert(strcmp(lru_cache_get(cache, "key1"), "value1") == 0);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Memory Limit Creation\n");
+}
+
+// Test: Inserts evict from the tail to stay within the byte budget
+void test_memory_limit_evicts_by_bytes()
+{
+    LRUCache *cache = lru_cache_create_with_memory_limit(16 * 1024);
+    assert(cache);
+
+    char key[32], value[201];
+    fill_value(value, 200, 'v');
+
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, value);
+        assert(cache->bytes_used <= cache->memory_limit);
+        assert(cache->bytes_used == resident_bytes(cache));
+    }
+
+    assert(cache->size > 0 && cache->size < 1000);
+    assert(lru_cache_get(cache, "key0") == NULL);
+    assert(strcmp(lru_cache_get(cache, "key999"), value) == 0);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Memory Limit Evicts By Bytes\n");
+}
+
+// Test: One large value displaces several small ones
+void test_memory_limit_large_value_evicts_many()
+{
+    LRUCache *cache = lru_cache_create_with_memory_limit(8 * 1024);
+    assert(cache);
+
+    char key[32], small[33], large[3001];
+    fill_value(small, 32, 's');
+    fill_value(large, 3000, 'l');
+
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(key, sizeof(key), "small%d", i);
+        lru_cache_set(cache, key, small);
+    }
+    int before = cache->size;
+
+    lru_cache_set(cache, "large", large);
+    assert(strcmp(lru_cache_get(cache, "large"), large) == 0);
+    assert(cache->size < before);
+    assert(cache->bytes_used <= cache->memory_limit);
+    assert(cache->bytes_used == resident_bytes(cache));
+
+    // Growing an existing value in place of a small one is charged too
+    lru_cache_set(cache, "small199", large);
+    assert(strcmp(lru_cache_get(cache, "small199"), large) == 0);
+    assert(cache->bytes_used <= cache->memory_limit);
+    assert(cache->bytes_used == resident_bytes(cache));
+
+    lru_cache_free(cache);
+    printf("Test Passed: Memory Limit Large Value Evicts Many\n");
+}
+
+// Test: Entries above the configured fraction of the budget are rejected
+void test_memory_limit_rejects_oversized_entries()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 0);
+    config.memory_limit = 8 * 1024;
+    config.max_entry_fraction = 0.25;
+
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+
+    char huge[4001];
+    fill_value(huge, 4000, 'h');
+
+    lru_cache_set(cache, "key1", "value1");
+    lru_cache_set(cache, "key2", "value2");
+    lru_cache_set(cache, "huge", huge);
+    assert(lru_cache_get(cache, "huge") == NULL);
+    assert(cache->size == 2);
+
+    // A rejected update must not leave the stale value behind
+    lru_cache_set(cache, "key1", huge);
+    assert(lru_cache_get(cache, "key1") == NULL);
+    assert(strcmp(lru_cache_get(cache, "key2"), "value2") == 0);
+    assert(cache->bytes_used == resident_bytes(cache));
+
+    lru_cache_free(cache);
+    printf("Test Passed: Memory Limit Rejects Oversized Entries\n");
+}
+
+// Test: Item count and byte budget can both bound the same cache
+void test_memory_limit_with_item_capacity()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 3);
+    config.memory_limit = 1024 * 1024;
+
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+
+    lru_cache_set(cache, "key1", "value1");
+    lru_cache_set(cache, "key2", "value2");
+    lru_cache_set(cache, "key3", "value3");
+    lru_cache_set(cache, "key4", "value4"); // Evicts "key1" on count, not bytes
+
+    assert(cache->size == 3);
+    assert(lru_cache_get(cache, "key1") == NULL);
+    assert(cache->bytes_used == resident_bytes(cache));
+
+    lru_cache_free(cache);
+    printf("Test Passed: Memory Limit With Item Capacity\n");
+}
+
+void run_test_lru_cache_memory()
+{
+    printf("Running Memory Limit tests for LRU Cache...\n");
+    test_memory_limit_creation();
+    test_memory_limit_evicts_by_bytes();
+    test_memory_limit_large_value_evicts_many();
+    test_memory_limit_rejects_oversized_entries();
+    test_memory_limit_with_item_capacity();
+    printf("Memory limit tests passed!\n");
+}
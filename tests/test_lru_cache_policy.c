@@ -0,0 +1,574 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "lru_cache.h"
+#include "ghost_list.h"
+
+#define POLICY_KEYS 1000
+#define POLICY_OPERATIONS 200000
+
+static LRUCache *create_with_policy(int capacity, lru_policy_t policy)
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, capacity);
+    config.policy = policy;
+    return lru_cache_create_with_config(&config);
+}
+
+// Test: A CLOCK hit only sets the reference bit and leaves the list alone
+void test_clock_hit_is_single_store()
+{
+    LRUCache *cache = create_with_policy(3, LRU_POLICY_CLOCK);
+    assert(cache);
+
+    lru_cache_set(cache, "a", "1");
+    lru_cache_set(cache, "b", "2");
+    lru_cache_set(cache, "c", "3");
+
+    Node *head = cache->list.head;
+    Node *tail = cache->list.tail;
+    assert(strcmp(lru_cache_get(cache, "a"), "1") == 0);
+    assert(cache->list.head == head && cache->list.tail == tail);
+    assert(tail->policy_flags & NODE_REFERENCED);
+
+    lru_cache_free(cache);
+    printf("Test Passed: CLOCK Hit Is a Single Store\n");
+}
+
+// Test: The hand gives referenced entries a second chance
+void test_clock_second_chance()
+{
+    LRUCache *cache = create_with_policy(3, LRU_POLICY_CLOCK);
+    assert(cache);
+
+    lru_cache_set(cache, "a", "1");
+    lru_cache_set(cache, "b", "2");
+    lru_cache_set(cache, "c", "3");
+    assert(lru_cache_get(cache, "a"));
+
+    lru_cache_set(cache, "d", "4"); // Clears a's bit and evicts b
+    assert(lru_cache_get(cache, "b") == NULL);
+    assert(lru_cache_get(cache, "a"));
+    assert(lru_cache_get(cache, "c"));
+    assert(lru_cache_get(cache, "d"));
+    assert(cache->size == 3);
+
+    lru_cache_free(cache);
+    printf("Test Passed: CLOCK Second Chance\n");
+}
+
+// Hits on a reused working set while one-off scans run between rounds. Each
+// key is reused after 190 others, more than the cache holds but within the
+// reach of CLOCK-Pro's ghosts.
+static int working_set_hits(lru_policy_t policy)
+{
+    LRUCache *cache = create_with_policy(100, policy);
+    assert(cache);
+
+    char key[32];
+    int hits = 0;
+    int scanned = 0;
+
+    for (int round = 0; round < 30; round++)
+    {
+        for (int i = 0; i < 50; i++)
+        {
+            snprintf(key, sizeof(key), "hot%d", i);
+            if (lru_cache_get(cache, key))
+            {
+                hits += round >= 10;
+            }
+            else
+            {
+                lru_cache_set(cache, key, "value");
+            }
+        }
+        for (int i = 0; i < 140; i++)
+        {
+            snprintf(key, sizeof(key), "scan%d", scanned++);
+            lru_cache_set(cache, key, "value");
+        }
+    }
+
+    lru_cache_free(cache);
+    return hits;
+}
+
+// Test: CLOCK-Pro keeps a reused working set through scans that flush LRU
+void test_clock_pro_scan_resistance()
+{
+    int lru_hits = working_set_hits(LRU_POLICY_LRU);
+    int clock_pro_hits = working_set_hits(LRU_POLICY_CLOCK_PRO);
+
+    assert(lru_hits == 0);
+    assert(clock_pro_hits >= 20 * 50 * 9 / 10);
+
+    printf("Test Passed: CLOCK-Pro Scan Resistance (%d vs %d working set hits)\n",
+           clock_pro_hits, lru_hits);
+}
+
+// Replays a cache-aside trace (get, then set on a miss) and returns the hit
+// ratio. Half the requests go to a skewed set of 5000 reused keys; the other
+// half scan keys that are never requested again.
+static double trace_hit_ratio(lru_policy_t policy)
+{
+    LRUCache *cache = create_with_policy(500, policy);
+    assert(cache);
+
+    char key[32];
+    unsigned int state = 2463534242u;
+    int scanned = 0;
+    int hits = 0;
+    int requests = 0;
+
+    for (int i = 0; i < 400000; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        if (state & 1)
+        {
+            // Cubing a uniform draw concentrates requests on the low ids
+            unsigned long long u = (state >> 1) % 5000;
+            snprintf(key, sizeof(key), "reused%llu", u * u * u / (5000ULL * 5000ULL));
+        }
+        else
+        {
+            snprintf(key, sizeof(key), "scan%d", scanned++);
+        }
+
+        if (lru_cache_get(cache, key))
+        {
+            hits++;
+        }
+        else
+        {
+            lru_cache_set(cache, key, "value");
+        }
+        requests++;
+    }
+
+    lru_cache_free(cache);
+    return (double)hits / requests;
+}
+
+// Test: W-TinyLFU keeps popular keys through scans that pollute LRU
+void test_tinylfu_scan_polluted_trace()
+{
+    double lru = trace_hit_ratio(LRU_POLICY_LRU);
+    double tinylfu = trace_hit_ratio(LRU_POLICY_TINYLFU);
+
+    printf("Scan-polluted trace hit ratio: LRU %.1f%%, W-TinyLFU %.1f%%\n", 100 * lru, 100 * tinylfu);
+    assert(tinylfu > lru * 1.5);
+
+    printf("Test Passed: W-TinyLFU Scan-Polluted Trace\n");
+}
+
+// Test: Keys seen once are not admitted over a frequently used victim
+void test_tinylfu_admission()
+{
+    LRUCache *cache = create_with_policy(100, LRU_POLICY_TINYLFU);
+    assert(cache);
+
+    char key[32];
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "hot%d", i);
+        lru_cache_set(cache, key, "value");
+        for (int j = 0; j < 3; j++)
+        {
+            assert(lru_cache_get(cache, key));
+        }
+    }
+
+    for (int i = 0; i < 500; i++)
+    {
+        snprintf(key, sizeof(key), "once%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+
+    // Only the one-entry window turns over; the main region survives. The
+    // scan is kept shorter than the sketch's sample so nothing ages.
+    int resident = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "hot%d", i);
+        resident += lru_cache_get(cache, key) != NULL;
+    }
+    assert(resident >= 98);
+    assert(cache->segment_size[TINYLFU_WINDOW] == 1);
+
+    lru_cache_free(cache);
+    printf("Test Passed: W-TinyLFU Admission\n");
+}
+
+// Test: ARC moves re-used keys to T2 and grows T1's target on B1 ghost hits
+void test_arc_adaptation()
+{
+    LRUCache *cache = create_with_policy(4, LRU_POLICY_ARC);
+    assert(cache);
+
+    lru_cache_set(cache, "a", "1");
+    lru_cache_set(cache, "b", "2");
+    assert(lru_cache_get(cache, "a"));
+    assert(cache->segment_size[ARC_T1] == 1 && cache->segment_size[ARC_T2] == 1);
+
+    lru_cache_set(cache, "c", "3");
+    lru_cache_set(cache, "d", "4");
+    lru_cache_set(cache, "e", "5"); // T1 is over its target of 0: evicts b into B1
+    assert(lru_cache_get(cache, "b") == NULL);
+    assert(lru_cache_get(cache, "a"));
+    assert(cache->arc_target == 0);
+
+    lru_cache_set(cache, "b", "2"); // B1 ghost hit
+    assert(cache->arc_target == 1);
+    assert(cache->segment_size[ARC_T2] == 2);
+    assert(lru_cache_get(cache, "b"));
+
+    lru_cache_free(cache);
+    printf("Test Passed: ARC Adaptation\n");
+}
+
+// Test: An ARC insert dropped for lack of slab memory leaves the ghost it
+// matched and the T1 target as they were
+void test_arc_dropped_insert_keeps_ghost()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 8);
+    config.policy = LRU_POLICY_ARC;
+    config.slab_page_size = 4096;
+    config.slab_memory_limit = 2 * 4096;
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+
+    // One page holds nothing but a deleted entry a handle still pins
+    char medium[201];
+    memset(medium, 'm', 200);
+    medium[200] = '\0';
+    lru_cache_set(cache, "pinned", medium);
+    lru_handle_t *handle = lru_cache_acquire(cache, "pinned");
+    assert(handle && lru_cache_delete(cache, "pinned") == 1);
+
+    // The other holds small entries; key0 is evicted into B1
+    char key[32];
+    for (int i = 0; i < 9; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+    assert(lru_cache_delete(cache, "key8") == 1);
+    uint64_t hash = cache->hash_fn("key0", 4, cache->hash_seed);
+    assert(ghost_list_contains(&cache->ghosts, hash));
+    size_t target = cache->arc_target;
+    int size = cache->size;
+
+    // A value of a third size class finds no chunk and no page it can take
+    char large[1001];
+    memset(large, 'l', 1000);
+    large[1000] = '\0';
+    lru_cache_set(cache, "key0", large);
+    assert(lru_cache_get(cache, "key0") == NULL);
+    assert(cache->size == size && cache->arc_target == target);
+    assert(cache->arc_incoming == ARC_GHOST_NONE);
+    assert(ghost_list_contains(&cache->ghosts, hash));
+
+    // Once stored, the key is taken off B1 and goes to T2
+    lru_cache_set(cache, "key0", "value");
+    assert(!ghost_list_contains(&cache->ghosts, hash));
+    assert(cache->arc_target == target + 1 && cache->segment_size[ARC_T2] >= 1);
+
+    lru_cache_release(cache, handle);
+    lru_cache_free(cache);
+    printf("Test Passed: ARC Dropped Insert Keeps Ghost\n");
+}
+
+// Test: An update that moves the entry to a new block, because the value
+// grew or a handle pins the old one, counts as a single hit
+void test_copied_update_is_one_hit()
+{
+    LRUCache *cache = create_with_policy(100, LRU_POLICY_TINYLFU);
+    assert(cache);
+
+    char *keys[] = {"in_place", "grown", "pinned"};
+    for (int i = 0; i < 3; i++)
+    {
+        lru_cache_set(cache, keys[i], "1");
+    }
+
+    lru_handle_t *handle = lru_cache_acquire(cache, "pinned");
+    assert(handle);
+    lru_cache_set(cache, "in_place", "2");
+    lru_cache_set(cache, "grown", "a value too long for the old block");
+    lru_cache_set(cache, "pinned", "2");
+    lru_cache_release(cache, handle);
+
+    // The acquire was a hit of its own
+    int expected[] = {2, 2, 3};
+    for (int i = 0; i < 3; i++)
+    {
+        uint64_t hash = cache->hash_fn(keys[i], strlen(keys[i]), cache->hash_seed);
+        assert(sketch_estimate(&cache->sketch, hash) == expected[i]);
+    }
+
+    lru_cache_free(cache);
+    printf("Test Passed: Copied Update Is One Hit\n");
+}
+
+// Replays a trace that alternates between a recency-friendly phase (a
+// sliding window of fresh keys) and a frequency-friendly one (a fixed hot
+// set mixed with one-off keys) and returns the hit ratio
+static double phase_shift_hit_ratio(lru_policy_t policy)
+{
+    LRUCache *cache = create_with_policy(200, policy);
+    assert(cache);
+
+    char key[32];
+    unsigned int state = 88172645u;
+    int hits = 0;
+    int requests = 0;
+    int fresh = 0;
+
+    for (int phase = 0; phase < 20; phase++)
+    {
+        for (int i = 0; i < 10000; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            if (phase % 2 == 0)
+            {
+                // Reuse among the 150 most recent fresh keys
+                if (state % 4 == 0)
+                {
+                    fresh++;
+                }
+                snprintf(key, sizeof(key), "fresh%d", fresh - (int)((state >> 8) % 150));
+            }
+            else if (state % 2 == 0)
+            {
+                snprintf(key, sizeof(key), "hot%u", (state >> 8) % 150);
+            }
+            else
+            {
+                snprintf(key, sizeof(key), "once%d-%d", phase, i);
+            }
+
+            if (lru_cache_get(cache, key))
+            {
+                hits++;
+            }
+            else
+            {
+                lru_cache_set(cache, key, "value");
+            }
+            requests++;
+        }
+    }
+
+    lru_cache_free(cache);
+    return (double)hits / requests;
+}
+
+// Test: ARC does at least as well as LRU when the workload changes character
+void test_arc_phase_shift_trace()
+{
+    double lru = phase_shift_hit_ratio(LRU_POLICY_LRU);
+    double arc = phase_shift_hit_ratio(LRU_POLICY_ARC);
+
+    printf("Phase-shift trace hit ratio: LRU %.1f%%, ARC %.1f%%\n", 100 * lru, 100 * arc);
+    assert(arc > lru);
+
+    printf("Test Passed: ARC Phase-Shift Trace\n");
+}
+
+// Test: Sketch counts saturate at 15 and halve when aged
+void test_frequency_sketch()
+{
+    frequency_sketch_t sketch;
+    assert(sketch_init(&sketch, 64));
+
+    for (int i = 0; i < 20; i++)
+    {
+        sketch_increment(&sketch, 42);
+    }
+    assert(sketch_estimate(&sketch, 42) == SKETCH_MAX_COUNT);
+    assert(sketch_estimate(&sketch, 43) <= 1);
+
+    // Fill the sample with other keys so the counters age
+    for (uint64_t hash = 1000; sketch.additions > 0 && sketch_estimate(&sketch, 42) == SKETCH_MAX_COUNT; hash++)
+    {
+        sketch_increment(&sketch, hash * 0x9E3779B97F4A7C15ULL);
+    }
+    assert(sketch_estimate(&sketch, 42) <= SKETCH_MAX_COUNT / 2 + 1);
+
+    sketch_destroy(&sketch);
+    printf("Test Passed: Frequency Sketch\n");
+}
+
+// Checks that the lists, index, sizes and hot count agree
+static void check_structure(LRUCache *cache)
+{
+    int count = 0;
+    size_t hot = 0;
+    int hand_found = cache->hand == NULL;
+
+    for (int i = 0; i < LRU_POLICY_LISTS; i++)
+    {
+        int listed = 0;
+        for (Node *node = policy_list(cache, i)->head; node; node = node->lnext)
+        {
+            assert(!node->lnext || node->lnext->lprev == node);
+            assert(((node->policy_flags & NODE_SEGMENT_MASK) >> NODE_SEGMENT_SHIFT) == i);
+            assert(hash_index_find(&cache->index, node->kv_pair.hash, node->kv_pair.key,
+                                   node->kv_pair.key_len) == node);
+            hot += (node->policy_flags & NODE_HOT) != 0;
+            hand_found |= node == cache->hand;
+            listed++;
+        }
+        assert(listed == cache->segment_size[i]);
+        count += listed;
+    }
+
+    assert(count == cache->size);
+    assert(hand_found);
+    if (cache->policy == LRU_POLICY_CLOCK_PRO)
+    {
+        assert(hot == cache->hot_count);
+    }
+}
+
+// Runs random gets and sets and checks every hit returns the latest value
+static void random_operations(lru_policy_t policy)
+{
+    LRUCache *cache = create_with_policy(POLICY_KEYS / 4, policy);
+    assert(cache);
+
+    int *versions = calloc(POLICY_KEYS, sizeof(int));
+    assert(versions);
+
+    char key[32], value[64];
+    unsigned int state = 12345u + (unsigned int)policy;
+
+    for (int i = 0; i < POLICY_OPERATIONS; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        int id = (int)((state >> 8) % POLICY_KEYS);
+        snprintf(key, sizeof(key), "key%d", id);
+
+        if ((state >> 4) % 3 == 0)
+        {
+            // Vary the value length so updates also take the copy path
+            versions[id]++;
+            snprintf(value, sizeof(value), "v%d-%0*d", id, versions[id] % 40, versions[id]);
+            lru_cache_set(cache, key, value);
+        }
+        else
+        {
+            char *found = lru_cache_get(cache, key);
+            if (found)
+            {
+                snprintf(value, sizeof(value), "v%d-%0*d", id, versions[id] % 40, versions[id]);
+                assert(strcmp(found, value) == 0);
+            }
+        }
+
+        assert(cache->size <= cache->capacity);
+        if (i % 4096 == 0)
+        {
+            check_structure(cache);
+        }
+    }
+    check_structure(cache);
+
+    free(versions);
+    lru_cache_free(cache);
+}
+
+// Test: Every policy stays consistent under random operations
+void test_policy_random_operations()
+{
+    random_operations(LRU_POLICY_LRU);
+    random_operations(LRU_POLICY_CLOCK);
+    random_operations(LRU_POLICY_CLOCK_PRO);
+    random_operations(LRU_POLICY_TINYLFU);
+    random_operations(LRU_POLICY_ARC);
+    printf("Test Passed: Policy Random Operations\n");
+}
+
+// Test: Ghost list membership, removal and ageing
+void test_ghost_list()
+{
+    ghost_list_t ghosts;
+    assert(ghost_list_init(&ghosts));
+
+    for (uint64_t hash = 0; hash < 1000; hash++)
+    {
+        assert(ghost_list_push(&ghosts, hash * 0x9E3779B97F4A7C15ULL, 1000) == 0);
+    }
+    for (uint64_t hash = 0; hash < 1000; hash++)
+    {
+        assert(ghost_list_contains(&ghosts, hash * 0x9E3779B97F4A7C15ULL));
+    }
+
+    // Removed hashes are not counted when they age out
+    assert(ghost_list_remove(&ghosts, 0));
+    assert(!ghost_list_contains(&ghosts, 0));
+    assert(!ghost_list_remove(&ghosts, 0));
+    assert(ghost_list_push(&ghosts, 1ULL << 40, 1000) == 0);
+
+    size_t aged_out = ghost_list_push(&ghosts, 1ULL << 41, 10);
+    assert(aged_out == 991);
+    assert(ghosts.count == 10);
+    assert(!ghost_list_contains(&ghosts, 5 * 0x9E3779B97F4A7C15ULL));
+    assert(ghost_list_contains(&ghosts, 999 * 0x9E3779B97F4A7C15ULL));
+    assert(ghost_list_contains(&ghosts, 1ULL << 41));
+
+    ghost_list_clear(&ghosts);
+    assert(!ghost_list_contains(&ghosts, 1ULL << 41));
+
+    // A hash removed and pushed again is remembered by its newer push: the
+    // stale entry neither takes a place under the limit nor drops it
+    assert(ghost_list_push(&ghosts, 1, 3) == 0);
+    assert(ghost_list_push(&ghosts, 2, 3) == 0);
+    assert(ghost_list_remove(&ghosts, 1));
+    assert(ghost_list_push(&ghosts, 1, 3) == 0);
+    assert(ghost_list_push(&ghosts, 3, 3) == 0);
+    assert(ghost_list_contains(&ghosts, 1) && ghost_list_contains(&ghosts, 2));
+    assert(ghost_list_push(&ghosts, 4, 3) == 1);
+    assert(!ghost_list_contains(&ghosts, 2));
+    assert(ghost_list_contains(&ghosts, 1) && ghost_list_contains(&ghosts, 3));
+
+    // Churn through removals compacts the ring instead of growing it
+    size_t capacity = ghosts.ring_capacity;
+    for (uint64_t hash = 100; hash < 100 + 20 * capacity; hash++)
+    {
+        ghost_list_push(&ghosts, hash, 3);
+        assert(ghost_list_remove(&ghosts, hash));
+    }
+    assert(ghosts.ring_capacity == capacity && ghosts.set_size == 2);
+    assert(ghost_list_contains(&ghosts, 3) && ghost_list_contains(&ghosts, 4));
+
+    ghost_list_destroy(&ghosts);
+    printf("Test Passed: Ghost List\n");
+}
+
+void run_test_lru_cache_policy()
+{
+    printf("Running LRU, CLOCK, CLOCK-Pro, W-TinyLFU and ARC tests...\n");
+    test_clock_hit_is_single_store();
+    test_clock_second_chance();
+    test_clock_pro_scan_resistance();
+    test_policy_random_operations();
+    test_ghost_list();
+    test_tinylfu_scan_polluted_trace();
+    test_tinylfu_admission();
+    test_frequency_sketch();
+    test_arc_adaptation();
+    test_arc_dropped_insert_keeps_ghost();
+    test_copied_update_is_one_hit();
+    test_arc_phase_shift_trace();
+    printf("Eviction policy tests passed!\n");
+}
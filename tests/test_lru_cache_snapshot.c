@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include "lru_cache.h"
+#include "lru_snapshot.h"
+#include "test_helpers.h"
+
+#define SNAPSHOT_ENTRIES 20000
+
+// Builds a path for a snapshot file in the temporary directory
+static void snapshot_path(char *path, size_t size, const char *name)
+{
+    snprintf(path, size, "/tmp/lru_snapshot_%d_%s", (int)getpid(), name);
+}
+
+// Test: Entries, recency order and binary values survive a save and load
+void test_snapshot_round_trip()
+{
+    char path[128];
+    snapshot_path(path, sizeof(path), "round_trip");
+
+    LRUCache *cache = lru_cache_create(SNAPSHOT_ENTRIES + 1);
+    char key[32], value[64];
+    for (int i = 0; i < SNAPSHOT_ENTRIES; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        snprintf(value, sizeof(value), "value%d", i);
+        lru_cache_set(cache, key, value);
+    }
+    char blob[] = {'b', '\0', 'l', 0x7f, '\0'};
+    lru_cache_set_bin(cache, "blob", 4, blob, sizeof(blob), DEFAULT_EXPIRATION_MS);
+    lru_cache_get(cache, "key0"); // Most recent after the blob
+
+    assert(lru_cache_save(cache, path));
+    LRUCache *loaded = lru_cache_load(path);
+    assert(loaded);
+    assert(loaded->capacity == cache->capacity);
+    assert(loaded->size == cache->size);
+
+    // The recency lists match entry for entry
+    Node *a = cache->list.head;
+    Node *b = loaded->list.head;
+    while (a && b)
+    {
+        assert(a->kv_pair.key_len == b->kv_pair.key_len);
+        assert(memcmp(a->kv_pair.key, b->kv_pair.key, a->kv_pair.key_len) == 0);
+        assert(a->kv_pair.value_len == b->kv_pair.value_len);
+        assert(memcmp(kv_pair_get_value(&a->kv_pair), kv_pair_get_value(&b->kv_pair),
+                      a->kv_pair.value_len) == 0);
+        a = a->lnext;
+        b = b->lnext;
+    }
+    assert(!a && !b);
+    assert(strcmp(loaded->list.head->kv_pair.key, "key0") == 0);
+
+    size_t len = 0;
+    char *loaded_blob = lru_cache_get_bin(loaded, "blob", 4, &len);
+    assert(loaded_blob && len == sizeof(blob) && memcmp(loaded_blob, blob, len) == 0);
+
+    // The loaded cache keeps working: inserting evicts the least recent entry
+    lru_cache_set(loaded, "new", "entry");
+    assert(lru_cache_get(loaded, "key1") == NULL);
+
+    lru_cache_free(cache);
+    lru_cache_free(loaded);
+    unlink(path);
+    printf("Test Passed: Snapshot Round Trip\n");
+}
+
+// Test: Remaining TTLs carry over and expired entries are left out
+void test_snapshot_ttl()
+{
+    char path[128];
+    snapshot_path(path, sizeof(path), "ttl");
+
+    lru_clock_t clock;
+    LRUCache *cache = create_with_clock(8, LRU_POLICY_LRU, &clock);
+    lru_cache_set_with_expiration(cache, "expired", "1", 100);
+    lru_cache_set_with_expiration(cache, "short", "2", 500);
+    lru_cache_set(cache, "long", "3");
+    lru_clock_advance(&clock, 200);
+    assert(lru_cache_save(cache, path));
+
+    // A clock with an unrelated origin, as in a restarted process
+    lru_clock_t restarted;
+    lru_clock_init(&restarted, LRU_CLOCK_FAKE);
+    lru_clock_set(&restarted, 42);
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 8);
+    config.clock = &restarted;
+
+    LRUCache *loaded = lru_cache_load_with_config(path, &config);
+    assert(loaded);
+    assert(loaded->size == 2);
+    assert(lru_cache_get(loaded, "expired") == NULL);
+
+    lru_clock_advance(&restarted, 299);
+    assert(strcmp(lru_cache_get(loaded, "short"), "2") == 0);
+    lru_clock_advance(&restarted, 1);
+    assert(lru_cache_get(loaded, "short") == NULL);
+    assert(strcmp(lru_cache_get(loaded, "long"), "3") == 0);
+
+    lru_cache_free(cache);
+    lru_cache_free(loaded);
+    unlink(path);
+    printf("Test Passed: Snapshot TTL\n");
+}
+
+// Test: A smaller cache keeps the most recently used entries
+void test_snapshot_into_smaller_cache()
+{
+    char path[128];
+    snapshot_path(path, sizeof(path), "smaller");
+
+    LRUCache *cache = lru_cache_create(100);
+    char key[32];
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+    assert(lru_cache_save(cache, path));
+
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 10);
+    LRUCache *loaded = lru_cache_load_with_config(path, &config);
+    assert(loaded);
+    assert(loaded->size == 10);
+    for (int i = 90; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        assert(lru_cache_get(loaded, key));
+    }
+
+    lru_cache_free(cache);
+    lru_cache_free(loaded);
+    unlink(path);
+    printf("Test Passed: Snapshot Into Smaller Cache\n");
+}
+
+// Test: Segmented policies get their entries back on the same lists
+void test_snapshot_policy_lists()
+{
+    char path[128];
+    snapshot_path(path, sizeof(path), "policy");
+
+    lru_clock_t clock;
+    LRUCache *cache = create_with_clock(16, LRU_POLICY_ARC, &clock);
+    char key[32];
+    for (int i = 0; i < 16; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+    for (int i = 0; i < 16; i += 3)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_get(cache, key); // Moves to T2
+    }
+    assert(lru_cache_save(cache, path));
+
+    LRUCache *loaded = lru_cache_load(path);
+    assert(loaded);
+    assert(loaded->policy == LRU_POLICY_ARC);
+    assert(loaded->segment_size[ARC_T1] == cache->segment_size[ARC_T1]);
+    assert(loaded->segment_size[ARC_T2] == cache->segment_size[ARC_T2]);
+    assert(strcmp(policy_list(loaded, ARC_T2)->head->kv_pair.key,
+                  policy_list(cache, ARC_T2)->head->kv_pair.key) == 0);
+
+    // Under a different policy the entries all start on its first list
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 16);
+    LRUCache *as_lru = lru_cache_load_with_config(path, &config);
+    assert(as_lru && as_lru->size == 16 && as_lru->segment_size[0] == 16);
+
+    // A smaller cache keeps the T2 entries over the more recent T1 ones
+    lru_cache_config_init(&config, 6);
+    config.policy = LRU_POLICY_ARC;
+    LRUCache *smaller = lru_cache_load_with_config(path, &config);
+    assert(smaller && smaller->size == 6 && smaller->segment_size[ARC_T2] == 6);
+    for (int i = 0; i < 16; i += 3)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        assert(lru_cache_get(smaller, key));
+    }
+    lru_cache_free(smaller);
+
+    lru_cache_free(cache);
+    lru_cache_free(loaded);
+    lru_cache_free(as_lru);
+    unlink(path);
+    printf("Test Passed: Snapshot Policy Lists\n");
+}
+
+// Test: Missing, truncated and corrupted snapshots are rejected
+void test_snapshot_rejects_damage()
+{
+    char path[128];
+    snapshot_path(path, sizeof(path), "damage");
+
+    assert(lru_cache_load(path) == NULL);
+
+    LRUCache *cache = lru_cache_create(64);
+    char key[32];
+    for (int i = 0; i < 64; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "some value bytes");
+    }
+    assert(lru_cache_save(cache, path));
+    lru_cache_free(cache);
+
+    FILE *file = fopen(path, "rb");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    char *bytes = malloc((size_t)size);
+    fseek(file, 0, SEEK_SET);
+    assert(fread(bytes, 1, (size_t)size, file) == (size_t)size);
+    fclose(file);
+
+    // One flipped bit in the middle of the records
+    bytes[size / 2] ^= 0x10;
+    file = fopen(path, "wb");
+    fwrite(bytes, 1, (size_t)size, file);
+    fclose(file);
+    assert(lru_cache_load(path) == NULL);
+
+    // The last few bytes missing
+    bytes[size / 2] ^= 0x10;
+    file = fopen(path, "wb");
+    fwrite(bytes, 1, (size_t)size - 3, file);
+    fclose(file);
+    assert(lru_cache_load(path) == NULL);
+
+    // A damaged header
+    ((lru_snapshot_header_t *)bytes)->capacity++;
+    file = fopen(path, "wb");
+    fwrite(bytes, 1, (size_t)size, file);
+    fclose(file);
+    assert(lru_cache_load(path) == NULL);
+
+    free(bytes);
+    unlink(path);
+    printf("Test Passed: Snapshot Rejects Damage\n");
+}
+
+void run_test_lru_cache_snapshot()
+{
+    test_snapshot_round_trip();
+    test_snapshot_ttl();
+    test_snapshot_into_smaller_cache();
+    test_snapshot_policy_lists();
+    test_snapshot_rejects_damage();
+}
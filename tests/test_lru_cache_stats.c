@@ -53,13 +53,62 @@ void test_reset_stats()
     lru_cache_get(cache, "key1"); // Hit
     lru_cache_get(cache, "key3"); // Miss
 
-    assert(cache->hits == 1);
-    assert(cache->misses == 3);
+    // Sets count as inserts, not as lookups
+    lru_cache_stats_t stats;
+    lru_cache_get_stats(cache, &stats);
+    assert(stats.hits == 1);
+    assert(stats.misses == 1);
+    assert(stats.inserts == 2);
 
     lru_cache_reset_stats(cache);
 
-    assert(cache->hits == 0);
-    assert(cache->misses == 0);
+    lru_cache_get_stats(cache, &stats);
+    assert(stats.hits == 0);
+    assert(stats.misses == 0);
+    assert(stats.inserts == 0);
+    assert(stats.size == 2); // The size is not a counter
+
+    lru_cache_free(cache);
+}
+
+void test_detailed_counters()
+{
+    lru_clock_t clock;
+    lru_clock_init(&clock, LRU_CLOCK_FAKE);
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 2);
+    config.clock = &clock;
+    LRUCache *cache = lru_cache_create_with_config(&config);
+
+    lru_cache_set(cache, "key1", "value1");
+    lru_cache_set(cache, "key1", "longer value1"); // Update
+    lru_cache_set(cache, "key2", "value2");
+    lru_cache_set(cache, "key3", "value3");        // Evicts key1
+    lru_cache_set_with_expiration(cache, "key4", "value4", 10); // Evicts key2
+    lru_clock_advance(&clock, 10);
+    assert(lru_cache_get(cache, "key4") == NULL);  // Expired
+    assert(lru_cache_get(cache, "key3") != NULL);
+
+    lru_cache_stats_t stats;
+    lru_cache_get_stats(cache, &stats);
+    assert(stats.hits == 1);
+    assert(stats.misses == 1);
+    assert(stats.inserts == 4);
+    assert(stats.updates == 1);
+    assert(stats.evictions == 2);
+    assert(stats.expirations == 1);
+    assert(stats.bytes_written == 10 + 17 + 10 + 10 + 10);
+    assert(stats.size == 1);
+    assert(stats.bytes_used == cache->bytes_used);
+
+    // An expired entry chosen to make room counts as an expiration
+    lru_cache_set_with_expiration(cache, "key5", "value5", 10);
+    lru_clock_advance(&clock, 10);
+    lru_cache_set(cache, "key6", "value6"); // Removes the expired key5
+    lru_cache_get_stats(cache, &stats);
+    assert(stats.expirations == 2);
+    assert(stats.evictions == 2);
+    lru_cache_print_stats(cache);
 
     lru_cache_free(cache);
 }
@@ -72,5 +121,6 @@ void run_test_lru_cache_stats()
     test_eviction();
     test_statistics_output();
     test_reset_stats();
+    test_detailed_counters();
     printf("Stats tests passed!\n");
 }
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include "lru_cache.h"
+#include "hash_utils.h"
+
+#define STRESS_OPERATIONS 2000000
+#define STRESS_KEY_SPACE 256
+#define STRESS_CHECK_INTERVAL 4096
+
+// Deterministic xorshift generator so failures are reproducible
+static unsigned long long stress_rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned int stress_rand(void)
+{
+    stress_rng_state ^= stress_rng_state << 13;
+    stress_rng_state ^= stress_rng_state >> 7;
+    stress_rng_state ^= stress_rng_state << 17;
+    return (unsigned int)(stress_rng_state >> 32);
+}
+
+// Shadow model: key ids ordered from most to least recently used
+typedef struct
+{
+    int order[STRESS_KEY_SPACE];
+    int values[STRESS_KEY_SPACE];
+    int size;
+} shadow_t;
+
+static int shadow_find(shadow_t *shadow, int id)
+{
+    for (int i = 0; i < shadow->size; i++)
+    {
+        if (shadow->order[i] == id)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void shadow_touch(shadow_t *shadow, int pos)
+{
+    int id = shadow->order[pos];
+    memmove(&shadow->order[1], &shadow->order[0], pos * sizeof(int));
+    shadow->order[0] = id;
+}
+
+// Walks both intrusive structures and checks they describe the same set of nodes
+static void check_consistency(LRUCache *cache, shadow_t *shadow)
+{
+    int list_count = 0;
+    size_t bytes = 0;
+    Node *prev = NULL;
+    for (Node *node = cache->list.head; node; node = node->lnext)
+    {
+        assert(node->lprev == prev);
+
+        // Recency order must agree with the shadow model
+        int id = atoi(kv_pair_get_key(&node->kv_pair) + 1);
+        assert(list_count < shadow->size && shadow->order[list_count] == id);
+
+        // Every listed node must be reachable through the index
+        kv_pair_t *kv_pair = &node->kv_pair;
+        assert(kv_pair->hash == cache->hash_fn(kv_pair->key, kv_pair->key_len, cache->hash_seed));
+        assert(kv_pair->key_len == strlen(kv_pair->key));
+        assert(kv_pair->value_len == strlen(kv_pair_get_value(kv_pair)));
+        assert(kv_pair->value_len < kv_pair->value_capacity);
+        assert(hash_index_find(&cache->index, kv_pair->hash, kv_pair->key, kv_pair->key_len) == node);
+
+        bytes += node_allocation_size(node) + LRU_ENTRY_INDEX_OVERHEAD;
+        prev = node;
+        list_count++;
+    }
+    assert(cache->list.tail == prev);
+    assert(list_count == cache->size);
+    assert(bytes == cache->bytes_used);
+    assert(cache->size == shadow->size);
+
+    // The index must hold exactly the listed nodes, with no stale slots left
+    // behind. During a rebuild the entries are those of the new table plus
+    // the part of the older table not yet copied into it.
+    size_t indexed = 0;
+    hash_index_table_t *table = cache->index.table;
+    for (size_t slot = 0; slot < table->capacity; slot++)
+    {
+        if (!(table->ctrl[slot] & HASH_INDEX_CTRL_EMPTY))
+        {
+            Node *node = table->slots[slot];
+            assert((table->ctrl[slot] & 0x7F) == (node->kv_pair.hash & 0x7F));
+            indexed++;
+        }
+    }
+    hash_index_table_t *older = cache->index.older;
+    for (size_t slot = older ? cache->index.rehash_cursor : 0; older && slot < older->capacity; slot++)
+    {
+        if (!(older->ctrl[slot] & HASH_INDEX_CTRL_EMPTY))
+        {
+            Node *node = older->slots[slot];
+            assert((older->ctrl[slot] & 0x7F) == (node->kv_pair.hash & 0x7F));
+            indexed++;
+        }
+    }
+    assert(indexed == cache->index.size);
+    assert(indexed == (size_t)cache->size);
+}
+
+// Test: Random get/set/resize mix against a shadow LRU model
+void test_random_operations_keep_structures_consistent()
+{
+    int capacity = 64;
+    LRUCache *cache = lru_cache_create(capacity);
+    assert(cache);
+
+    shadow_t shadow = {0};
+    char key[32], value[32];
+
+    for (int op = 0; op < STRESS_OPERATIONS; op++)
+    {
+        unsigned int r = stress_rand();
+        int id = (r >> 8) % STRESS_KEY_SPACE;
+        int pos = shadow_find(&shadow, id);
+        snprintf(key, sizeof(key), "k%d", id);
+
+        if ((r & 0xff) < 128)
+        {
+            int version = (int)(stress_rand() & 0xffff);
+            snprintf(value, sizeof(value), "v%d", version);
+            lru_cache_set(cache, key, value);
+
+            if (pos < 0)
+            {
+                if (shadow.size == capacity)
+                {
+                    shadow.size--;
+                }
+                memmove(&shadow.order[1], &shadow.order[0], shadow.size * sizeof(int));
+                shadow.order[0] = id;
+                shadow.size++;
+            }
+            else
+            {
+                shadow_touch(&shadow, pos);
+            }
+            shadow.values[id] = version;
+        }
+        else if ((r & 0xff) < 254)
+        {
+            char *got = lru_cache_get(cache, key);
+            if (pos < 0)
+            {
+                assert(got == NULL);
+            }
+            else
+            {
+                assert(got && atoi(got + 1) == shadow.values[id]);
+                shadow_touch(&shadow, pos);
+            }
+        }
+        else
+        {
+            capacity = 1 + (int)(stress_rand() % 128);
+            lru_cache_resize_cache(cache, capacity);
+            if (shadow.size > capacity)
+            {
+                shadow.size = capacity;
+            }
+        }
+
+        if (op % STRESS_CHECK_INTERVAL == 0)
+        {
+            check_consistency(cache, &shadow);
+        }
+    }
+
+    check_consistency(cache, &shadow);
+    lru_cache_free(cache);
+    printf("Test Passed: Random Operations Keep Structures Consistent\n");
+}
+
+// Test: Index growth and shrinking move a bounded number of slots per operation
+// while every cached key stays reachable
+void test_incremental_index_rehash()
+{
+    int count = 20000;
+    LRUCache *cache = lru_cache_create(count);
+    assert(cache);
+
+    char key[32];
+    int rebuilds = 0;
+    for (int i = 0; i < count; i++)
+    {
+        hash_index_table_t *older = cache->index.older;
+        size_t cursor = cache->index.rehash_cursor;
+        size_t capacity = hash_index_capacity(&cache->index);
+
+        snprintf(key, sizeof(key), "k%d", i);
+        lru_cache_set(cache, key, "value");
+
+        // One insert moves at most HASH_INDEX_REHASH_GROUPS groups of a running rebuild
+        if (older && cache->index.older == older)
+        {
+            assert(cache->index.rehash_cursor - cursor <= HASH_INDEX_REHASH_GROUPS * HASH_INDEX_GROUP_WIDTH *
+                                                              cache->index.rehash_pace);
+            assert(cache->index.rehash_pace == 1);
+        }
+        rebuilds += hash_index_capacity(&cache->index) != capacity;
+
+        if (i % 997 == 0)
+        {
+            for (int j = 0; j <= i; j += 7)
+            {
+                snprintf(key, sizeof(key), "k%d", j);
+                assert(lru_cache_get(cache, key));
+            }
+        }
+    }
+    assert(rebuilds >= 10);
+
+    // Shrinking starts a rebuild instead of finishing it in the call; gets carry it on
+    for (int i = count - 100; i < count; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        assert(lru_cache_get(cache, key));
+    }
+    lru_cache_resize_cache(cache, 100);
+    assert(cache->index.older);
+    for (int i = count - 100; cache->index.older; i = i + 1 < count ? i + 1 : count - 100)
+    {
+        snprintf(key, sizeof(key), "k%d", i);
+        assert(lru_cache_get(cache, key));
+    }
+    assert(hash_index_capacity(&cache->index) < 1024);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Incremental Index Rehash\n");
+}
+
+void run_test_lru_cache_stress()
+{
+    printf("Running Stress tests for LRU Cache...\n");
+    test_random_operations_keep_structures_consistent();
+    test_incremental_index_rehash();
+    printf("Stress tests passed!\n");
+}
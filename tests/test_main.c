@@ -3,6 +3,18 @@
 // Declare functions from other test files
 void run_test_lru_cache_basics();
 void run_test_lru_cache_stats();
+void run_test_lru_cache_stress();
+void run_test_slab_allocator();
+void run_test_lru_cache_memory();
+void run_test_sharded_lru();
+void run_test_lru_cache_policy();
+void run_test_lru_cache_expiry();
+void run_test_lru_cache_handles();
+void run_test_lru_cache_snapshot();
+void run_test_shm_cache();
+void run_test_miss_ratio_curve();
+void run_test_lru_cache_instrument();
+void run_test_lru_cache_listener();
 
 int main()
 {
@@ -12,6 +24,42 @@ int main()
     printf("\nRunning stats tests...\n");
     run_test_lru_cache_stats();
 
+    printf("\nRunning stress tests...\n");
+    run_test_lru_cache_stress();
+
+    printf("\nRunning slab allocator tests...\n");
+    run_test_slab_allocator();
+
+    printf("\nRunning memory limit tests...\n");
+    run_test_lru_cache_memory();
+
+    printf("\nRunning sharded cache tests...\n");
+    run_test_sharded_lru();
+
+    printf("\nRunning eviction policy tests...\n");
+    run_test_lru_cache_policy();
+
+    printf("\nRunning expiry tests...\n");
+    run_test_lru_cache_expiry();
+
+    printf("\nRunning handle tests...\n");
+    run_test_lru_cache_handles();
+
+    printf("\nRunning snapshot tests...\n");
+    run_test_lru_cache_snapshot();
+
+    printf("\nRunning shared memory cache tests...\n");
+    run_test_shm_cache();
+
+    printf("\nRunning miss ratio curve tests...\n");
+    run_test_miss_ratio_curve();
+
+    printf("\nRunning instrumentation tests...\n");
+    run_test_lru_cache_instrument();
+
+    printf("\nRunning eviction listener tests...\n");
+    run_test_lru_cache_listener();
+
     printf("\nAll tests completed.\n");
     return 0;
 }
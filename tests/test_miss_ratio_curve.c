@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "lru_cache.h"
+#include "miss_ratio_curve.h"
+
+#define MRC_TRACE_LENGTH 200000
+#define MRC_KEY_SPACE 20000
+
+static unsigned int next_random(unsigned int *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// Key numbers with a cubic skew towards the low ones
+static void make_skewed_trace(int *trace, int length, int key_space, unsigned int seed)
+{
+    unsigned long long range = (unsigned long long)key_space;
+    for (int i = 0; i < length; i++)
+    {
+        unsigned long long u = next_random(&seed) % range;
+        trace[i] = (int)(u * u * u / (range * range));
+    }
+}
+
+static double distance(double a, double b)
+{
+    return a > b ? a - b : b - a;
+}
+
+static uint64_t key_hash(int key)
+{
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "key%d", key);
+    return wyhash64(buf, (size_t)len, 0);
+}
+
+// Test: Without sampling the curve matches an LRU cache exactly at every size
+void test_mrc_matches_lru_cache()
+{
+    int *trace = malloc(MRC_TRACE_LENGTH * sizeof(int));
+    make_skewed_trace(trace, MRC_TRACE_LENGTH, MRC_KEY_SPACE, 2463534242u);
+
+    mrc_t mrc;
+    assert(mrc_init(&mrc, 1.0));
+    for (int i = 0; i < MRC_TRACE_LENGTH; i++)
+    {
+        assert(mrc_access(&mrc, key_hash(trace[i])));
+    }
+
+    int capacities[] = {1, 10, 100, 1000, 5000, MRC_KEY_SPACE};
+    for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++)
+    {
+        LRUCache *cache = lru_cache_create(capacities[c]);
+        char key[32];
+        int misses = 0;
+        for (int i = 0; i < MRC_TRACE_LENGTH; i++)
+        {
+            snprintf(key, sizeof(key), "key%d", trace[i]);
+            if (!lru_cache_get(cache, key))
+            {
+                misses++;
+                lru_cache_set(cache, key, "v");
+            }
+        }
+        lru_cache_free(cache);
+
+        double expected = (double)misses / MRC_TRACE_LENGTH;
+        assert(distance(mrc_miss_ratio(&mrc, (size_t)capacities[c]), expected) < 1e-9);
+    }
+
+    assert(mrc_miss_ratio(&mrc, 0) == 1.0);
+    assert(mrc_unique_keys(&mrc) == mrc.cold);
+
+    mrc_destroy(&mrc);
+    free(trace);
+    printf("Test Passed: MRC Matches LRU Cache\n");
+}
+
+// Test: A sampled curve stays close to the exact one
+void test_mrc_sampled_accuracy()
+{
+    int length = 1000000;
+    int key_space = 200000;
+    int *trace = malloc((size_t)length * sizeof(int));
+    make_skewed_trace(trace, length, key_space, 88172645u);
+
+    mrc_t exact, sampled;
+    assert(mrc_init(&exact, 1.0));
+    assert(mrc_init(&sampled, 0.05));
+    for (int i = 0; i < length; i++)
+    {
+        uint64_t hash = key_hash(trace[i]);
+        assert(mrc_access(&exact, hash));
+        assert(mrc_access(&sampled, hash));
+    }
+
+    assert(sampled.sampled < exact.sampled / 10);
+    for (size_t capacity = 1000; capacity <= 128000; capacity *= 2)
+    {
+        double error = distance(mrc_miss_ratio(&sampled, capacity), mrc_miss_ratio(&exact, capacity));
+        assert(error < 0.02);
+    }
+
+    double unique = (double)mrc_unique_keys(&sampled);
+    assert(distance(unique, (double)exact.live) < 0.1 * (double)exact.live);
+
+    mrc_destroy(&exact);
+    mrc_destroy(&sampled);
+    free(trace);
+    printf("Test Passed: MRC Sampled Accuracy\n");
+}
+
+// Test: A long trace over few keys renumbers access times instead of
+// growing, and keeps every distance right
+void test_mrc_compacts_times()
+{
+    mrc_t mrc;
+    assert(mrc_init(&mrc, 1.0));
+    for (int i = 0; i < 100000; i++)
+    {
+        assert(mrc_access(&mrc, key_hash(i % 10)));
+    }
+
+    assert(mrc.time_capacity == 1024);
+    assert(mrc.distances[10] == 100000 - 10);
+    assert(mrc_miss_ratio(&mrc, 9) == 1.0);
+    assert(distance(mrc_miss_ratio(&mrc, 10), 10.0 / 100000) < 1e-12);
+
+    mrc_destroy(&mrc);
+    printf("Test Passed: MRC Compacts Times\n");
+}
+
+// Test: Sample rates outside (0, 1] are refused
+void test_mrc_rejects_bad_rates()
+{
+    mrc_t mrc;
+    assert(!mrc_init(&mrc, 0));
+    assert(!mrc_init(&mrc, -0.5));
+    assert(!mrc_init(&mrc, 1.5));
+    assert(mrc_init(&mrc, 1e-9));
+    assert(mrc.threshold == 1);
+    mrc_destroy(&mrc);
+    printf("Test Passed: MRC Rejects Bad Rates\n");
+}
+
+void run_test_miss_ratio_curve()
+{
+    test_mrc_matches_lru_cache();
+    test_mrc_sampled_accuracy();
+    test_mrc_compacts_times();
+    test_mrc_rejects_bad_rates();
+}
@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "sharded_lru.h"
+
+#define THREAD_COUNT 4
+#define THREAD_OPERATIONS 50000
+
+// Test: Shard count rounds up to a power of two and keys round-trip
+void test_sharded_set_and_get()
+{
+    ShardedLRUCache *cache = sharded_lru_create(5, 800);
+    assert(cache);
+    assert(cache->shard_count == 8);
+    assert(cache->shards[0].cache->capacity == 100);
+
+    char key[32], value[32], buf[64];
+    for (int i = 0; i < 400; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        snprintf(value, sizeof(value), "value%d", i);
+        sharded_lru_set(cache, key, value);
+    }
+    for (int i = 0; i < 400; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        snprintf(value, sizeof(value), "value%d", i);
+        assert(sharded_lru_get(cache, key, buf, sizeof(buf)) == (long)strlen(value));
+        assert(strcmp(buf, value) == 0);
+    }
+    assert(sharded_lru_get(cache, "missing", buf, sizeof(buf)) == -1);
+
+    // Keys spread over more than one shard
+    int used_shards = 0;
+    for (int i = 0; i < cache->shard_count; i++)
+    {
+        used_shards += cache->shards[i].cache->size > 0;
+    }
+    assert(used_shards > 1);
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Set and Get\n");
+}
+
+// Test: Binary keys and values are routed and copied by length
+void test_sharded_binary_values()
+{
+    ShardedLRUCache *cache = sharded_lru_create(4, 64);
+    assert(cache);
+
+    char key[] = {'i', 'd', '\0', '7'};
+    char value[] = {'a', '\0', 'b', '\0'};
+    char buf[8];
+
+    sharded_lru_set_bin(cache, key, sizeof(key), value, sizeof(value), DEFAULT_EXPIRATION_MS);
+    assert(sharded_lru_get_bin(cache, key, sizeof(key), buf, sizeof(buf)) == (long)sizeof(value));
+    assert(memcmp(buf, value, sizeof(value)) == 0);
+    assert(sharded_lru_get(cache, "id", buf, sizeof(buf)) == -1);
+
+    sharded_lru_set_bin(cache, key, sizeof(key), value, KV_PAIR_MAX_LEN + 1, DEFAULT_EXPIRATION_MS);
+    assert(sharded_lru_get_bin(cache, key, sizeof(key), buf, sizeof(buf)) == (long)sizeof(value));
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Binary Values\n");
+}
+
+// Test: Values longer than the caller's buffer are truncated but report their length
+void test_sharded_get_truncates()
+{
+    ShardedLRUCache *cache = sharded_lru_create(2, 10);
+    assert(cache);
+
+    char buf[4];
+    sharded_lru_set(cache, "key", "abcdefgh");
+    assert(sharded_lru_get(cache, "key", buf, sizeof(buf)) == 8);
+    assert(strcmp(buf, "abc") == 0);
+    assert(sharded_lru_get(cache, "key", NULL, 0) == 8);
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Get Truncates\n");
+}
+
+// Test: Statistics are summed across shards
+void test_sharded_stats_aggregate()
+{
+    ShardedLRUCache *cache = sharded_lru_create(4, 100);
+    assert(cache);
+
+    char key[32], buf[32];
+    for (int i = 0; i < 20; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        sharded_lru_set(cache, key, "value");
+    }
+    sharded_lru_reset_stats(cache);
+
+    for (int i = 0; i < 30; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        sharded_lru_get(cache, key, buf, sizeof(buf));
+    }
+
+    sharded_lru_stats_t stats;
+    sharded_lru_get_stats(cache, &stats);
+    assert(stats.hits == 20);
+    assert(stats.misses == 10);
+    assert(stats.size == 20);
+    sharded_lru_print_stats(cache);
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Stats Aggregate\n");
+}
+
+typedef struct
+{
+    ShardedLRUCache *cache;
+    int seed;
+} worker_args_t;
+
+// Mixes sets and gets; every value encodes its key so torn reads are detectable
+static void *sharded_worker(void *arg)
+{
+    worker_args_t *args = arg;
+    unsigned int state = (unsigned int)args->seed * 2654435761u + 1;
+    char key[32], value[32], expected[32], buf[32];
+
+    for (int i = 0; i < THREAD_OPERATIONS; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        int id = (int)((state >> 8) % 2000);
+        snprintf(key, sizeof(key), "key%d", id);
+        snprintf(expected, sizeof(expected), "value%d", id);
+
+        if ((state >> 4) % 4 == 0)
+        {
+            snprintf(value, sizeof(value), "value%d", id);
+            sharded_lru_set(args->cache, key, value);
+        }
+        else if (sharded_lru_get(args->cache, key, buf, sizeof(buf)) >= 0)
+        {
+            assert(strcmp(buf, expected) == 0);
+        }
+    }
+
+    return NULL;
+}
+
+typedef struct
+{
+    ShardedLRUCache *cache;
+    int stop;
+} stats_poller_t;
+
+// Reads the statistics while the workers run; the lookup and set totals
+// may only grow
+static void *stats_poller(void *arg)
+{
+    stats_poller_t *poller = arg;
+    uint64_t lookups = 0, sets = 0;
+
+    while (!__atomic_load_n(&poller->stop, __ATOMIC_RELAXED))
+    {
+        sharded_lru_stats_t stats;
+        sharded_lru_get_stats(poller->cache, &stats);
+        assert(stats.hits + stats.misses >= lookups);
+        assert(stats.inserts + stats.updates >= sets);
+        lookups = stats.hits + stats.misses;
+        sets = stats.inserts + stats.updates;
+    }
+
+    return NULL;
+}
+
+// Runs the workers against a cache alongside a statistics poller, then
+// checks that every operation was counted exactly once
+static void run_workers(ShardedLRUCache *cache)
+{
+    pthread_t threads[THREAD_COUNT], poller_thread;
+    worker_args_t args[THREAD_COUNT];
+    stats_poller_t poller = {cache, 0};
+    assert(pthread_create(&poller_thread, NULL, stats_poller, &poller) == 0);
+
+    for (int i = 0; i < THREAD_COUNT; i++)
+    {
+        args[i] = (worker_args_t){cache, i};
+        assert(pthread_create(&threads[i], NULL, sharded_worker, &args[i]) == 0);
+    }
+    for (int i = 0; i < THREAD_COUNT; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    __atomic_store_n(&poller.stop, 1, __ATOMIC_RELAXED);
+    pthread_join(poller_thread, NULL);
+
+    sharded_lru_stats_t stats;
+    sharded_lru_get_stats(cache, &stats);
+    assert(stats.hits + stats.misses + stats.inserts + stats.updates == (uint64_t)THREAD_COUNT * THREAD_OPERATIONS);
+}
+
+// Test: Concurrent workers never observe another key's value
+void test_sharded_concurrent_access()
+{
+    ShardedLRUCache *cache = sharded_lru_create(8, 1000);
+    assert(cache);
+
+    run_workers(cache);
+
+    sharded_lru_stats_t stats;
+    sharded_lru_get_stats(cache, &stats);
+    assert(stats.size > 0 && stats.size <= 1000);
+    assert(stats.evictions == stats.inserts - stats.size);
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Sharded Concurrent Access\n");
+}
+
+// Test: Lock-free hits are applied to the recency order by maintenance
+void test_lockfree_reads_promote()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 3);
+    ShardedLRUCache *cache = sharded_lru_create_with_flags(1, &config, SHARDED_LRU_LOCKFREE_READS);
+    assert(cache);
+
+    char buf[32];
+    sharded_lru_set(cache, "a", "1");
+    sharded_lru_set(cache, "b", "2");
+    sharded_lru_set(cache, "c", "3");
+
+    // The hit is only recorded; "a" stays least recently used until drained
+    assert(sharded_lru_get(cache, "a", buf, sizeof(buf)) == 1);
+    assert(strcmp(buf, "1") == 0);
+    assert(strcmp(kv_pair_get_key(&cache->shards[0].cache->list.tail->kv_pair), "a") == 0);
+
+    sharded_lru_maintenance(cache);
+    assert(strcmp(kv_pair_get_key(&cache->shards[0].cache->list.head->kv_pair), "a") == 0);
+
+    sharded_lru_set(cache, "d", "4"); // Evicts "b"
+    assert(sharded_lru_get(cache, "b", buf, sizeof(buf)) == -1);
+    assert(sharded_lru_get(cache, "a", buf, sizeof(buf)) == 1);
+
+    // Updates replace the entry rather than writing over it
+    sharded_lru_set(cache, "a", "updated");
+    assert(sharded_lru_get(cache, "a", buf, sizeof(buf)) == 7);
+    assert(strcmp(buf, "updated") == 0);
+
+    sharded_lru_stats_t stats;
+    sharded_lru_get_stats(cache, &stats);
+    assert(stats.hits == 3);   // Lock-free hits only; sets are not lookups
+    assert(stats.misses == 1); // The lookup of "b"
+    assert(stats.inserts == 4 && stats.updates == 1 && stats.evictions == 1);
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Lock-Free Reads Promote\n");
+}
+
+// Test: Lock-free readers racing writers, evictions and index growth never
+// observe another key's value
+void test_lockfree_concurrent_access()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 1000);
+    ShardedLRUCache *cache = sharded_lru_create_with_flags(4, &config, SHARDED_LRU_LOCKFREE_READS);
+    assert(cache);
+
+    run_workers(cache);
+
+    sharded_lru_maintenance(cache);
+
+    sharded_lru_stats_t stats;
+    sharded_lru_get_stats(cache, &stats);
+    assert(stats.size > 0 && stats.size <= 1000);
+    assert(stats.hits > 0);
+
+    sharded_lru_free(cache);
+    printf("Test Passed: Lock-Free Concurrent Access\n");
+}
+
+void run_test_sharded_lru()
+{
+    printf("Running Sharded LRU tests...\n");
+    test_sharded_set_and_get();
+    test_sharded_get_truncates();
+    test_sharded_binary_values();
+    test_sharded_stats_aggregate();
+    test_sharded_concurrent_access();
+    test_lockfree_reads_promote();
+    test_lockfree_concurrent_access();
+    printf("Sharded LRU tests passed!\n");
+}
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "shm_cache.h"
+
+#define SHM_PROCESSES 4
+#define SHM_OPERATIONS 20000
+
+// Builds a path for a region file in the temporary directory
+static void region_path(char *path, size_t size, const char *name)
+{
+    snprintf(path, size, "/tmp/shm_cache_%d_%s", (int)getpid(), name);
+}
+
+// Opens a fresh region, removing any left by an earlier run
+static shm_cache_t *open_fresh(const char *path, uint32_t capacity)
+{
+    unlink(path);
+    shm_cache_config_t config;
+    shm_cache_config_init(&config, capacity);
+    return shm_cache_open(path, &config);
+}
+
+// Test: Set, get, update, delete and LRU eviction within one process
+void test_shm_basics()
+{
+    char path[128];
+    region_path(path, sizeof(path), "basics");
+    shm_cache_t *cache = open_fresh(path, 3);
+    assert(cache);
+
+    char buf[64];
+    assert(shm_cache_set(cache, "a", 1, "1", 1, 60000));
+    assert(shm_cache_set(cache, "b", 1, "2", 1, 60000));
+    assert(shm_cache_set(cache, "c", 1, "3", 1, 60000));
+    assert(shm_cache_get(cache, "a", 1, buf, sizeof(buf)) == 1 && strcmp(buf, "1") == 0);
+
+    // "b" is now least recently used
+    assert(shm_cache_set(cache, "d", 1, "4", 1, 60000));
+    assert(shm_cache_get(cache, "b", 1, buf, sizeof(buf)) == -1);
+
+    // Updates replace the value without growing the cache
+    assert(shm_cache_set(cache, "a", 1, "updated", 7, 60000));
+    assert(shm_cache_get(cache, "a", 1, buf, sizeof(buf)) == 7 && strcmp(buf, "updated") == 0);
+
+    // Binary keys and values are kept by length
+    char key[] = {'k', '\0', 'x'};
+    char value[] = {'\0', 'v'};
+    assert(shm_cache_set(cache, key, sizeof(key), value, sizeof(value), 60000));
+    assert(shm_cache_get(cache, key, sizeof(key), buf, sizeof(buf)) == 2 && memcmp(buf, value, 2) == 0);
+    assert(shm_cache_get(cache, "k", 1, buf, sizeof(buf)) == -1);
+
+    assert(shm_cache_delete(cache, "a", 1));
+    assert(!shm_cache_delete(cache, "a", 1));
+
+    // Entries larger than a slot are refused
+    char large[SHM_CACHE_DEFAULT_SLOT_SIZE + 1];
+    memset(large, 'x', sizeof(large));
+    assert(!shm_cache_set(cache, "large", 5, large, sizeof(large), 60000));
+
+    shm_cache_stats_t stats;
+    shm_cache_get_stats(cache, &stats);
+    assert(stats.capacity == 3);
+    assert(stats.size == 2);
+    assert(stats.evictions == 2);
+    assert(stats.hits == 3 && stats.misses == 2);
+
+    shm_cache_close(cache);
+    unlink(path);
+    printf("Test Passed: Shm Basics\n");
+}
+
+// Test: Entries expire by wall-clock time
+void test_shm_expiry()
+{
+    char path[128];
+    region_path(path, sizeof(path), "expiry");
+    shm_cache_t *cache = open_fresh(path, 4);
+    assert(cache);
+
+    assert(shm_cache_set(cache, "short", 5, "1", 1, 5));
+    assert(shm_cache_set(cache, "long", 4, "2", 1, 60000));
+    struct timespec pause = {0, 20 * 1000 * 1000};
+    nanosleep(&pause, NULL);
+
+    assert(shm_cache_get(cache, "short", 5, NULL, 0) == -1);
+    assert(shm_cache_get(cache, "long", 4, NULL, 0) == 1);
+
+    shm_cache_close(cache);
+    unlink(path);
+    printf("Test Passed: Shm Expiry\n");
+}
+
+// Test: A region reopened later keeps its entries, order and geometry
+void test_shm_reattach()
+{
+    char path[128];
+    region_path(path, sizeof(path), "reattach");
+    shm_cache_t *cache = open_fresh(path, 100);
+    assert(cache);
+
+    char key[32], value[32], buf[64];
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        snprintf(value, sizeof(value), "value%d", i);
+        assert(shm_cache_set(cache, key, strlen(key), value, strlen(value), 60000));
+    }
+    shm_cache_close(cache);
+
+    // The config is ignored for an existing region
+    shm_cache_config_t config;
+    shm_cache_config_init(&config, 5);
+    cache = shm_cache_open(path, &config);
+    assert(cache);
+    assert(cache->header->capacity == 100 && cache->header->size == 100);
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        snprintf(value, sizeof(value), "value%d", i);
+        assert(shm_cache_get(cache, key, strlen(key), buf, sizeof(buf)) == (long)strlen(value));
+        assert(strcmp(buf, value) == 0);
+    }
+
+    // Opening without a config attaches too, but cannot create
+    shm_cache_t *second = shm_cache_open(path, NULL);
+    assert(second);
+    assert(shm_cache_get(second, "key0", 4, buf, sizeof(buf)) == 6);
+    shm_cache_close(second);
+
+    shm_cache_close(cache);
+    unlink(path);
+    assert(shm_cache_open(path, NULL) == NULL);
+    unlink(path);
+    printf("Test Passed: Shm Reattach\n");
+}
+
+// Test: A process that dies holding the lock mid-update leaves a region the
+// next locker repairs from the slots, keeping every entry and its recency
+void test_shm_recovers_from_dead_holder()
+{
+    char path[128];
+    region_path(path, sizeof(path), "recover");
+    shm_cache_t *cache = open_fresh(path, 8);
+    assert(cache);
+
+    char key[32];
+    for (int i = 0; i < 8; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        assert(shm_cache_set(cache, key, strlen(key), "value", 5, 60000));
+    }
+    assert(shm_cache_get(cache, "key0", 4, NULL, 0) == 5); // key1 is now least recent
+
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0)
+    {
+        // Take the lock, scramble the links and die without unlocking
+        pthread_mutex_lock(&cache->header->lock);
+        cache->header->head = 3;
+        cache->header->tail = 3;
+        memset(cache->buckets, 0xff, cache->header->bucket_count * sizeof(uint32_t));
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+
+    shm_cache_stats_t stats;
+    shm_cache_get_stats(cache, &stats);
+    assert(stats.recoveries == 1);
+    assert(stats.size == 8);
+
+    // Recency came back from the stamps, so key1 is still the one evicted
+    assert(shm_cache_set(cache, "new", 3, "value", 5, 60000));
+    assert(shm_cache_get(cache, "key1", 4, NULL, 0) == -1);
+    for (int i = 0; i < 8; i++)
+    {
+        if (i != 1)
+        {
+            snprintf(key, sizeof(key), "key%d", i);
+            assert(shm_cache_get(cache, key, strlen(key), NULL, 0) == 5);
+        }
+    }
+
+    shm_cache_close(cache);
+    unlink(path);
+    printf("Test Passed: Shm Recovers From Dead Holder\n");
+}
+
+// Churns a shared keyspace, checking that every value read matches its key
+static void shm_worker(const char *path, int id)
+{
+    shm_cache_t *cache = shm_cache_open(path, NULL);
+    if (!cache)
+    {
+        _exit(1);
+    }
+
+    char key[32], value[64], buf[64];
+    unsigned int state = 12345u + (unsigned int)id;
+    for (int i = 0; i < SHM_OPERATIONS; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        int k = (int)((state >> 8) % 512);
+        snprintf(key, sizeof(key), "key%d", k);
+
+        if ((state >> 20) % 4 == 0)
+        {
+            snprintf(value, sizeof(value), "%s:%d", key, id);
+            shm_cache_set(cache, key, strlen(key), value, strlen(value), 60000);
+        }
+        else if (shm_cache_get(cache, key, strlen(key), buf, sizeof(buf)) >= 0)
+        {
+            size_t key_len = strlen(key);
+            if (strncmp(buf, key, key_len) != 0 || buf[key_len] != ':')
+            {
+                _exit(2);
+            }
+        }
+    }
+
+    shm_cache_close(cache);
+    _exit(0);
+}
+
+// Reads the back link of a slot
+static uint32_t entry_prev_of(shm_cache_t *cache, uint32_t slot)
+{
+    return ((shm_entry_t *)(cache->slots + (size_t)slot * cache->header->slot_stride))->prev;
+}
+
+// Test: Several processes share one region concurrently
+void test_shm_multi_process()
+{
+    char path[128];
+    region_path(path, sizeof(path), "multi");
+    shm_cache_t *cache = open_fresh(path, 256);
+    assert(cache);
+
+    pid_t children[SHM_PROCESSES];
+    for (int i = 0; i < SHM_PROCESSES; i++)
+    {
+        children[i] = fork();
+        assert(children[i] >= 0);
+        if (children[i] == 0)
+        {
+            shm_worker(path, i);
+        }
+    }
+
+    for (int i = 0; i < SHM_PROCESSES; i++)
+    {
+        int status;
+        waitpid(children[i], &status, 0);
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    // The list and index agree after the churn
+    shm_cache_header_t *header = cache->header;
+    uint32_t count = 0;
+    for (uint32_t slot = header->head; slot != SHM_CACHE_NIL; count++)
+    {
+        shm_entry_t *entry = (shm_entry_t *)(cache->slots + (size_t)slot * header->slot_stride);
+        assert(entry->state == SHM_ENTRY_LIVE);
+        assert(entry->next == SHM_CACHE_NIL || entry_prev_of(cache, entry->next) == slot);
+        slot = entry->next;
+    }
+    assert(count == header->size && count == 256);
+
+    shm_cache_close(cache);
+    unlink(path);
+    printf("Test Passed: Shm Multi Process\n");
+}
+
+void run_test_shm_cache()
+{
+    test_shm_basics();
+    test_shm_expiry();
+    test_shm_reattach();
+    test_shm_recovers_from_dead_holder();
+    test_shm_multi_process();
+}
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "lru_cache.h"
+#include "slab_allocator.h"
+
+// Test: Classes grow monotonically and requests map to the smallest fitting class
+void test_slab_class_selection()
+{
+    slab_allocator_t slabs;
+    assert(slab_init(&slabs, 0, 0, 0));
+
+    for (int i = 1; i < slabs.class_count; i++)
+    {
+        assert(slabs.classes[i].chunk_size > slabs.classes[i - 1].chunk_size);
+    }
+    assert(slabs.classes[slabs.class_count - 1].chunk_size == SLAB_DEFAULT_PAGE_SIZE);
+
+    assert(slab_class_for(&slabs, 1) == 0);
+    assert(slab_class_for(&slabs, SLAB_MIN_CHUNK_SIZE) == 0);
+    assert(slab_class_for(&slabs, SLAB_MIN_CHUNK_SIZE + 1) == 1);
+    assert(slab_class_for(&slabs, SLAB_DEFAULT_PAGE_SIZE + 1) == -1);
+    assert(slab_chunk_size(&slabs, 100) >= 100);
+
+    slab_destroy(&slabs);
+    printf("Test Passed: Slab Class Selection\n");
+}
+
+// Test: Freed chunks are handed back out before new ones are carved
+void test_slab_free_list_reuse()
+{
+    slab_allocator_t slabs;
+    assert(slab_init(&slabs, 4096, 0, 0));
+
+    void *a = slab_alloc(&slabs, 100);
+    void *b = slab_alloc(&slabs, 100);
+    assert(a && b && a != b);
+
+    int id = slab_class_for(&slabs, 100);
+    assert(slabs.classes[id].used_chunks == 2);
+    assert(slabs.classes[id].pages == 1);
+
+    slab_free(&slabs, a, 100);
+    assert(slab_alloc(&slabs, 100) == a);
+
+    slab_free(&slabs, a, 100);
+    slab_free(&slabs, b, 100);
+    assert(slabs.classes[id].used_chunks == 0);
+
+    slab_destroy(&slabs);
+    printf("Test Passed: Slab Free List Reuse\n");
+}
+
+// Test: Allocation fails once the memory limit is exhausted, and large requests count too
+void test_slab_memory_limit()
+{
+    slab_allocator_t slabs;
+    assert(slab_init(&slabs, 4096, 8192, 0));
+
+    // Two pages of 4096-byte chunks, then nothing
+    assert(slab_alloc(&slabs, 4096));
+    assert(slab_alloc(&slabs, 4096));
+    assert(slab_alloc(&slabs, 4096) == NULL);
+    assert(slab_alloc(&slabs, 10000) == NULL);
+    assert(slabs.memory_allocated == 8192);
+
+    slab_destroy(&slabs);
+
+    // Oversized requests bypass the classes but are still accounted for
+    assert(slab_init(&slabs, 4096, 0, 0));
+    void *large = slab_alloc(&slabs, 10000);
+    assert(large);
+    assert(slabs.large_count == 1 && slabs.memory_allocated >= 10000);
+    slab_free(&slabs, large, 10000);
+    assert(slabs.large_count == 0 && slabs.memory_allocated == 0);
+
+    slab_destroy(&slabs);
+    printf("Test Passed: Slab Memory Limit\n");
+}
+
+// Test: Preallocated pages are used before the limit is reached
+void test_slab_preallocation()
+{
+    slab_allocator_t slabs;
+    assert(slab_init(&slabs, 4096, 4 * 4096, 1));
+    assert(slabs.prealloc_base && slabs.prealloc_pages == 4);
+
+    char *first = slab_alloc(&slabs, 64);
+    assert(first >= slabs.prealloc_base && first < slabs.prealloc_base + 4 * 4096);
+    assert(slabs.page_count == 0);
+
+    slab_destroy(&slabs);
+    printf("Test Passed: Slab Preallocation\n");
+}
+
+// Test: A memory-limited cache evicts to make room instead of failing inserts
+void test_cache_evicts_under_slab_limit()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 100000);
+    config.slab_page_size = 4096;
+    config.slab_memory_limit = 4 * 4096;
+
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+
+    char key[32];
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+        assert(strcmp(lru_cache_get(cache, key), "value") == 0);
+    }
+
+    assert(cache->size > 0 && cache->size < 5000);
+    assert(cache->slabs.memory_allocated <= 4 * 4096);
+    assert(lru_cache_get(cache, "key0") == NULL);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Cache Evicts Under Slab Limit\n");
+}
+
+// Test: Steady-state churn recycles evicted entries instead of growing the slabs
+void test_cache_recycles_evicted_entries()
+{
+    LRUCache *cache = lru_cache_create(64);
+    assert(cache);
+
+    char key[32];
+    for (int i = 0; i < 64; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+
+    size_t allocated = cache->slabs.memory_allocated;
+    int id = slab_class_for(&cache->slabs, node_size_for(5, 5));
+    size_t used = cache->slabs.classes[id].used_chunks;
+
+    for (int i = 64; i < 10000; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+
+    assert(cache->slabs.memory_allocated == allocated);
+    assert(cache->slabs.classes[id].used_chunks == used);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Cache Recycles Evicted Entries\n");
+}
+
+// Test: An insert needing a size class that owns no memory under a full
+// limit takes a page from another class instead of emptying the cache
+void test_cache_reassigns_slab_pages()
+{
+    lru_cache_config_t config;
+    lru_cache_config_init(&config, 100000);
+    config.slab_page_size = 64 * 1024;
+    config.slab_memory_limit = 256 * 1024;
+
+    LRUCache *cache = lru_cache_create_with_config(&config);
+    assert(cache);
+
+    char key[32];
+    for (int i = 0; i < 20000; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        lru_cache_set(cache, key, "value");
+    }
+    int before = cache->size;
+    int small = slab_class_for(&cache->slabs, node_size_for(strlen(key), 5));
+    assert(cache->slabs.classes[small].pages == 4);
+
+    char large[2001];
+    memset(large, 'x', 2000);
+    large[2000] = '\0';
+    lru_cache_set(cache, "large", large);
+
+    // Only the entries on the page handed over were evicted
+    int id = slab_class_for(&cache->slabs, node_size_for(5, 2000));
+    assert(lru_cache_get(cache, "large") && strlen(lru_cache_get(cache, "large")) == 2000);
+    assert(cache->slabs.classes[id].pages == 1 && cache->slabs.classes[small].pages == 3);
+    assert(cache->size >= before - before / 4 && cache->size < before);
+    assert(lru_cache_get(cache, key));
+    assert(cache->slabs.memory_allocated <= 256 * 1024);
+
+    // Both classes keep working within their pages afterwards
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(key, sizeof(key), "more%d", i);
+        lru_cache_set(cache, key, i % 2 ? "value" : large);
+        assert(lru_cache_get(cache, key));
+    }
+    assert(cache->slabs.memory_allocated <= 256 * 1024);
+
+    lru_cache_free(cache);
+    printf("Test Passed: Cache Reassigns Slab Pages\n");
+}
+
+void run_test_slab_allocator()
+{
+    printf("Running Slab Allocator tests...\n");
+    test_slab_class_selection();
+    test_slab_free_list_reuse();
+    test_slab_memory_limit();
+    test_slab_preallocation();
+    test_cache_evicts_under_slab_limit();
+    test_cache_recycles_evicted_entries();
+    test_cache_reassigns_slab_pages();
+    printf("Slab allocator tests passed!\n");
+}
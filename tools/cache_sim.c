@@ -0,0 +1,413 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "lru_cache.h"
+#include "miss_ratio_curve.h"
+
+// Replays a key trace against an LRUCache to size the cache and choose a
+// policy offline. Every request is a cache-aside read: a miss is followed
+// by a set with a placeholder value. Hit ratio and memory are reported at
+// intervals and at the end. With -s, the same pass also builds an LRU
+// miss-ratio curve for every capacity, sampled with SHARDS at the given
+// rate, so one run answers "how big should the cache be".
+//
+// Traces are read from a file or stdin, either as text with one key per
+// line or as binary little-endian 64-bit key ids.
+
+#define SIM_DEFAULT_CAPACITY 100000
+#define SIM_DEFAULT_VALUE_SIZE 64
+#define SIM_DEFAULT_INTERVAL 1000000
+#define SIM_DEFAULT_POINTS 16
+#define SIM_LINE_MAX 4096
+#define SIM_BINARY_BATCH 4096
+#define SIM_MRC_SEED 0x5348415244530000ULL // Fixed, so sampled key sets repeat between runs
+
+typedef enum
+{
+    FORMAT_TEXT,
+    FORMAT_BINARY
+} trace_format_t;
+
+typedef struct
+{
+    trace_format_t format;
+    int capacity;
+    size_t memory_limit;
+    lru_policy_t policy;
+    size_t value_size;
+    uint64_t interval;
+    double sample_rate; // 0 when no curve is wanted
+    int points;
+    size_t *sizes; // Capacities to report the curve at, or NULL for an even log spread
+    int size_count;
+} sim_options_t;
+
+typedef struct
+{
+    LRUCache *cache;
+    mrc_t mrc;
+    int use_mrc;
+    char *value;
+    size_t value_size;
+    uint64_t requests;
+    uint64_t hits;
+    uint64_t window_requests;
+    uint64_t window_hits;
+} sim_t;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options] [trace | -]\n"
+            "  -f text|binary  trace format: one key per line, or 64-bit little-endian ids (default text)\n"
+            "  -c ENTRIES      cache capacity in entries (default %d); 0 with no -m skips the replay\n"
+            "  -m BYTES        byte budget for keys, values and overhead\n"
+            "  -p POLICY       lru, clock, clock-pro, tinylfu or arc (default lru)\n"
+            "  -v BYTES        size of the value stored on each miss (default %d)\n"
+            "  -i REQUESTS     report hit ratio and memory every this many requests (default %d)\n"
+            "  -s RATE         also build an LRU miss-ratio curve, sampling this share of keys (1 = exact)\n"
+            "  -n POINTS       capacities on the curve, spread evenly on a log scale (default %d)\n"
+            "  -S N,N,...      report the curve at exactly these capacities\n",
+            program, SIM_DEFAULT_CAPACITY, SIM_DEFAULT_VALUE_SIZE, SIM_DEFAULT_INTERVAL, SIM_DEFAULT_POINTS);
+}
+
+static int parse_policy(const char *name, lru_policy_t *policy)
+{
+    static const struct
+    {
+        const char *name;
+        lru_policy_t policy;
+    } policies[] = {
+        {"lru", LRU_POLICY_LRU},         {"clock", LRU_POLICY_CLOCK}, {"clock-pro", LRU_POLICY_CLOCK_PRO},
+        {"tinylfu", LRU_POLICY_TINYLFU}, {"arc", LRU_POLICY_ARC},
+    };
+
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++)
+    {
+        if (strcmp(name, policies[i].name) == 0)
+        {
+            *policy = policies[i].policy;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Parses a comma-separated list of capacities
+static int parse_sizes(char *list, sim_options_t *options)
+{
+    int count = 1;
+    for (char *c = list; *c; c++)
+    {
+        count += *c == ',';
+    }
+
+    options->sizes = malloc((size_t)count * sizeof(size_t));
+    if (!options->sizes)
+    {
+        return 0;
+    }
+
+    options->size_count = 0;
+    for (char *token = strtok(list, ","); token; token = strtok(NULL, ","))
+    {
+        char *end;
+        unsigned long long size = strtoull(token, &end, 10);
+        if (*end != '\0' || size == 0)
+        {
+            return 0;
+        }
+        options->sizes[options->size_count++] = (size_t)size;
+    }
+    return options->size_count > 0;
+}
+
+// Total bytes the cache holds: slab pages and large entries, the index's
+// slots and control bytes, and the policy's own structures
+static size_t cache_memory(LRUCache *cache)
+{
+    return cache->slabs.memory_allocated + hash_index_capacity(&cache->index) * LRU_ENTRY_INDEX_OVERHEAD +
+           policy_memory_usage(cache);
+}
+
+// Replays one request
+static void sim_request(sim_t *sim, char *key, size_t key_len)
+{
+    sim->requests++;
+    sim->window_requests++;
+
+    if (sim->use_mrc)
+    {
+        mrc_access(&sim->mrc, wyhash64(key, key_len, SIM_MRC_SEED));
+    }
+
+    if (!sim->cache)
+    {
+        return;
+    }
+
+    uint64_t hash = sim->cache->hash_fn(key, key_len, sim->cache->hash_seed);
+    if (lru_cache_get_hashed(sim->cache, key, key_len, hash, NULL))
+    {
+        sim->hits++;
+        sim->window_hits++;
+    }
+    else
+    {
+        lru_cache_set_hashed(sim->cache, key, key_len, hash, sim->value, sim->value_size, DEFAULT_EXPIRATION_MS);
+    }
+}
+
+static void report_interval(sim_t *sim)
+{
+    if (sim->cache)
+    {
+        printf("%12llu %10.4f %10.4f %10d %14zu\n", (unsigned long long)sim->requests,
+               (double)sim->window_hits / (double)sim->window_requests, (double)sim->hits / (double)sim->requests,
+               sim->cache->size, cache_memory(sim->cache));
+    }
+    else
+    {
+        printf("%12llu %10s %10s %10zu\n", (unsigned long long)sim->requests, "-", "-", mrc_unique_keys(&sim->mrc));
+    }
+    sim->window_requests = 0;
+    sim->window_hits = 0;
+}
+
+// Feeds every key of the trace to the simulation
+static int replay(FILE *trace, const sim_options_t *options, sim_t *sim)
+{
+    if (options->format == FORMAT_TEXT)
+    {
+        char line[SIM_LINE_MAX];
+        while (fgets(line, sizeof(line), trace))
+        {
+            size_t len = strcspn(line, "\r\n");
+            if (len == 0)
+            {
+                continue;
+            }
+            sim_request(sim, line, len);
+            if (sim->requests % options->interval == 0)
+            {
+                report_interval(sim);
+            }
+        }
+    }
+    else
+    {
+        uint64_t ids[SIM_BINARY_BATCH];
+        size_t count;
+        while ((count = fread(ids, sizeof(uint64_t), SIM_BINARY_BATCH, trace)) > 0)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                // The id's bytes are the key; only their identity matters
+                sim_request(sim, (char *)&ids[i], sizeof(uint64_t));
+                if (sim->requests % options->interval == 0)
+                {
+                    report_interval(sim);
+                }
+            }
+        }
+    }
+
+    return !ferror(trace);
+}
+
+// Prints the miss ratio at the requested capacities, or at points spread
+// evenly on a log scale up to the number of distinct keys
+static void print_curve(sim_t *sim, const sim_options_t *options)
+{
+    size_t unique = mrc_unique_keys(&sim->mrc);
+    printf("\nLRU miss-ratio curve (sample rate %g, %zu sampled requests, ~%zu distinct keys)\n",
+           sim->mrc.sample_rate, (size_t)sim->mrc.sampled, unique);
+    printf("%12s %10s\n", "capacity", "miss ratio");
+
+    if (options->sizes)
+    {
+        for (int i = 0; i < options->size_count; i++)
+        {
+            printf("%12zu %10.4f\n", options->sizes[i], mrc_miss_ratio(&sim->mrc, options->sizes[i]));
+        }
+        return;
+    }
+
+    double top = unique > 1 ? (double)unique : 2;
+    size_t previous = 0;
+    for (int i = 0; i < options->points; i++)
+    {
+        double exponent = options->points > 1 ? (double)i / (options->points - 1) : 1;
+        size_t capacity = (size_t)llround(pow(top, exponent));
+        if (capacity == previous)
+        {
+            continue;
+        }
+        previous = capacity;
+        printf("%12zu %10.4f\n", capacity, mrc_miss_ratio(&sim->mrc, capacity));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    sim_options_t options = {
+        .format = FORMAT_TEXT,
+        .capacity = SIM_DEFAULT_CAPACITY,
+        .policy = LRU_POLICY_LRU,
+        .value_size = SIM_DEFAULT_VALUE_SIZE,
+        .interval = SIM_DEFAULT_INTERVAL,
+        .points = SIM_DEFAULT_POINTS,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:c:m:p:v:i:s:n:S:h")) != -1)
+    {
+        int ok = 1;
+        switch (opt)
+        {
+        case 'f':
+            ok = strcmp(optarg, "text") == 0 || strcmp(optarg, "binary") == 0;
+            options.format = strcmp(optarg, "binary") == 0 ? FORMAT_BINARY : FORMAT_TEXT;
+            break;
+        case 'c':
+            options.capacity = atoi(optarg);
+            ok = options.capacity >= 0;
+            break;
+        case 'm':
+            options.memory_limit = (size_t)strtoull(optarg, NULL, 10);
+            break;
+        case 'p':
+            ok = parse_policy(optarg, &options.policy);
+            break;
+        case 'v':
+            options.value_size = (size_t)strtoull(optarg, NULL, 10);
+            break;
+        case 'i':
+            options.interval = strtoull(optarg, NULL, 10);
+            ok = options.interval > 0;
+            break;
+        case 's':
+            options.sample_rate = atof(optarg);
+            ok = options.sample_rate > 0 && options.sample_rate <= 1;
+            break;
+        case 'n':
+            options.points = atoi(optarg);
+            ok = options.points > 0;
+            break;
+        case 'S':
+            ok = parse_sizes(optarg, &options);
+            break;
+        default:
+            ok = 0;
+            break;
+        }
+
+        if (!ok)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    FILE *trace = stdin;
+    if (optind < argc && strcmp(argv[optind], "-") != 0)
+    {
+        trace = fopen(argv[optind], options.format == FORMAT_BINARY ? "rb" : "r");
+        if (!trace)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    sim_t sim = {0};
+    sim.value = calloc(options.value_size + 1, 1);
+    if (!sim.value)
+    {
+        return 1;
+    }
+    memset(sim.value, 'v', options.value_size);
+    sim.value_size = options.value_size;
+
+    if (options.capacity > 0 || options.memory_limit > 0)
+    {
+        lru_cache_config_t config;
+        lru_cache_config_init(&config, options.capacity);
+        config.memory_limit = options.memory_limit;
+        config.policy = options.policy;
+        sim.cache = lru_cache_create_with_config(&config);
+        if (!sim.cache)
+        {
+            fprintf(stderr, "cannot create a cache with these options\n");
+            return 1;
+        }
+    }
+
+    if (options.sample_rate > 0)
+    {
+        if (!mrc_init(&sim.mrc, options.sample_rate))
+        {
+            return 1;
+        }
+        sim.use_mrc = 1;
+    }
+
+    if (sim.cache)
+    {
+        printf("%12s %10s %10s %10s %14s\n", "requests", "window hit", "total hit", "entries", "memory bytes");
+    }
+    else if (sim.use_mrc)
+    {
+        printf("%12s %10s %10s %10s\n", "requests", "", "", "keys (est)");
+    }
+
+    double start = now_ns();
+    int ok = replay(trace, &options, &sim);
+    double elapsed = (now_ns() - start) / 1e9;
+    if (trace != stdin)
+    {
+        fclose(trace);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "error reading the trace\n");
+        return 1;
+    }
+
+    if (sim.window_requests > 0)
+    {
+        report_interval(&sim);
+    }
+    printf("\n%llu requests in %.2f s (%.0f requests/s)\n", (unsigned long long)sim.requests, elapsed,
+           elapsed > 0 ? (double)sim.requests / elapsed : 0);
+    if (sim.cache && sim.requests > 0)
+    {
+        printf("hit ratio %.4f, %d entries, %zu bytes of entries, %zu bytes in total\n",
+               (double)sim.hits / (double)sim.requests, sim.cache->size, sim.cache->bytes_used,
+               cache_memory(sim.cache));
+    }
+
+    if (sim.use_mrc)
+    {
+        print_curve(&sim, &options);
+        mrc_destroy(&sim.mrc);
+    }
+
+    if (sim.cache)
+    {
+        lru_cache_free(sim.cache);
+    }
+    free(sim.value);
+    free(options.sizes);
+    return 0;
+}